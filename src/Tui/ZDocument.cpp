@@ -3,6 +3,13 @@
 #include <Tui/ZDocument.h>
 #include <Tui/ZDocument_p.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <QFileDevice>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QTimer>
 
 #include <Tui/Misc/SurrogateEscape.h>
@@ -63,9 +70,7 @@ void ZDocument::reset() {
     p->lines.clear();
     p->lines.append(LineData());
 
-    for (ZDocumentLineMarkerPrivate *marker = p->lineMarkerList.first; marker; marker = marker->markersList.next) {
-        marker->pub()->setLine(0);
-    }
+    p->lineMarkerIndex.collapse(1, std::numeric_limits<int>::max(), 0);
     for (ZDocumentCursorPrivate *cursor = p->cursorList.first; cursor; cursor = cursor->markersList.next) {
         cursor->pub()->setPosition({0, 0});
     }
@@ -78,28 +83,101 @@ void ZDocument::reset() {
     p->noteContentsChange();
 }
 
-bool ZDocument::writeTo(QIODevice *file, bool crLfMode) const {
-    auto *const p = tuiwidgets_impl();
-    for (int i = 0; i < lineCount(); i++) {
-        const QByteArray converted = Misc::SurrogateEscape::encode(p->lines[i].chars);
-        if (file->write(converted) != converted.size()) {
-            return false;
+namespace {
+    // Encoded data is collected into a buffer of about this size before it is written to the output device.
+    constexpr int writeBufferSize = 1024 * 1024;
+
+    void appendEncoded(QByteArray *buffer, const QString &chars) {
+        const int oldSize = buffer->size();
+        const int size = chars.size();
+        buffer->resize(oldSize + size);
+        char *out = buffer->data() + oldSize;
+        const QChar *in = chars.constData();
+        for (int i = 0; i < size; i++) {
+            const ushort ch = in[i].unicode();
+            if (ch >= 0x80) {
+                // Not pure ASCII, use the general encoder.
+                buffer->resize(oldSize);
+                buffer->append(Misc::SurrogateEscape::encode(chars));
+                return;
+            }
+            out[i] = static_cast<char>(ch);
+        }
+    }
+
+    bool writeLines(const LineStore &lines, bool newlineAfterLastLineMissing, QIODevice *file, bool crLfMode) {
+        QByteArray buffer;
+        buffer.reserve(writeBufferSize + writeBufferSize / 4);
+
+        auto flush = [&] {
+            if (file->write(buffer) != buffer.size()) {
+                return false;
+            }
+            buffer.resize(0);
+            return true;
         };
-        if (i + 1 == lineCount() && p->newlineAfterLastLineMissing) {
-            // omit newline
-        } else {
-            if (crLfMode) {
-                if (file->write("\r\n", 2) != 2) {
-                    return false;
-                }
+
+        for (int i = 0; i < lines.size(); i++) {
+            appendEncoded(&buffer, lines[i].chars);
+            if (i + 1 == lines.size() && newlineAfterLastLineMissing) {
+                // omit newline
             } else {
-                if (file->write("\n", 1) != 1) {
-                    return false;
+                if (crLfMode) {
+                    buffer.append("\r\n", 2);
+                } else {
+                    buffer.append('\n');
                 }
             }
+            if (buffer.size() >= writeBufferSize && !flush()) {
+                return false;
+            }
         }
+        return buffer.isEmpty() || flush();
     }
-    return true;
+
+    class WriteOnThread : public QRunnable {
+    public:
+        void run() override {
+            promise.reportResult(writeLines(ZDocumentSnapshotPrivate::get(&snap)->lines, newlineAfterLastLineMissing,
+                                            file, crLfMode));
+            promise.reportFinished();
+        }
+
+    public:
+        QFutureInterface<bool> promise;
+        ZDocumentSnapshot snap;
+        bool newlineAfterLastLineMissing = false;
+        QIODevice *file = nullptr;
+        bool crLfMode = false;
+    };
+}
+
+bool ZDocument::writeTo(QIODevice *file, bool crLfMode) const {
+    auto *const p = tuiwidgets_impl();
+    return writeLines(p->lines, p->newlineAfterLastLineMissing, file, crLfMode);
+}
+
+QFuture<bool> ZDocument::writeToAsync(QIODevice *file, bool crLfMode) const {
+    return writeToAsyncWithPool(QThreadPool::globalInstance(), 0, file, crLfMode);
+}
+
+QFuture<bool> ZDocument::writeToAsyncWithPool(QThreadPool *pool, int priority, QIODevice *file, bool crLfMode) const {
+    auto *const p = tuiwidgets_impl();
+
+    QFutureInterface<bool> promise;
+    QFuture<bool> future = promise.future();
+    promise.reportStarted();
+
+    WriteOnThread *runnable = new WriteOnThread();
+    runnable->snap = snapshot();
+    runnable->newlineAfterLastLineMissing = p->newlineAfterLastLineMissing;
+    runnable->file = file;
+    runnable->crLfMode = crLfMode;
+    runnable->promise = std::move(promise);
+
+    pool->start(runnable, priority);
+
+    return future;
 }
 
 QString ZDocument::text(bool crLfMode) const {
@@ -121,6 +199,90 @@ QString ZDocument::text(bool crLfMode) const {
 }
 
 
+namespace {
+    // Mapped files larger than this are split into chunks that are decoded in parallel.
+    constexpr qint64 parallelLoadChunkSize = 4 * 1024 * 1024;
+
+    void decodeLines(const char *begin, const char *end, QVector<LineData> *result) {
+        while (begin < end) {
+            const char *newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+            const char *lineEnd = newline ? newline : end;
+            result->append({Misc::SurrogateEscape::decode(begin, lineEnd - begin), 0, nullptr});
+            begin = newline ? newline + 1 : end;
+        }
+    }
+
+    class DecodeChunkTask : public QRunnable {
+    public:
+        DecodeChunkTask(const char *begin, const char *end, QVector<LineData> *result)
+            : begin(begin), end(end), result(result) {
+        }
+
+        void run() override {
+            decodeLines(begin, end, result);
+        }
+
+    private:
+        const char *begin;
+        const char *end;
+        QVector<LineData> *result;
+    };
+
+    // Reads the rest of file via a memory mapping if possible. Returns false if the caller needs to fall back to
+    // reading the file via the QIODevice interface.
+    bool readMappedFile(QIODevice *file, LineStore *lines, bool *newlineAfterLastLineMissing) {
+        QFileDevice *fileDevice = qobject_cast<QFileDevice*>(file);
+        if (!fileDevice || fileDevice->isSequential() || !fileDevice->isReadable()
+                || (fileDevice->openMode() & QIODevice::Text)) {
+            return false;
+        }
+
+        const qint64 start = fileDevice->pos();
+        const qint64 size = fileDevice->size() - start;
+        if (size <= 0 || size > std::numeric_limits<int>::max()) {
+            return false;
+        }
+
+        const char *data = reinterpret_cast<const char*>(fileDevice->map(start, size));
+        if (!data) {
+            return false;
+        }
+        const char *const dataEnd = data + size;
+
+        // Chunk boundaries are placed after line breaks, so that no line is split between chunks.
+        QVector<const char*> boundaries;
+        boundaries.append(data);
+        while (dataEnd - boundaries.last() > parallelLoadChunkSize) {
+            const char *nominalEnd = boundaries.last() + parallelLoadChunkSize;
+            const char *newline = static_cast<const char*>(memchr(nominalEnd, '\n', dataEnd - nominalEnd));
+            if (!newline || newline + 1 == dataEnd) {
+                break;
+            }
+            boundaries.append(newline + 1);
+        }
+        boundaries.append(dataEnd);
+
+        QVector<QVector<LineData>> chunks;
+        chunks.resize(boundaries.size() - 1);
+        if (chunks.size() == 1) {
+            decodeLines(data, dataEnd, &chunks[0]);
+        } else {
+            QThreadPool pool;
+            for (int i = 0; i < chunks.size(); i++) {
+                pool.start(new DecodeChunkTask(boundaries[i], boundaries[i + 1], &chunks[i]));
+            }
+            pool.waitForDone();
+        }
+
+        *lines = LineStore::build(chunks);
+        *newlineAfterLastLineMissing = dataEnd[-1] != '\n';
+
+        fileDevice->unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        fileDevice->seek(start + size);
+        return true;
+    }
+}
+
 bool ZDocument::readFrom(QIODevice *file) {
     return readFrom(file, {0, 0}, nullptr);
 }
@@ -128,45 +290,45 @@ bool ZDocument::readFrom(QIODevice *file) {
 bool ZDocument::readFrom(QIODevice *file, ZDocumentCursor::Position initialPosition, ZDocumentCursor *initialPositionCursor) {
     auto *const p = tuiwidgets_impl();
     // Clear line markers and cursors while _lines still has contents.
-    for (ZDocumentLineMarkerPrivate *marker = p->lineMarkerList.first; marker; marker = marker->markersList.next) {
-        marker->pub()->setLine(0);
-    }
+    p->lineMarkerIndex.collapse(1, std::numeric_limits<int>::max(), 0);
     for (ZDocumentCursorPrivate *cursor = p->cursorList.first; cursor; cursor = cursor->markersList.next) {
         cursor->pub()->setPosition({0, 0});
     }
 
     p->lines.clear();
-    QByteArray lineBuf;
-    lineBuf.resize(16384);
-    while (!file->atEnd()) { // each line
-        int lineBytes = 0;
-        p->newlineAfterLastLineMissing = true;
-        while (!file->atEnd()) { // chunks of the line
-            int res = file->readLine(lineBuf.data() + lineBytes, lineBuf.size() - 1 - lineBytes);
-            if (res < 0) {
-                // Some kind of error
-                // do some minimal recovery to avoid getting in a state that will just crash.
-                if (p->lines.isEmpty()) {
-                    p->lines.append(LineData());
-                }
-                p->initalUndoStep(initialPosition.codeUnit, initialPosition.line);
-                return false;
-            } else if (res > 0) {
-                lineBytes += res;
-                if (lineBuf[lineBytes - 1] == '\n') {
-                    --lineBytes; // remove \n
-                    p->newlineAfterLastLineMissing = false;
-                    break;
-                } else if (lineBytes == lineBuf.size() - 2) {
-                    lineBuf.resize(lineBuf.size() * 2);
-                } else {
-                    break;
+    if (!readMappedFile(file, &p->lines, &p->newlineAfterLastLineMissing)) {
+        QByteArray lineBuf;
+        lineBuf.resize(16384);
+        while (!file->atEnd()) { // each line
+            int lineBytes = 0;
+            p->newlineAfterLastLineMissing = true;
+            while (!file->atEnd()) { // chunks of the line
+                int res = file->readLine(lineBuf.data() + lineBytes, lineBuf.size() - 1 - lineBytes);
+                if (res < 0) {
+                    // Some kind of error
+                    // do some minimal recovery to avoid getting in a state that will just crash.
+                    if (p->lines.isEmpty()) {
+                        p->lines.append(LineData());
+                    }
+                    p->initalUndoStep(initialPosition.codeUnit, initialPosition.line);
+                    return false;
+                } else if (res > 0) {
+                    lineBytes += res;
+                    if (lineBuf[lineBytes - 1] == '\n') {
+                        --lineBytes; // remove \n
+                        p->newlineAfterLastLineMissing = false;
+                        break;
+                    } else if (lineBytes == lineBuf.size() - 2) {
+                        lineBuf.resize(lineBuf.size() * 2);
+                    } else {
+                        break;
+                    }
                 }
             }
-        }
 
-        QString text = Misc::SurrogateEscape::decode(lineBuf.constData(), lineBytes);
-        p->lines.append({text, 0, nullptr});
+            QString text = Misc::SurrogateEscape::decode(lineBuf.constData(), lineBytes);
+            p->lines.append({text, 0, nullptr});
+        }
     }
 
     if (p->lines.isEmpty()) {
@@ -186,7 +348,8 @@ bool ZDocument::readFrom(QIODevice *file, ZDocumentCursor::Position initialPosit
     }
     if (allLinesCrLf) {
         for (int i = 0; i < lineCount() - (p->newlineAfterLastLineMissing ? 1 : 0); i++) {
-            p->lines[i].chars.remove(p->lines[i].chars.size() - 1, 1);
+            QString &chars = p->lines.modify(i).chars;
+            chars.remove(chars.size() - 1, 1);
         }
     }
 
@@ -218,9 +381,7 @@ void ZDocument::setText(const QString &text) {
 void ZDocument::setText(const QString &text, ZDocumentCursor::Position initialPosition, ZDocumentCursor *initialPositionCursor) {
     auto *const p = tuiwidgets_impl();
     // Clear line markers and cursors while _lines still has contents.
-    for (ZDocumentLineMarkerPrivate *marker = p->lineMarkerList.first; marker; marker = marker->markersList.next) {
-        marker->pub()->setLine(0);
-    }
+    p->lineMarkerIndex.collapse(1, std::numeric_limits<int>::max(), 0);
     for (ZDocumentCursorPrivate *cursor = p->cursorList.first; cursor; cursor = cursor->markersList.next) {
         cursor->pub()->setPosition({0, 0});
     }
@@ -236,7 +397,7 @@ void ZDocument::setText(const QString &text, ZDocumentCursor::Position initialPo
         }
 
         p->newlineAfterLastLineMissing = true;
-        if (p->lines.back().chars.isEmpty()) {
+        if (p->lines.last().chars.isEmpty()) {
             p->lines.removeLast();
             p->newlineAfterLastLineMissing = false;
         }
@@ -254,7 +415,8 @@ void ZDocument::setText(const QString &text, ZDocumentCursor::Position initialPo
     }
     if (allLinesCrLf) {
         for (int i = 0; i < lineCount() - (p->newlineAfterLastLineMissing ? 1 : 0); i++) {
-            p->lines[i].chars.remove(p->lines[i].chars.size() - 1, 1);
+            QString &chars = p->lines.modify(i).chars;
+            chars.remove(chars.size() - 1, 1);
         }
     }
 
@@ -313,7 +475,7 @@ unsigned ZDocument::lineRevision(int line) const {
 
 void ZDocument::setLineUserData(int line, std::shared_ptr<ZDocumentLineUserData> userData) {
     auto *const p = tuiwidgets_impl();
-    p->lines[line].userData = userData;
+    p->lines.modify(line).userData = userData;
 }
 
 std::shared_ptr<ZDocumentLineUserData> ZDocument::lineUserData(int line) const {
@@ -394,7 +556,7 @@ void ZDocument::sortLines(int first, int last, ZDocumentCursor *cursorForUndoSte
 
     // Apply reorderBuffer to _lines
     for (int i = 0; i < last - first; i++) {
-        p->lines[first + i] = tmp[reorderBuffer[i] - first];
+        p->lines.modify(first + i) = tmp[reorderBuffer[i] - first];
     }
 
     std::vector<int> reorderBufferInverted;
@@ -426,15 +588,13 @@ void ZDocument::sortLines(int first, int last, ZDocumentCursor *cursorForUndoSte
         }
     }
     // Also line markers
-    for (ZDocumentLineMarkerPrivate *marker = p->lineMarkerList.first; marker; marker = marker->markersList.next) {
-        if (first <= marker->pub()->line() && marker->pub()->line() < last) {
-            marker->pub()->setLine(reorderBufferInverted[marker->pub()->line() - first]);
-        }
-    }
+    p->lineMarkerIndex.remap(first, last, [&](int line) {
+        return reorderBufferInverted[line - first];
+    });
 
     debugConsistencyCheck(nullptr);
 
-    auto redoTransform = [first, last, reorderBufferInverted] (QVector<ZDocumentPrivate::UndoCursor> &cursors, QVector<ZDocumentPrivate::UndoLineMarker> &markers) {
+    auto redoTransform = [first, last, reorderBufferInverted] (QVector<ZDocumentPrivate::UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (ZDocumentPrivate::UndoCursor &cursor: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cursor.anchor;
             const auto [cursorCodeUnit, cursorLine] = cursor.position;
@@ -450,15 +610,12 @@ void ZDocument::sortLines(int first, int last, ZDocumentCursor *cursorForUndoSte
             }
         }
 
-        for (ZDocumentPrivate::UndoLineMarker &marker: markers) {
-            if (first <= marker.line && marker.line < last) {
-                marker.line = reorderBufferInverted[marker.line - first];
-                marker.updated = true;
-            }
-        }
+        markers.remap(first, last, [&](int line) {
+            return reorderBufferInverted[line - first];
+        });
     };
 
-    auto undoTransform = [first, last, reorderBuffer](QVector<ZDocumentPrivate::UndoCursor> &cursors, QVector<ZDocumentPrivate::UndoLineMarker> &markers) {
+    auto undoTransform = [first, last, reorderBuffer](QVector<ZDocumentPrivate::UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (ZDocumentPrivate::UndoCursor &cursor: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cursor.anchor;
             const auto [cursorCodeUnit, cursorLine] = cursor.position;
@@ -474,12 +631,9 @@ void ZDocument::sortLines(int first, int last, ZDocumentCursor *cursorForUndoSte
             }
         }
 
-        for (ZDocumentPrivate::UndoLineMarker &marker: markers) {
-            if (first <= marker.line && marker.line < last) {
-                marker.line = reorderBuffer[marker.line - first];
-                marker.updated = true;
-            }
-        }
+        markers.remap(first, last, [&](int line) {
+            return reorderBuffer[line - first];
+        });
     };
 
     p->pendingUpdateStep.value().redoCursorAdjustments.push_back(redoTransform);
@@ -561,16 +715,21 @@ void ZDocument::moveLine(int from, int to, ZDocumentCursor *cursorForUndoStep) {
             cursor->setPositionPreservingVerticalMovementColumn({cursorCodeUnit, cursorLine}, true);
         }
     }
-    // similar for line markers
-    for (ZDocumentLineMarkerPrivate *marker = p->lineMarkerList.first; marker; marker = marker->markersList.next) {
-        transform(from, to, marker->pub()->line(), 0, [&](int line, int) {
-            marker->pub()->setLine(line);
+    // similar for line markers, only lines between from and to are moved
+    auto transformMarkers = [transform](int from, int to, LineMarkerIndex &markers) {
+        markers.remap(std::min(from, to), std::max(from, to) + (from < to ? 0 : 1), [&](int line) {
+            int result = line;
+            transform(from, to, line, 0, [&](int newLine, int) {
+                result = newLine;
+            });
+            return result;
         });
-    }
+    };
+    transformMarkers(from, to, p->lineMarkerIndex);
 
     debugConsistencyCheck(nullptr);
 
-    auto redoTransform = [from, to, transform] (QVector<ZDocumentPrivate::UndoCursor> &cursors, QVector<ZDocumentPrivate::UndoLineMarker> &markers) {
+    auto redoTransform = [from, to, transform, transformMarkers] (QVector<ZDocumentPrivate::UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (ZDocumentPrivate::UndoCursor &cursor: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cursor.anchor;
             const auto [cursorCodeUnit, cursorLine] = cursor.position;
@@ -588,15 +747,10 @@ void ZDocument::moveLine(int from, int to, ZDocumentCursor *cursorForUndoStep) {
             });
         }
 
-        for (ZDocumentPrivate::UndoLineMarker &marker: markers) {
-            transform(from, to, marker.line, 0, [&](int line, int) {
-                marker.line = line;
-                marker.updated = true;
-            });
-        }
+        transformMarkers(from, to, markers);
     };
 
-    auto undoTransform = [undoFrom, undoTo, transform](QVector<ZDocumentPrivate::UndoCursor> &cursors, QVector<ZDocumentPrivate::UndoLineMarker> &markers) {
+    auto undoTransform = [undoFrom, undoTo, transform, transformMarkers](QVector<ZDocumentPrivate::UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (ZDocumentPrivate::UndoCursor &cursor: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cursor.anchor;
             const auto [cursorCodeUnit, cursorLine] = cursor.position;
@@ -614,12 +768,7 @@ void ZDocument::moveLine(int from, int to, ZDocumentCursor *cursorForUndoStep) {
             });
         }
 
-        for (ZDocumentPrivate::UndoLineMarker &marker: markers) {
-            transform(undoFrom, undoTo, marker.line, 0, [&](int line, int) {
-                marker.line = line;
-                marker.updated = true;
-            });
-        }
+        transformMarkers(undoFrom, undoTo, markers);
     };
 
     p->pendingUpdateStep.value().redoCursorAdjustments.push_back(redoTransform);
@@ -636,11 +785,12 @@ void ZDocument::debugConsistencyCheck(const ZDocumentCursor *exclude) const {
 }
 
 void ZDocumentPrivate::debugConsistencyCheck(const ZDocumentCursor *exclude) const {
-    for (ZDocumentLineMarkerPrivate *marker = lineMarkerList.first; marker; marker = marker->markersList.next) {
-        if (marker->pub()->line() < 0) {
+    // The index is ordered by line, so checking the first and last marker is enough.
+    if (!lineMarkerIndex.isEmpty()) {
+        if (lineMarkerIndex.firstLine() < 0) {
             qFatal("ZDocument::debugConsistencyCheck: A line marker has a negative position");
             abort();
-        } else if (marker->pub()->line() >= lines.size()) {
+        } else if (lineMarkerIndex.lastLine() >= lines.size()) {
             qFatal("ZDocument::debugConsistencyCheck: A line marker is beyond the maximum line");
             abort();
         }
@@ -653,7 +803,7 @@ void ZDocumentPrivate::debugConsistencyCheck(const ZDocumentCursor *exclude) con
 
 
 void ZDocumentPrivate::applyCursorAdjustments(ZDocumentCursor *cursor,
-                                      const QVector<std::function<void(QVector<UndoCursor>&, QVector<UndoLineMarker>&)>> &cursorAdjustments) {
+                                      const QVector<std::function<void(QVector<UndoCursor>&, LineMarkerIndex&)>> &cursorAdjustments) {
     // The adjustments don't necessarily have valid intermediate positions, so they can't replayed directly using the
     // cursors. Instead work on a list of positions and update the cursors after all adjustments are applied.
     QVector<UndoCursor> cursorPositions;
@@ -662,14 +812,9 @@ void ZDocumentPrivate::applyCursorAdjustments(ZDocumentCursor *cursor,
         cursorPositions.append({curP->pub(), false, curP->pub()->anchor(), false, curP->pub()->position()});
     }
 
-    // Same for line markers
-    QVector<UndoLineMarker> markerPositions;
-    for (ZDocumentLineMarkerPrivate *marker = lineMarkerList.first; marker; marker = marker->markersList.next) {
-        markerPositions.append({marker->pub(), false, marker->pub()->line()});
-    }
-
+    // Line markers are adjusted directly in the index, it does not require valid lines.
     for (const auto &adjustment: cursorAdjustments) {
-        adjustment(cursorPositions, markerPositions);
+        adjustment(cursorPositions, lineMarkerIndex);
     }
 
     for (const UndoCursor &cur: cursorPositions) {
@@ -689,12 +834,6 @@ void ZDocumentPrivate::applyCursorAdjustments(ZDocumentCursor *cursor,
             cur.cursor->setPositionPreservingVerticalMovementColumn(cur.position, true);
         }
     }
-
-    for (UndoLineMarker &marker: markerPositions) {
-        if (marker.updated) {
-            marker.marker->setLine(marker.line);
-        }
-    }
 }
 
 void ZDocument::undo(ZDocumentCursor *cursor) {
@@ -734,11 +873,7 @@ void ZDocument::undo(ZDocumentCursor *cursor) {
         cur->setPosition({cursorCodeUnit, cursorLine}, true);
     }
     // similar for line markers
-    for (ZDocumentLineMarkerPrivate *marker = p->lineMarkerList.first; marker; marker = marker->markersList.next) {
-        if (marker->pub()->line() >= p->lines.size()) {
-            marker->pub()->setLine(p->lines.size() - 1);
-        }
-    }
+    p->lineMarkerIndex.collapse(p->lines.size(), std::numeric_limits<int>::max(), p->lines.size() - 1);
 
     debugConsistencyCheck(nullptr);
 
@@ -780,11 +915,7 @@ void ZDocument::redo(ZDocumentCursor *cursor) {
         cur->setPosition({cursorCodeUnit, cursorLine}, true);
     }
     // similar for line markers
-    for (ZDocumentLineMarkerPrivate *marker = p->lineMarkerList.first; marker; marker = marker->markersList.next) {
-        if (marker->pub()->line() >= p->lines.size()) {
-            marker->pub()->setLine(p->lines.size() - 1);
-        }
-    }
+    p->lineMarkerIndex.collapse(p->lines.size(), std::numeric_limits<int>::max(), p->lines.size() - 1);
 
     debugConsistencyCheck(nullptr);
 
@@ -846,12 +977,19 @@ void ZDocumentPrivate::closeUndoGroup(ZDocumentCursor *cursor) {
     }
 }
 
-void ZDocumentPrivate::registerLineMarker(ZDocumentLineMarkerPrivate *marker) {
+void ZDocumentPrivate::registerLineMarker(ZDocumentLineMarkerPrivate *marker, int line) {
     lineMarkerList.appendOrMoveToLast(marker);
+    marker->registrationSerial = lineMarkerRegistrationCounter++;
+    lineMarkerIndex.insert(marker, line);
 }
 
 void ZDocumentPrivate::unregisterLineMarker(ZDocumentLineMarkerPrivate *marker) {
     lineMarkerList.remove(marker);
+    lineMarkerIndex.remove(marker);
+    lineMarkerIndex.dropChanged(marker);
+    for (std::vector<ZDocumentLineMarkerPrivate*> *markers: lineMarkersInEmission) {
+        std::replace(markers->begin(), markers->end(), marker, static_cast<ZDocumentLineMarkerPrivate*>(nullptr));
+    }
 }
 
 void ZDocumentPrivate::scheduleChangeSignals() {
@@ -873,12 +1011,16 @@ void ZDocumentPrivate::scheduleChangeSignals() {
                 Q_EMIT pub()->cursorChanged(cursor->pub());
             }
         }
-        for (ZDocumentLineMarkerPrivate *marker = lineMarkerList.first; marker; marker = marker->markersList.next) {
-            if (marker->changed) {
+        // Only changed markers are visited. Slots might delete markers, unregistering removes them from markers.
+        std::vector<ZDocumentLineMarkerPrivate*> markers = lineMarkerIndex.takeChangedMarkers();
+        lineMarkersInEmission.push_back(&markers);
+        for (ZDocumentLineMarkerPrivate *marker: markers) {
+            if (marker && marker->changed) {
                 marker->changed = false;
                 Q_EMIT pub()->lineMarkerChanged(marker->pub());
             }
         }
+        lineMarkersInEmission.pop_back();
     });
 }
 
@@ -927,9 +1069,22 @@ void ZDocument::markUndoStateAsSaved() {
     p->emitModifedSignals();
 }
 
+void ZDocument::setUndoMemoryBudget(qint64 bytes) {
+    auto *const p = tuiwidgets_impl();
+    p->undoMemoryBudget = std::max(qint64(0), bytes);
+    p->applyUndoMemoryBudget();
+    p->emitModifedSignals();
+}
+
+qint64 ZDocument::undoMemoryBudget() const {
+    auto *const p = tuiwidgets_impl();
+    return p->undoMemoryBudget;
+}
+
 void ZDocumentPrivate::initalUndoStep(int endCodeUnit, int endLine) {
     collapseUndoStep = true;
     groupUndo = 0;
+    // The initial step is the base all later steps share their lines with, it is not counted.
     undoSteps.clear();
     undoSteps.append({ lines, endCodeUnit, endLine, endCodeUnit, endLine, newlineAfterLastLineMissing, {}, {}, false});
     currentUndoStep = 0;
@@ -957,10 +1112,18 @@ void ZDocumentPrivate::saveUndoStep(ZDocumentCursor::Position cursorPosition, bo
             undoSteps.resize(currentUndoStep + 1);
         }
 
+        // Lines are shared with the previous step, so only the nodes and text not shared with it need memory.
+        auto memoryCost = [](const UndoStep &step, const UndoStep &previous) {
+            return LineStore::unsharedBytes(step.lines, previous.lines)
+                    + (step.undoCursorAdjustments.size() + step.redoCursorAdjustments.size())
+                      * static_cast<qint64>(sizeof(std::function<void(QVector<UndoCursor>&, LineMarkerIndex&)>));
+        };
+
         if (collapseUndoStep && undoSteps[currentUndoStep].collapsable
                    && undoSteps[currentUndoStep].endCursorCodeUnit == startCodeUnit
                    && undoSteps[currentUndoStep].endCursorLine == startLine
                    && collapse) {
+            // The lines of the step are replaced, so its cost is determined again instead of adding to it.
             undoSteps[currentUndoStep].lines = lines;
             undoSteps[currentUndoStep].endCursorCodeUnit = endCodeUnit;
             undoSteps[currentUndoStep].endCursorLine = endLine;
@@ -968,6 +1131,8 @@ void ZDocumentPrivate::saveUndoStep(ZDocumentCursor::Position cursorPosition, bo
             undoSteps[currentUndoStep].undoCursorAdjustments
                     = pendingUpdateStep.value().undoCursorAdjustments + undoSteps[currentUndoStep].undoCursorAdjustments;
             undoSteps[currentUndoStep].redoCursorAdjustments += pendingUpdateStep.value().redoCursorAdjustments;
+            undoSteps[currentUndoStep].memoryCost = memoryCost(undoSteps[currentUndoStep],
+                                                               undoSteps[currentUndoStep - 1]);
         } else {
             undoSteps.append({ lines, startCodeUnit, startLine, endCodeUnit, endLine,
                                newlineAfterLastLineMissing,
@@ -975,9 +1140,12 @@ void ZDocumentPrivate::saveUndoStep(ZDocumentCursor::Position cursorPosition, bo
                                pendingUpdateStep.value().redoCursorAdjustments,
                                collapsable});
             currentUndoStep = undoSteps.size() - 1;
+            undoSteps[currentUndoStep].memoryCost = memoryCost(undoSteps[currentUndoStep],
+                                                               undoSteps[currentUndoStep - 1]);
         }
         collapseUndoStep = true;
         pendingUpdateStep.reset();
+        applyUndoMemoryBudget();
         emitModifedSignals();
     } else {
         undoGroupCollapsable &= collapsable;
@@ -986,6 +1154,32 @@ void ZDocumentPrivate::saveUndoStep(ZDocumentCursor::Position cursorPosition, bo
     }
 }
 
+void ZDocumentPrivate::applyUndoMemoryBudget() {
+    if (undoMemoryBudget <= 0) {
+        return;
+    }
+
+    qint64 used = 0;
+    for (int i = 1; i < undoSteps.size(); i++) {
+        used += undoSteps[i].memoryCost;
+    }
+
+    // Drop the oldest steps, but never the current one. The first remaining step then becomes the state that can
+    // not be undone further.
+    while (used > undoMemoryBudget && currentUndoStep > 0) {
+        used -= undoSteps[1].memoryCost;
+        undoSteps.removeFirst();
+        undoSteps[0].memoryCost = 0;
+        // Changes can't be collapsed into the base step, they could not be undone then.
+        undoSteps[0].collapsable = false;
+        --currentUndoStep;
+        if (savedUndoStep >= 0) {
+            // -1 if the saved state is no longer reachable
+            --savedUndoStep;
+        }
+    }
+}
+
 void ZDocumentPrivate::registerTextCursor(ZDocumentCursorPrivate *cursor) {
     cursorList.appendOrMoveToLast(cursor);
 }
@@ -995,8 +1189,9 @@ void ZDocumentPrivate::unregisterTextCursor(ZDocumentCursorPrivate *cursor) {
 }
 
 void ZDocumentPrivate::removeFromLine(ZDocumentCursor *cursor, int line, int codeUnitStart, int codeUnits) {
-    lines[line].revision = lineRevisionCounter++;
-    lines[line].chars.remove(codeUnitStart, codeUnits);
+    LineData &lineData = lines.modify(line);
+    lineData.revision = lineRevisionCounter++;
+    lineData.chars.remove(codeUnitStart, codeUnits);
 
     for (ZDocumentCursorPrivate *curP = cursorList.first; curP; curP = curP->markersList.next) {
         ZDocumentCursor *cur = curP->pub();
@@ -1035,7 +1230,7 @@ void ZDocumentPrivate::removeFromLine(ZDocumentCursor *cursor, int line, int cod
 
     debugConsistencyCheck(cursor);
 
-    auto redoTransform = [line, codeUnitStart, codeUnits](QVector<UndoCursor> &cursors, QVector<UndoLineMarker>&) {
+    auto redoTransform = [line, codeUnitStart, codeUnits](QVector<UndoCursor> &cursors, LineMarkerIndex&) {
         for (UndoCursor &cur: cursors) {
             // anchor
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
@@ -1063,7 +1258,7 @@ void ZDocumentPrivate::removeFromLine(ZDocumentCursor *cursor, int line, int cod
         }
     };
 
-    auto undoTransform = [line, codeUnitStart, codeUnits](QVector<UndoCursor> &cursors, QVector<UndoLineMarker>&) {
+    auto undoTransform = [line, codeUnitStart, codeUnits](QVector<UndoCursor> &cursors, LineMarkerIndex&) {
         for (UndoCursor &cur: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
             const auto [cursorCodeUnit, cursorLine] = cur.position;
@@ -1107,8 +1302,9 @@ void ZDocumentPrivate::removeFromLine(ZDocumentCursor *cursor, int line, int cod
 }
 
 void ZDocumentPrivate::insertIntoLine(ZDocumentCursor *cursor, int line, int codeUnitStart, const QString &data) {
-    lines[line].revision = lineRevisionCounter++;
-    lines[line].chars.insert(codeUnitStart, data);
+    LineData &lineData = lines.modify(line);
+    lineData.revision = lineRevisionCounter++;
+    lineData.chars.insert(codeUnitStart, data);
 
     for (ZDocumentCursorPrivate *curP = cursorList.first; curP; curP = curP->markersList.next) {
         ZDocumentCursor *cur = curP->pub();
@@ -1154,7 +1350,7 @@ void ZDocumentPrivate::insertIntoLine(ZDocumentCursor *cursor, int line, int cod
 
     debugConsistencyCheck(cursor);
 
-    auto redoTransform = [line, codeUnitStart, codeUnits=data.size()](QVector<UndoCursor> &cursors, QVector<UndoLineMarker>&) {
+    auto redoTransform = [line, codeUnitStart, codeUnits=data.size()](QVector<UndoCursor> &cursors, LineMarkerIndex&) {
         for (UndoCursor &cur: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
             const auto [cursorCodeUnit, cursorLine] = cur.position;
@@ -1190,7 +1386,7 @@ void ZDocumentPrivate::insertIntoLine(ZDocumentCursor *cursor, int line, int cod
         }
     };
 
-    auto undoTransform = [line, codeUnitStart, codeUnits=data.size()](QVector<UndoCursor> &cursors, QVector<UndoLineMarker>&) {
+    auto undoTransform = [line, codeUnitStart, codeUnits=data.size()](QVector<UndoCursor> &cursors, LineMarkerIndex&) {
         for (UndoCursor &cur: cursors) {
             // anchor
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
@@ -1224,16 +1420,189 @@ void ZDocumentPrivate::insertIntoLine(ZDocumentCursor *cursor, int line, int cod
     noteContentsChange();
 }
 
-void ZDocumentPrivate::removeLines(ZDocumentCursor *cursor, int start, int count) {
-    lines.remove(start, count);
+void ZDocumentPrivate::insertLines(ZDocumentCursor *cursor, ZDocumentCursor::Position pos, const QStringList &data) {
+    // Has the same effect as inserting the first entry of data with insertIntoLine and then alternating splitLine and
+    // insertIntoLine for the remaining entries, but cursors, line markers and the undo step are only adjusted once.
+    Q_ASSERT(data.size() >= 2);
+
+    const int line = pos.line;
+    const int codeUnit = pos.codeUnit;
+    const int addedLines = data.size() - 1;
+    const int lastCodeUnits = data.last().size();
+
+    {
+        LineData &lineData = lines.modify(line);
+        lineData.revision = lineRevisionCounter++;
+        const QString tail = lineData.chars.mid(codeUnit);
+        lineData.chars.resize(codeUnit);
+        lineData.chars += data.first();
+
+        QVector<LineData> newLines;
+        newLines.reserve(addedLines);
+        for (int i = 1; i < addedLines; i++) {
+            newLines.append({data.at(i), static_cast<unsigned>(lineRevisionCounter++), nullptr});
+        }
+        newLines.append({data.last() + tail, static_cast<unsigned>(lineRevisionCounter++), nullptr});
+        lines.insert(line + 1, newLines);
+    }
 
-    for (ZDocumentLineMarkerPrivate *marker = lineMarkerList.first; marker; marker = marker->markersList.next) {
-        if (marker->pub()->line() > start + count) {
-            marker->pub()->setLine(marker->pub()->line() - count);
-        } else if (marker->pub()->line() > start) {
-            marker->pub()->setLine(start);
+    // A split at the start of a line moves markers on that line down. This repeats for each following empty line.
+    int markerLines = 0;
+    if (codeUnit == 0 && data.first().isEmpty()) {
+        markerLines = 1;
+        while (markerLines < addedLines && data.at(markerLines).isEmpty()) {
+            markerLines++;
         }
+        lineMarkerIndex.shift(line, markerLines);
+        lineMarkerIndex.shift(line + markerLines + 1, addedLines - markerLines);
+    } else {
+        lineMarkerIndex.shift(line + 1, addedLines);
     }
+
+    for (ZDocumentCursorPrivate *curP = cursorList.first; curP; curP = curP->markersList.next) {
+        ZDocumentCursor *cur = curP->pub();
+        if (cursor == cur) continue;
+
+        bool positionMustBeSet = false;
+
+        const auto [anchorCodeUnit, anchorLine] = cur->anchor();
+        const auto [cursorCodeUnit, cursorLine] = cur->position();
+
+        if (cur->hasSelection()) {
+            const bool anchorBefore = anchorLine < cursorLine
+                    || (anchorLine == cursorLine && anchorCodeUnit < cursorCodeUnit);
+
+            // anchor
+            if (anchorLine > line) {
+                cur->setAnchorPosition({anchorCodeUnit, anchorLine + addedLines});
+                positionMustBeSet = true;
+            } else if (anchorLine == line) {
+                const int anchorAdj = anchorBefore ? 0 : -1;
+                if (anchorCodeUnit + anchorAdj >= codeUnit) {
+                    cur->setAnchorPosition({anchorCodeUnit - codeUnit + lastCodeUnits, anchorLine + addedLines});
+                    positionMustBeSet = true;
+                }
+            }
+
+            // position
+            if (cursorLine > line) {
+                cur->setPositionPreservingVerticalMovementColumn({cursorCodeUnit, cursorLine + addedLines}, true);
+                positionMustBeSet = false;
+            } else if (cursorLine == line) {
+                const int cursorAdj = anchorBefore ? -1 : 0;
+                if (cursorCodeUnit + cursorAdj >= codeUnit) {
+                    cur->setPosition({cursorCodeUnit - codeUnit + lastCodeUnits, cursorLine + addedLines}, true);
+                    positionMustBeSet = false;
+                }
+            }
+
+            if (positionMustBeSet) {
+                cur->setPositionPreservingVerticalMovementColumn({cursorCodeUnit, cursorLine}, true);
+            }
+        } else {
+            if (cursorLine > line) {
+                cur->setPosition({cursorCodeUnit, cursorLine + addedLines}, false);
+            } else if (cursorLine == line && cursorCodeUnit >= codeUnit) {
+                cur->setPosition({cursorCodeUnit - codeUnit + lastCodeUnits, cursorLine + addedLines}, false);
+            }
+        }
+    }
+
+    debugConsistencyCheck(cursor);
+
+    auto redoTransform = [line, codeUnit, addedLines, lastCodeUnits, markerLines](QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
+        for (UndoCursor &cur: cursors) {
+            const auto [anchorCodeUnit, anchorLine] = cur.anchor;
+            const auto [cursorCodeUnit, cursorLine] = cur.position;
+
+            if (cur.hasSelection()) {
+                const bool anchorBefore = anchorLine < cursorLine
+                        || (anchorLine == cursorLine && anchorCodeUnit < cursorCodeUnit);
+
+                // anchor
+                if (anchorLine > line) {
+                    cur.anchor = {anchorCodeUnit, anchorLine + addedLines};
+                    cur.anchorUpdated = true;
+                } else if (anchorLine == line) {
+                    const int anchorAdj = anchorBefore ? 0 : -1;
+                    if (anchorCodeUnit + anchorAdj >= codeUnit) {
+                        cur.anchor = {anchorCodeUnit - codeUnit + lastCodeUnits, anchorLine + addedLines};
+                        cur.anchorUpdated = true;
+                    }
+                }
+
+                // position
+                if (cursorLine > line) {
+                    cur.position = {cursorCodeUnit, cursorLine + addedLines};
+                    cur.positionUpdated = true;
+                } else if (cursorLine == line) {
+                    const int cursorAdj = anchorBefore ? -1 : 0;
+                    if (cursorCodeUnit + cursorAdj >= codeUnit) {
+                        cur.position = {cursorCodeUnit - codeUnit + lastCodeUnits, cursorLine + addedLines};
+                        cur.positionUpdated = true;
+                    }
+                }
+            } else {
+                if (cursorLine > line) {
+                    cur.position = cur.anchor = {cursorCodeUnit, cursorLine + addedLines};
+                    cur.anchorUpdated = true;
+                    cur.positionUpdated = true;
+                } else if (cursorLine == line && cursorCodeUnit >= codeUnit) {
+                    cur.position = cur.anchor = {cursorCodeUnit - codeUnit + lastCodeUnits, cursorLine + addedLines};
+                    cur.anchorUpdated = true;
+                    cur.positionUpdated = true;
+                }
+            }
+        }
+
+        if (markerLines) {
+            markers.shift(line, markerLines);
+            markers.shift(line + markerLines + 1, addedLines - markerLines);
+        } else {
+            markers.shift(line + 1, addedLines);
+        }
+    };
+
+    // data shares the strings with the inserted lines, so capturing it is cheap
+    auto undoTransform = [line, codeUnit, addedLines, data](QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
+        auto adjust = [&](ZDocumentCursor::Position &position, bool &updated) {
+            const auto [posCodeUnit, posLine] = position;
+            if (posLine > line + addedLines) {
+                position = {posCodeUnit, posLine - addedLines};
+                updated = true;
+            } else if (posLine > line) {
+                const int insertedCodeUnits = data.at(posLine - line).size();
+                position = {codeUnit + std::max(0, posCodeUnit - insertedCodeUnits), line};
+                updated = true;
+            } else if (posLine == line && posCodeUnit >= codeUnit + data.first().size()) {
+                position = {posCodeUnit - data.first().size(), line};
+                updated = true;
+            } else if (posLine == line && posCodeUnit >= codeUnit) {
+                position = {codeUnit, line};
+                updated = true;
+            }
+        };
+
+        for (UndoCursor &cur: cursors) {
+            adjust(cur.anchor, cur.anchorUpdated);
+            adjust(cur.position, cur.positionUpdated);
+        }
+
+        markers.collapse(line + 1, line + addedLines, line);
+        markers.shift(line + addedLines + 1, -addedLines);
+    };
+
+    pendingUpdateStep.value().redoCursorAdjustments.push_back(redoTransform);
+    pendingUpdateStep.value().undoCursorAdjustments.prepend(undoTransform);
+
+    noteContentsChange();
+}
+
+void ZDocumentPrivate::removeLines(ZDocumentCursor *cursor, int start, int count) {
+    lines.remove(start, count);
+
+    lineMarkerIndex.collapse(start + 1, start + count, start);
+    lineMarkerIndex.shift(start + count + 1, -count);
     for (ZDocumentCursorPrivate *curP = cursorList.first; curP; curP = curP->markersList.next) {
         ZDocumentCursor *cur = curP->pub();
         if (cursor == cur) continue;
@@ -1275,7 +1644,7 @@ void ZDocumentPrivate::removeLines(ZDocumentCursor *cursor, int start, int count
     debugConsistencyCheck(cursor);
 
     auto redoTransform = [start, count, lineCount=lines.size(), lastLineCodeUnits=lines[lines.size() - 1].chars.size()]
-            (QVector<UndoCursor> &cursors, QVector<UndoLineMarker> &markers) {
+            (QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (UndoCursor &cur: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
             const auto [cursorCodeUnit, cursorLine] = cur.position;
@@ -1305,18 +1674,11 @@ void ZDocumentPrivate::removeLines(ZDocumentCursor *cursor, int start, int count
             }
         }
 
-        for (UndoLineMarker &marker: markers) {
-            if (marker.line > start + count) {
-                marker.line = marker.line - count;
-                marker.updated = true;
-            } else if (marker.line > start) {
-                marker.line = start;
-                marker.updated = true;
-            }
-        }
+        markers.collapse(start + 1, start + count, start);
+        markers.shift(start + count + 1, -count);
     };
 
-    auto undoTransform = [start, count](QVector<UndoCursor> &cursors, QVector<UndoLineMarker> &markers) {
+    auto undoTransform = [start, count](QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (UndoCursor &cur: cursors) {
             // anchor
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
@@ -1334,12 +1696,7 @@ void ZDocumentPrivate::removeLines(ZDocumentCursor *cursor, int start, int count
             }
         }
 
-        for (UndoLineMarker &marker: markers) {
-            if (marker.line >= start) {
-                marker.line = marker.line + count;
-                marker.updated = true;
-            }
-        }
+        markers.shift(start, count);
     };
 
     pendingUpdateStep.value().redoCursorAdjustments.push_back(redoTransform);
@@ -1349,15 +1706,15 @@ void ZDocumentPrivate::removeLines(ZDocumentCursor *cursor, int start, int count
 }
 
 void ZDocumentPrivate::splitLine(ZDocumentCursor *cursor, ZDocumentCursor::Position pos) {
-    lines[pos.line].revision = lineRevisionCounter++;
-    lines.insert(pos.line + 1, {lines[pos.line].chars.mid(pos.codeUnit), 0, nullptr});
-    lines[pos.line].chars.resize(pos.codeUnit);
-
-    for (ZDocumentLineMarkerPrivate *marker = lineMarkerList.first; marker; marker = marker->markersList.next) {
-        if (marker->pub()->line() > pos.line || (marker->pub()->line() == pos.line && pos.codeUnit == 0)) {
-            marker->pub()->setLine(marker->pub()->line() + 1);
-        }
+    {
+        LineData &lineData = lines.modify(pos.line);
+        lineData.revision = lineRevisionCounter++;
+        QString tail = lineData.chars.mid(pos.codeUnit);
+        lineData.chars.resize(pos.codeUnit);
+        lines.insert(pos.line + 1, {tail, 0, nullptr});
     }
+
+    lineMarkerIndex.shift(pos.codeUnit == 0 ? pos.line : pos.line + 1, 1);
     for (ZDocumentCursorPrivate *curP = cursorList.first; curP; curP = curP->markersList.next) {
         ZDocumentCursor *cur = curP->pub();
         if (cursor == cur) continue;
@@ -1410,7 +1767,7 @@ void ZDocumentPrivate::splitLine(ZDocumentCursor *cursor, ZDocumentCursor::Posit
 
     debugConsistencyCheck(cursor);
 
-    auto redoTransform = [pos](QVector<UndoCursor> &cursors, QVector<UndoLineMarker> &markers) {
+    auto redoTransform = [pos](QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (UndoCursor &cur: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
             const auto [cursorCodeUnit, cursorLine] = cur.position;
@@ -1455,15 +1812,10 @@ void ZDocumentPrivate::splitLine(ZDocumentCursor *cursor, ZDocumentCursor::Posit
             }
         }
 
-        for (UndoLineMarker &marker: markers) {
-            if (marker.line > pos.line || (marker.line == pos.line && pos.codeUnit == 0)) {
-                marker.line = marker.line + 1;
-                marker.updated = true;
-            }
-        }
+        markers.shift(pos.codeUnit == 0 ? pos.line : pos.line + 1, 1);
     };
 
-    auto undoTransform = [pos](QVector<UndoCursor> &cursors, QVector<UndoLineMarker> &markers) {
+    auto undoTransform = [pos](QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (UndoCursor &cur: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
             const auto [cursorCodeUnit, cursorLine] = cur.position;
@@ -1487,12 +1839,7 @@ void ZDocumentPrivate::splitLine(ZDocumentCursor *cursor, ZDocumentCursor::Posit
             }
         }
 
-        for (UndoLineMarker &marker: markers) {
-            if (marker.line > pos.line || (marker.line - 1 == pos.line && pos.codeUnit == 0)) {
-                marker.line = marker.line - 1;
-                marker.updated = true;
-            }
-        }
+        markers.shift(pos.line + 1, -1);
     };
 
     pendingUpdateStep.value().redoCursorAdjustments.push_back(redoTransform);
@@ -1503,20 +1850,21 @@ void ZDocumentPrivate::splitLine(ZDocumentCursor *cursor, ZDocumentCursor::Posit
 
 void ZDocumentPrivate::mergeLines(ZDocumentCursor *cursor, int line) {
     const int originalLineCodeUnits = lines[line].chars.size();
-    lines[line].revision = lineRevisionCounter++;
-    lines[line].chars.append(lines[line + 1].chars);
+    {
+        const QString nextLine = lines[line + 1].chars;
+        LineData &lineData = lines.modify(line);
+        lineData.revision = lineRevisionCounter++;
+        lineData.chars.append(nextLine);
+    }
     if (line + 1 < lines.size()) {
         lines.remove(line + 1, 1);
     } else {
-        lines[line + 1].chars.clear();
-        lines[line + 1].revision = lineRevisionCounter++;
+        LineData &nextLineData = lines.modify(line + 1);
+        nextLineData.chars.clear();
+        nextLineData.revision = lineRevisionCounter++;
     }
 
-    for (ZDocumentLineMarkerPrivate *marker = lineMarkerList.first; marker; marker = marker->markersList.next) {
-        if (marker->pub()->line() > line) {
-            marker->pub()->setLine(marker->pub()->line() - 1);
-        }
-    }
+    lineMarkerIndex.shift(line + 1, -1);
     for (ZDocumentCursorPrivate *curP = cursorList.first; curP; curP = curP->markersList.next) {
         ZDocumentCursor *cur = curP->pub();
         if (cursor == cur) continue;
@@ -1550,7 +1898,7 @@ void ZDocumentPrivate::mergeLines(ZDocumentCursor *cursor, int line) {
 
     debugConsistencyCheck(cursor);
 
-    auto redoTransform = [line, originalLineCodeUnits](QVector<UndoCursor> &cursors, QVector<UndoLineMarker> &markers) {
+    auto redoTransform = [line, originalLineCodeUnits](QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (UndoCursor &cur: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
             const auto [cursorCodeUnit, cursorLine] = cur.position;
@@ -1573,15 +1921,10 @@ void ZDocumentPrivate::mergeLines(ZDocumentCursor *cursor, int line) {
                 cur.positionUpdated = true;
             }
         }
-        for (UndoLineMarker &marker: markers) {
-            if (marker.line > line) {
-                marker.line = marker.line - 1;
-                marker.updated = true;
-            }
-        }
+        markers.shift(line + 1, -1);
     };
 
-    auto undoTransform = [line, originalLineCodeUnits](QVector<UndoCursor> &cursors, QVector<UndoLineMarker> &markers) {
+    auto undoTransform = [line, originalLineCodeUnits](QVector<UndoCursor> &cursors, LineMarkerIndex &markers) {
         for (UndoCursor &cur: cursors) {
             const auto [anchorCodeUnit, anchorLine] = cur.anchor;
             const auto [cursorCodeUnit, cursorLine] = cur.position;
@@ -1625,12 +1968,7 @@ void ZDocumentPrivate::mergeLines(ZDocumentCursor *cursor, int line) {
                 }
             }
         }
-        for (UndoLineMarker &marker: markers) {
-            if (marker.line > line || (marker.line == line && originalLineCodeUnits == 0)) {
-                marker.line = marker.line + 1;
-                marker.updated = true;
-            }
-        }
+        markers.shift(originalLineCodeUnits == 0 ? line : line + 1, 1);
     };
 
     pendingUpdateStep.value().redoCursorAdjustments.push_back(redoTransform);
@@ -8,6 +8,7 @@
 #include <QObject>
 #include <QRegularExpression>
 #include <QString>
+#include <QVector>
 
 #include <Tui/ZDocumentCursor.h>
 
@@ -82,6 +83,34 @@ class TUIWIDGETS_EXPORT ZDocumentFindResult {
     std::unique_ptr<ZDocumentFindResultPrivate> tuiwidgets_pimpl_ptr;
 };
 
+class ZDocumentMatchIndexPrivate;
+
+class TUIWIDGETS_EXPORT ZDocumentMatchIndex {
+public:
+    struct Match {
+        int codeUnit = 0;
+        int length = 0;
+    };
+
+public:
+    ZDocumentMatchIndex();
+    ZDocumentMatchIndex(const ZDocumentMatchIndex &other);
+    ~ZDocumentMatchIndex();
+
+    ZDocumentMatchIndex &operator=(const ZDocumentMatchIndex &other);
+
+public:
+    unsigned revision() const;
+    int lineCount() const;
+    int matchCount() const;
+    QVector<Match> matchesInLine(int line) const;
+    int searchedLineCount() const;
+
+private:
+    TUIWIDGETS_DECLARE_PRIVATE(ZDocumentMatchIndex)
+    std::shared_ptr<ZDocumentMatchIndexPrivate> tuiwidgets_pimpl_ptr;
+};
+
 class ZDocumentUndoGroupPrivate;
 
 class TUIWIDGETS_EXPORT ZDocument : public QObject {
@@ -121,6 +150,8 @@ class TUIWIDGETS_EXPORT ZDocument : public QObject {
 public:
     void reset();
     bool writeTo(QIODevice *file, bool crLfMode = false) const;
+    QFuture<bool> writeToAsync(QIODevice *file, bool crLfMode = false) const;
+    QFuture<bool> writeToAsyncWithPool(QThreadPool *pool, int priority, QIODevice *file, bool crLfMode = false) const;
     bool readFrom(QIODevice *file);
     bool readFrom(QIODevice *file, ZDocumentCursor::Position initialPosition, ZDocumentCursor *initialPositionCursor);
     void setText(const QString &text);
@@ -161,6 +192,9 @@ class TUIWIDGETS_EXPORT ZDocument : public QObject {
 
     void markUndoStateAsSaved();
 
+    void setUndoMemoryBudget(qint64 bytes);
+    qint64 undoMemoryBudget() const;
+
     ZDocumentCursor findSync(const QString &subString, const ZDocumentCursor &start,
                              FindFlags options = FindFlags{}) const;
     ZDocumentCursor findSync(const QRegularExpression &regex, const ZDocumentCursor &start,
@@ -177,6 +211,16 @@ class TUIWIDGETS_EXPORT ZDocument : public QObject {
     QFuture<ZDocumentFindAsyncResult> findAsyncWithPool(QThreadPool *pool, int priority,
                                                         const QRegularExpression &regex, const ZDocumentCursor &start,
                                                         FindFlags options = FindFlags{}) const;
+    QFuture<ZDocumentMatchIndex> findAllAsync(const QString &subString, FindFlags options = FindFlags{},
+                                              const ZDocumentMatchIndex &previous = ZDocumentMatchIndex{}) const;
+    QFuture<ZDocumentMatchIndex> findAllAsync(const QRegularExpression &regex, FindFlags options = FindFlags{},
+                                              const ZDocumentMatchIndex &previous = ZDocumentMatchIndex{}) const;
+    QFuture<ZDocumentMatchIndex> findAllAsyncWithPool(QThreadPool *pool, int priority,
+                                                      const QString &subString, FindFlags options = FindFlags{},
+                                                      const ZDocumentMatchIndex &previous = ZDocumentMatchIndex{}) const;
+    QFuture<ZDocumentMatchIndex> findAllAsyncWithPool(QThreadPool *pool, int priority,
+                                                      const QRegularExpression &regex, FindFlags options = FindFlags{},
+                                                      const ZDocumentMatchIndex &previous = ZDocumentMatchIndex{}) const;
 
 Q_SIGNALS:
     void modificationChanged(bool changed);
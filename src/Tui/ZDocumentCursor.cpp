@@ -84,14 +84,13 @@ void ZDocumentCursor::insertText(const QString &text) {
             lines.removeLast();
             p->doc->newlineAfterLastLineMissing = false;
         }
-        p->doc->insertIntoLine(this, p->cursorLine, p->cursorCodeUnit, lines.front());
-        p->cursorCodeUnit += lines.front().size();
-        for (int i = 1; i < lines.size(); i++) {
-            p->doc->splitLine(this, {p->cursorCodeUnit, p->cursorLine});
-            p->cursorLine++;
-            p->cursorCodeUnit = 0;
-            p->doc->insertIntoLine(this, p->cursorLine, p->cursorCodeUnit, lines.at(i));
-            p->cursorCodeUnit = lines.at(i).size();
+        if (lines.size() == 1) {
+            p->doc->insertIntoLine(this, p->cursorLine, p->cursorCodeUnit, lines.front());
+            p->cursorCodeUnit += lines.front().size();
+        } else {
+            p->doc->insertLines(this, {p->cursorCodeUnit, p->cursorLine}, lines);
+            p->cursorLine += lines.size() - 1;
+            p->cursorCodeUnit = lines.last().size();
         }
         p->anchorCodeUnit = p->cursorCodeUnit;
         p->anchorLine = p->cursorLine;
@@ -8,8 +8,8 @@
 TUIWIDGETS_NS_START
 
 ZDocumentLineMarkerPrivate::ZDocumentLineMarkerPrivate(ZDocumentLineMarker *pub, ZDocumentPrivate *doc, int line)
-    : line(line), doc(doc), pub_ptr(pub) {
-    doc->registerLineMarker(this);
+    : doc(doc), pub_ptr(pub) {
+    doc->registerLineMarker(this, line);
 }
 
 
@@ -22,7 +22,7 @@ ZDocumentLineMarker::ZDocumentLineMarker(ZDocument *doc) : ZDocumentLineMarker(d
 
 ZDocumentLineMarker::ZDocumentLineMarker(const ZDocumentLineMarker &other)
     : tuiwidgets_pimpl_ptr(new ZDocumentLineMarkerPrivate(this,
-                                                          other.tuiwidgets_impl()->doc, other.tuiwidgets_impl()->line))
+                                                          other.tuiwidgets_impl()->doc, other.line()))
 {
 }
 
@@ -39,16 +39,16 @@ ZDocumentLineMarker &ZDocumentLineMarker::operator=(const ZDocumentLineMarker &o
     auto *const otherP = other.tuiwidgets_impl();
 
     if (p->doc != otherP->doc) {
+        const int line = p->doc->lineMarkerIndex.line(p);
         p->doc->unregisterLineMarker(p);
         p->doc = otherP->doc;
-        p->doc->registerLineMarker(p);
-        p->changed = true;
+        p->doc->registerLineMarker(p, line);
+        p->doc->lineMarkerIndex.markChanged(p);
         p->doc->scheduleChangeSignals();
     }
 
-    if (p->line == otherP->line) {
-        p->line = otherP->line;
-        p->changed = true;
+    if (line() == other.line()) {
+        p->doc->lineMarkerIndex.markChanged(p);
         p->doc->scheduleChangeSignals();
     }
 
@@ -57,16 +57,17 @@ ZDocumentLineMarker &ZDocumentLineMarker::operator=(const ZDocumentLineMarker &o
 
 int ZDocumentLineMarker::line() const {
     auto *const p = tuiwidgets_impl();
-    return p->line;
+    return p->doc->lineMarkerIndex.line(p);
 }
 
 void ZDocumentLineMarker::setLine(int line) {
     auto *const p = tuiwidgets_impl();
     line = std::max(std::min(line, p->doc->pub()->lineCount() - 1), 0);
 
-    if (p->line != line) {
-        p->line = line;
-        p->changed = true;
+    if (p->doc->lineMarkerIndex.line(p) != line) {
+        p->doc->lineMarkerIndex.remove(p);
+        p->doc->lineMarkerIndex.insert(p, line);
+        p->doc->lineMarkerIndex.markChanged(p);
         p->doc->scheduleChangeSignals();
     }
 }
@@ -0,0 +1,337 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "ZDocumentLineMarkerIndex_p.h"
+
+#include <algorithm>
+
+#include <QtGlobal>
+
+#include <Tui/ZDocumentLineMarker_p.h>
+
+TUIWIDGETS_NS_START
+
+static constexpr int maxBucketSize = 64;
+
+LineMarkerIndex::LineMarkerIndex() {
+}
+
+LineMarkerIndex::~LineMarkerIndex() {
+}
+
+bool LineMarkerIndex::isEmpty() const {
+    return buckets.empty();
+}
+
+int LineMarkerIndex::firstLine() const {
+    Q_ASSERT(!buckets.empty());
+    return bucketFirstLine(0);
+}
+
+int LineMarkerIndex::lastLine() const {
+    Q_ASSERT(!buckets.empty());
+    return bucketLastLine(buckets.size() - 1);
+}
+
+void LineMarkerIndex::insert(ZDocumentLineMarkerPrivate *marker, int line) {
+    Q_ASSERT(!marker->indexBucket);
+
+    int bucketIndex = 0;
+    if (buckets.empty()) {
+        buckets.push_back(std::make_unique<LineMarkerIndexBucket>());
+        rebuild({0});
+    } else {
+        bucketIndex = findBucket(line);
+        if (bucketIndex == static_cast<int>(buckets.size())) {
+            bucketIndex--;
+        }
+    }
+    LineMarkerIndexBucket *bucket = buckets[bucketIndex].get();
+
+    marker->indexBucket = bucket;
+    marker->indexLine = line - bucketOffset(bucketIndex);
+    auto it = std::upper_bound(bucket->markers.begin(), bucket->markers.end(), marker->indexLine,
+                               [](int indexLine, const ZDocumentLineMarkerPrivate *other) {
+        return indexLine < other->indexLine;
+    });
+    bucket->markers.insert(it, marker);
+
+    if (static_cast<int>(bucket->markers.size()) > maxBucketSize) {
+        splitBucket(bucketIndex);
+    }
+}
+
+void LineMarkerIndex::remove(ZDocumentLineMarkerPrivate *marker) {
+    LineMarkerIndexBucket *bucket = marker->indexBucket;
+    Q_ASSERT(bucket);
+
+    auto it = std::lower_bound(bucket->markers.begin(), bucket->markers.end(), marker->indexLine,
+                               [](const ZDocumentLineMarkerPrivate *other, int indexLine) {
+        return other->indexLine < indexLine;
+    });
+    while (*it != marker) {
+        ++it;
+    }
+    bucket->markers.erase(it);
+    marker->indexBucket = nullptr;
+
+    if (bucket->markers.empty()) {
+        removeBucket(bucket->index);
+    }
+}
+
+int LineMarkerIndex::line(const ZDocumentLineMarkerPrivate *marker) const {
+    Q_ASSERT(marker->indexBucket);
+    return marker->indexLine + bucketOffset(marker->indexBucket->index);
+}
+
+void LineMarkerIndex::shift(int from, int delta) {
+    if (delta == 0) {
+        return;
+    }
+
+    int bucketIndex = findBucket(from);
+    if (bucketIndex == static_cast<int>(buckets.size())) {
+        return;
+    }
+
+    if (bucketFirstLine(bucketIndex) < from) {
+        // Only a part of this bucket is shifted, adjust these markers directly.
+        LineMarkerIndexBucket *bucket = buckets[bucketIndex].get();
+        const int offset = bucketOffset(bucketIndex);
+        for (ZDocumentLineMarkerPrivate *marker: bucket->markers) {
+            if (marker->indexLine + offset >= from) {
+                marker->indexLine += delta;
+                markChanged(marker);
+            }
+        }
+        bucketIndex++;
+        if (bucketIndex == static_cast<int>(buckets.size())) {
+            return;
+        }
+    }
+
+    for (int i = bucketIndex + 1; i < static_cast<int>(tree.size()); i += i & -i) {
+        tree[i] += delta;
+    }
+    firstShiftedBucket = std::min(firstShiftedBucket, bucketIndex);
+}
+
+void LineMarkerIndex::collapse(int from, int to, int target) {
+    Q_ASSERT(target <= from);
+
+    for (int bucketIndex = findBucket(from); bucketIndex < static_cast<int>(buckets.size()); bucketIndex++) {
+        LineMarkerIndexBucket *bucket = buckets[bucketIndex].get();
+        const int offset = bucketOffset(bucketIndex);
+        for (ZDocumentLineMarkerPrivate *marker: bucket->markers) {
+            const int line = marker->indexLine + offset;
+            if (line > to) {
+                return;
+            }
+            if (line >= from && line != target) {
+                marker->indexLine = target - offset;
+                markChanged(marker);
+            }
+        }
+    }
+}
+
+void LineMarkerIndex::remap(int first, int last, const std::function<int(int)> &map) {
+    // The markers in the range are a contiguous part of the ordered markers. As they stay in the range, they can be
+    // sorted by their new line and written back to the same slots without changing the buckets.
+    struct Slot {
+        LineMarkerIndexBucket *bucket;
+        int position;
+        int offset;
+    };
+    struct Move {
+        int newLine;
+        int oldLine;
+        ZDocumentLineMarkerPrivate *marker;
+    };
+    std::vector<Slot> slots;
+    std::vector<Move> moves;
+
+    for (int bucketIndex = findBucket(first); bucketIndex < static_cast<int>(buckets.size()); bucketIndex++) {
+        LineMarkerIndexBucket *bucket = buckets[bucketIndex].get();
+        const int offset = bucketOffset(bucketIndex);
+        bool done = false;
+        for (int i = 0; i < static_cast<int>(bucket->markers.size()); i++) {
+            ZDocumentLineMarkerPrivate *marker = bucket->markers[i];
+            const int line = marker->indexLine + offset;
+            if (line >= last) {
+                done = true;
+                break;
+            }
+            if (line >= first) {
+                slots.push_back({bucket, i, offset});
+                moves.push_back({map(line), line, marker});
+            }
+        }
+        if (done) {
+            break;
+        }
+    }
+
+    std::stable_sort(moves.begin(), moves.end(), [](const Move &a, const Move &b) {
+        return a.newLine < b.newLine;
+    });
+
+    for (size_t i = 0; i < moves.size(); i++) {
+        const Slot &slot = slots[i];
+        const Move &move = moves[i];
+        Q_ASSERT(first <= move.newLine && move.newLine < last);
+        slot.bucket->markers[slot.position] = move.marker;
+        move.marker->indexBucket = slot.bucket;
+        move.marker->indexLine = move.newLine - slot.offset;
+        if (move.newLine != move.oldLine) {
+            markChanged(move.marker);
+        }
+    }
+}
+
+void LineMarkerIndex::markChanged(ZDocumentLineMarkerPrivate *marker) {
+    if (!marker->changed) {
+        marker->changed = true;
+        changedMarkers.push_back(marker);
+    }
+}
+
+void LineMarkerIndex::dropChanged(ZDocumentLineMarkerPrivate *marker) {
+    if (marker->changed) {
+        changedMarkers.erase(std::remove(changedMarkers.begin(), changedMarkers.end(), marker), changedMarkers.end());
+        marker->changed = false;
+    }
+}
+
+std::vector<ZDocumentLineMarkerPrivate*> LineMarkerIndex::takeChangedMarkers() {
+    for (int i = firstShiftedBucket; i < static_cast<int>(buckets.size()); i++) {
+        for (ZDocumentLineMarkerPrivate *marker: buckets[i]->markers) {
+            markChanged(marker);
+        }
+    }
+    firstShiftedBucket = std::numeric_limits<int>::max();
+
+    std::vector<ZDocumentLineMarkerPrivate*> result;
+    result.swap(changedMarkers);
+    std::sort(result.begin(), result.end(), [](const ZDocumentLineMarkerPrivate *a,
+                                               const ZDocumentLineMarkerPrivate *b) {
+        return a->registrationSerial < b->registrationSerial;
+    });
+    return result;
+}
+
+void LineMarkerIndex::debugConsistencyCheck() const {
+    int previousLine = std::numeric_limits<int>::min();
+    for (int i = 0; i < static_cast<int>(buckets.size()); i++) {
+        const LineMarkerIndexBucket *bucket = buckets[i].get();
+        if (bucket->index != i) {
+            qFatal("LineMarkerIndex::debugConsistencyCheck: Bucket has wrong index");
+        }
+        if (bucket->markers.empty()) {
+            qFatal("LineMarkerIndex::debugConsistencyCheck: Empty bucket");
+        }
+        const int offset = bucketOffset(i);
+        for (const ZDocumentLineMarkerPrivate *marker: bucket->markers) {
+            if (marker->indexBucket != bucket) {
+                qFatal("LineMarkerIndex::debugConsistencyCheck: Marker has wrong bucket");
+            }
+            if (marker->indexLine + offset < previousLine) {
+                qFatal("LineMarkerIndex::debugConsistencyCheck: Markers are not sorted");
+            }
+            previousLine = marker->indexLine + offset;
+        }
+    }
+}
+
+int LineMarkerIndex::bucketOffset(int bucket) const {
+    int sum = 0;
+    for (int i = bucket + 1; i > 0; i -= i & -i) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+int LineMarkerIndex::bucketFirstLine(int bucket) const {
+    return buckets[bucket]->markers.front()->indexLine + bucketOffset(bucket);
+}
+
+int LineMarkerIndex::bucketLastLine(int bucket) const {
+    return buckets[bucket]->markers.back()->indexLine + bucketOffset(bucket);
+}
+
+int LineMarkerIndex::findBucket(int line) const {
+    int low = 0;
+    int high = buckets.size();
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        if (bucketLastLine(mid) < line) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void LineMarkerIndex::splitBucket(int bucket) {
+    std::vector<int> offsets;
+    offsets.reserve(buckets.size() + 1);
+    for (int i = 0; i < static_cast<int>(buckets.size()); i++) {
+        offsets.push_back(bucketOffset(i));
+    }
+    offsets.insert(offsets.begin() + bucket + 1, offsets[bucket]);
+
+    auto newBucket = std::make_unique<LineMarkerIndexBucket>();
+    std::vector<ZDocumentLineMarkerPrivate*> &markers = buckets[bucket]->markers;
+    const auto middle = markers.begin() + markers.size() / 2;
+    newBucket->markers.assign(middle, markers.end());
+    markers.erase(middle, markers.end());
+    for (ZDocumentLineMarkerPrivate *marker: newBucket->markers) {
+        marker->indexBucket = newBucket.get();
+    }
+    buckets.insert(buckets.begin() + bucket + 1, std::move(newBucket));
+
+    if (bucket < firstShiftedBucket && firstShiftedBucket != std::numeric_limits<int>::max()) {
+        firstShiftedBucket++;
+    }
+
+    rebuild(offsets);
+}
+
+void LineMarkerIndex::removeBucket(int bucket) {
+    std::vector<int> offsets;
+    offsets.reserve(buckets.size());
+    for (int i = 0; i < static_cast<int>(buckets.size()); i++) {
+        if (i != bucket) {
+            offsets.push_back(bucketOffset(i));
+        }
+    }
+
+    buckets.erase(buckets.begin() + bucket);
+
+    if (bucket < firstShiftedBucket && firstShiftedBucket != std::numeric_limits<int>::max()) {
+        firstShiftedBucket--;
+    }
+
+    rebuild(offsets);
+}
+
+void LineMarkerIndex::rebuild(const std::vector<int> &offsets) {
+    const int n = buckets.size();
+    for (int i = 0; i < n; i++) {
+        buckets[i]->index = i;
+    }
+
+    tree.assign(n + 1, 0);
+    for (int i = 1; i <= n; i++) {
+        tree[i] = offsets[i - 1] - (i > 1 ? offsets[i - 2] : 0);
+    }
+    for (int i = 1; i <= n; i++) {
+        const int parent = i + (i & -i);
+        if (parent <= n) {
+            tree[parent] += tree[i];
+        }
+    }
+}
+
+TUIWIDGETS_NS_END
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef TUIWIDGETS_ZDOCUMENTLINEMARKERINDEX_P_INCLUDED
+#define TUIWIDGETS_ZDOCUMENTLINEMARKERINDEX_P_INCLUDED
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <Tui/tuiwidgets_internal.h>
+
+TUIWIDGETS_NS_START
+
+class ZDocumentLineMarkerPrivate;
+
+struct LineMarkerIndexBucket {
+    int index = 0;
+    // sorted by indexLine
+    std::vector<ZDocumentLineMarkerPrivate*> markers;
+};
+
+// Line markers of a document ordered by line.
+//
+// Markers are kept in small sorted buckets. Each marker stores its line relative to the offset of its bucket and the
+// offsets are kept as differences in a fenwick tree. Thus shifting all markers on or after a line (i.e. inserting or
+// removing lines) only touches the markers in one bucket and otherwise is a O(log n) update of the offsets. Looking
+// up the line of a marker is O(log n) too.
+//
+// Markers whose line is changed are flagged as changed and collected in a list, so that emitting the change signals
+// only visits changed markers. For markers that are moved by updating the bucket offsets this is deferred until
+// takeChangedMarkers() is called.
+class LineMarkerIndex {
+public:
+    LineMarkerIndex();
+    ~LineMarkerIndex();
+
+public:
+    bool isEmpty() const;
+    int firstLine() const;
+    int lastLine() const;
+
+    void insert(ZDocumentLineMarkerPrivate *marker, int line);
+    void remove(ZDocumentLineMarkerPrivate *marker);
+    int line(const ZDocumentLineMarkerPrivate *marker) const;
+
+    // Adds delta to the line of all markers with a line of at least from. The caller has to ensure that this does not
+    // move markers before markers that are not shifted.
+    void shift(int from, int delta);
+    // Moves all markers with a line in [from, to] to line target, which has to be at most from.
+    void collapse(int from, int to, int target);
+    // Moves all markers with a line in [first, last) to the line returned by map, which has to be in [first, last) too.
+    // Only the markers in the range are touched.
+    void remap(int first, int last, const std::function<int(int)> &map);
+
+    // Sets the changed flag of marker and adds it to the list of changed markers.
+    void markChanged(ZDocumentLineMarkerPrivate *marker);
+    // Clears the changed flag of marker and removes it from the list of changed markers.
+    void dropChanged(ZDocumentLineMarkerPrivate *marker);
+    // Returns all markers flagged as changed (including the markers that where moved by shift() without being touched
+    // individually) ordered by their registration and clears the list. The changed flags stay set.
+    std::vector<ZDocumentLineMarkerPrivate*> takeChangedMarkers();
+
+    void debugConsistencyCheck() const;
+
+private:
+    int bucketOffset(int bucket) const;
+    int bucketFirstLine(int bucket) const;
+    int bucketLastLine(int bucket) const;
+    // Returns the first bucket containing a marker with a line of at least line or buckets.size() if there is none.
+    int findBucket(int line) const;
+    void splitBucket(int bucket);
+    void removeBucket(int bucket);
+    // Rebuilds the offset tree from the given bucket offsets and renumbers the buckets.
+    void rebuild(const std::vector<int> &offsets);
+
+private:
+    std::vector<std::unique_ptr<LineMarkerIndexBucket>> buckets;
+    // 1-based, tree[i] is the sum of the offset differences of the buckets [i - lowest set bit of i, i)
+    std::vector<int> tree;
+    int firstShiftedBucket = std::numeric_limits<int>::max();
+    std::vector<ZDocumentLineMarkerPrivate*> changedMarkers;
+};
+
+TUIWIDGETS_NS_END
+
+#endif // TUIWIDGETS_ZDOCUMENTLINEMARKERINDEX_P_INCLUDED
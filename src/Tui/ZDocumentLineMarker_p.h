@@ -12,6 +12,7 @@
 TUIWIDGETS_NS_START
 
 struct LineMarkerToDocumentTag;
+struct LineMarkerIndexBucket;
 
 
 class ZDocumentLineMarkerPrivate {
@@ -20,12 +21,17 @@ class ZDocumentLineMarkerPrivate {
     ~ZDocumentLineMarkerPrivate();
 
 public:
-    int line = 0;
     ZDocumentPrivate *doc = nullptr;
 
 public: // For use by Document
     ListNode<ZDocumentLineMarkerPrivate> markersList;
+    // increases in the order of markersList, used to emit change signals in registration order
+    quint64 registrationSerial = 0;
+    // set while the marker is in the list of changed markers of the index
     bool changed = false;
+    // position in ZDocumentPrivate::lineMarkerIndex, the line is relative to the offset of the bucket
+    LineMarkerIndexBucket *indexBucket = nullptr;
+    int indexLine = 0;
 
 public:
     ZDocumentLineMarker *pub_ptr;
@@ -0,0 +1,664 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "ZDocumentLineStore_p.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QHash>
+#include <QSet>
+#include <QtGlobal>
+
+TUIWIDGETS_NS_START
+
+namespace {
+    constexpr int maxLeafLines = 64;
+    constexpr int minLeafLines = maxLeafLines / 4;
+    constexpr int maxChildren = 32;
+    constexpr int minChildren = maxChildren / 4;
+
+    bool sameLine(const LineData &a, const LineData &b) {
+        return a.revision == b.revision && a.chars.isSharedWith(b.chars) && a.chars.size() == b.chars.size();
+    }
+}
+
+struct LineStore::Node {
+    bool leaf = true;
+    int count = 0; // number of lines in this subtree
+    QVector<LineData> lines; // only used in leaves
+    QVector<std::shared_ptr<Node>> children; // only used in inner nodes
+
+    int items() const {
+        return leaf ? lines.size() : children.size();
+    }
+
+    int maxItems() const {
+        return leaf ? maxLeafLines : maxChildren;
+    }
+
+    int minItems() const {
+        return leaf ? minLeafLines : minChildren;
+    }
+
+    void recalculateCount() {
+        if (leaf) {
+            count = lines.size();
+        } else {
+            count = 0;
+            for (const auto &child: children) {
+                count += child->count;
+            }
+        }
+    }
+
+    // Translates index into the index of the child containing it and the index relative to that child.
+    int findChild(int *index) const {
+        int i = 0;
+        while (i + 1 < children.size() && *index >= children[i]->count) {
+            *index -= children[i]->count;
+            i++;
+        }
+        return i;
+    }
+};
+
+LineStore::LineStore() = default;
+LineStore::LineStore(const LineStore &other) = default;
+LineStore::LineStore(LineStore &&other) = default;
+LineStore::~LineStore() = default;
+
+LineStore &LineStore::operator=(const LineStore &other) = default;
+LineStore &LineStore::operator=(LineStore &&other) = default;
+
+int LineStore::size() const {
+    return root ? root->count : 0;
+}
+
+bool LineStore::isEmpty() const {
+    return size() == 0;
+}
+
+const LineData &LineStore::at(int index) const {
+    Q_ASSERT(index >= 0 && index < size());
+    const Node *node = root.get();
+    while (!node->leaf) {
+        node = node->children[node->findChild(&index)].get();
+    }
+    return node->lines[index];
+}
+
+const LineData &LineStore::last() const {
+    return at(size() - 1);
+}
+
+LineData &LineStore::modify(int index) {
+    Q_ASSERT(index >= 0 && index < size());
+    Node *node = detach(root);
+    while (!node->leaf) {
+        const int childIndex = node->findChild(&index);
+        node = detach(node->children[childIndex]);
+    }
+    return node->lines[index];
+}
+
+void LineStore::append(LineData line) {
+    insert(size(), std::move(line));
+}
+
+void LineStore::insert(int index, LineData line) {
+    Q_ASSERT(index >= 0 && index <= size());
+    if (!root) {
+        root = std::make_shared<Node>();
+    }
+    std::shared_ptr<Node> sibling = insertRecursive(detach(root), index, std::move(line));
+    if (sibling) {
+        auto newRoot = std::make_shared<Node>();
+        newRoot->leaf = false;
+        newRoot->children.append(root);
+        newRoot->children.append(sibling);
+        newRoot->recalculateCount();
+        root = newRoot;
+    }
+}
+
+void LineStore::insert(int index, const QVector<LineData> &lines) {
+    Q_ASSERT(index >= 0 && index <= size());
+    if (lines.isEmpty()) {
+        return;
+    }
+    if (!root) {
+        root = std::make_shared<Node>();
+    }
+    QVector<std::shared_ptr<Node>> siblings = insertRangeRecursive(detach(root), index, lines);
+    while (!siblings.isEmpty()) {
+        // With many inserted lines even the new root can overflow, then repeat with another level.
+        auto newRoot = std::make_shared<Node>();
+        newRoot->leaf = false;
+        newRoot->children.append(root);
+        newRoot->children.append(siblings);
+        newRoot->recalculateCount();
+        root = newRoot;
+        siblings = newRoot->items() > newRoot->maxItems() ? splitEvenly(newRoot.get())
+                                                          : QVector<std::shared_ptr<Node>>();
+    }
+}
+
+void LineStore::remove(int index, int count) {
+    Q_ASSERT(index >= 0 && count >= 0 && index + count <= size());
+    if (count <= 0) {
+        return;
+    }
+    if (index == 0 && count == size()) {
+        clear();
+        return;
+    }
+    removeRecursive(detach(root), index, count);
+    while (!root->leaf && root->children.size() == 1) {
+        std::shared_ptr<Node> child = root->children[0];
+        root = child;
+    }
+}
+
+void LineStore::removeLast() {
+    remove(size() - 1);
+}
+
+void LineStore::clear() {
+    root.reset();
+}
+
+LineStore::Node *LineStore::detach(std::shared_ptr<Node> &node) {
+    // A use count of 1 can not increase concurrently, as only the owner of the reference could create copies.
+    if (node.use_count() != 1) {
+        node = std::make_shared<Node>(*node);
+    }
+    return node.get();
+}
+
+qint64 LineStore::nodeBytes(const Node *node) {
+    // The item vector of a copied node is detached on the first modification, so count it as well.
+    if (node->leaf) {
+        return sizeof(Node) + node->lines.size() * static_cast<qint64>(sizeof(LineData));
+    } else {
+        return sizeof(Node) + node->children.size() * static_cast<qint64>(sizeof(std::shared_ptr<Node>));
+    }
+}
+
+std::shared_ptr<LineStore::Node> LineStore::insertRecursive(Node *node, int index, LineData &&line) {
+    node->count++;
+    if (node->leaf) {
+        node->lines.insert(index, std::move(line));
+    } else {
+        const int childIndex = node->findChild(&index);
+        std::shared_ptr<Node> sibling = insertRecursive(detach(node->children[childIndex]), index, std::move(line));
+        if (sibling) {
+            node->children.insert(childIndex + 1, sibling);
+        }
+    }
+
+    if (node->items() > node->maxItems()) {
+        return split(node);
+    }
+    return nullptr;
+}
+
+QVector<std::shared_ptr<LineStore::Node>> LineStore::insertRangeRecursive(Node *node, int index,
+                                                                         const QVector<LineData> &lines) {
+    node->count += lines.size();
+    if (node->leaf) {
+        QVector<LineData> merged;
+        merged.reserve(node->lines.size() + lines.size());
+        merged.append(node->lines.mid(0, index));
+        merged.append(lines);
+        merged.append(node->lines.mid(index));
+        node->lines = std::move(merged);
+    } else {
+        const int childIndex = node->findChild(&index);
+        const QVector<std::shared_ptr<Node>> siblings = insertRangeRecursive(detach(node->children[childIndex]),
+                                                                             index, lines);
+        if (!siblings.isEmpty()) {
+            node->children = node->children.mid(0, childIndex + 1) + siblings + node->children.mid(childIndex + 1);
+        }
+    }
+
+    if (node->items() > node->maxItems()) {
+        return splitEvenly(node);
+    }
+    return {};
+}
+
+void LineStore::removeRecursive(Node *node, int index, int count) {
+    node->count -= count;
+    if (node->leaf) {
+        node->lines.remove(index, count);
+        return;
+    }
+
+    int childIndex = node->findChild(&index);
+    const int firstTouched = childIndex;
+    while (count > 0) {
+        const int childCount = node->children[childIndex]->count;
+        const int toRemove = std::min(count, childCount - index);
+        if (index == 0 && toRemove == childCount) {
+            // whole subtree
+            node->children.remove(childIndex);
+        } else {
+            removeRecursive(detach(node->children[childIndex]), index, toRemove);
+            childIndex++;
+        }
+        count -= toRemove;
+        index = 0;
+    }
+
+    // Only the partially touched children at the start and end of the removed range can be too small now, after
+    // removing the fully covered children in between they are adjacent.
+    for (int i = std::min(childIndex, node->children.size() - 1); i >= firstTouched && i >= 0; i--) {
+        if (i < node->children.size()) {
+            fixUnderflow(node, i);
+        }
+    }
+}
+
+void LineStore::fixUnderflow(Node *node, int childIndex) {
+    if (node->children.size() < 2) {
+        return;
+    }
+    if (node->children[childIndex]->items() >= node->children[childIndex]->minItems()) {
+        return;
+    }
+
+    const int leftIndex = childIndex > 0 ? childIndex - 1 : childIndex;
+    Node *left = detach(node->children[leftIndex]);
+    Node *right = detach(node->children[leftIndex + 1]);
+
+    if (left->items() + right->items() <= left->maxItems()) {
+        if (left->leaf) {
+            left->lines.append(right->lines);
+        } else {
+            left->children.append(right->children);
+        }
+        left->count += right->count;
+        node->children.remove(leftIndex + 1);
+    } else {
+        redistribute(left, right);
+    }
+}
+
+void LineStore::redistribute(Node *left, Node *right) {
+    const int total = left->items() + right->items();
+    const int leftItems = total / 2;
+    if (left->leaf) {
+        QVector<LineData> all = left->lines + right->lines;
+        left->lines = all.mid(0, leftItems);
+        right->lines = all.mid(leftItems);
+    } else {
+        QVector<std::shared_ptr<Node>> all = left->children + right->children;
+        left->children = all.mid(0, leftItems);
+        right->children = all.mid(leftItems);
+    }
+    left->recalculateCount();
+    right->recalculateCount();
+}
+
+std::shared_ptr<LineStore::Node> LineStore::split(Node *node) {
+    auto sibling = std::make_shared<Node>();
+    sibling->leaf = node->leaf;
+    const int keep = node->items() / 2;
+    if (node->leaf) {
+        sibling->lines = node->lines.mid(keep);
+        node->lines.resize(keep);
+    } else {
+        sibling->children = node->children.mid(keep);
+        node->children.resize(keep);
+    }
+    node->recalculateCount();
+    sibling->recalculateCount();
+    return sibling;
+}
+
+QVector<std::shared_ptr<LineStore::Node>> LineStore::splitEvenly(Node *node) {
+    // Splits an overfull node into as few nodes as possible. As all parts get about the same number of items, each
+    // part is at least half full.
+    const int items = node->items();
+    const int parts = (items + node->maxItems() - 1) / node->maxItems();
+    QVector<std::shared_ptr<Node>> siblings;
+    int start = items;
+    for (int part = parts - 1; part > 0; part--) {
+        const int partStart = static_cast<int>(static_cast<qint64>(items) * part / parts);
+        auto sibling = std::make_shared<Node>();
+        sibling->leaf = node->leaf;
+        if (node->leaf) {
+            sibling->lines = node->lines.mid(partStart, start - partStart);
+        } else {
+            sibling->children = node->children.mid(partStart, start - partStart);
+        }
+        sibling->recalculateCount();
+        siblings.prepend(sibling);
+        start = partStart;
+    }
+    if (node->leaf) {
+        node->lines.resize(start);
+    } else {
+        node->children.resize(start);
+    }
+    node->recalculateCount();
+    return siblings;
+}
+
+LineStore LineStore::build(const QVector<QVector<LineData>> &chunks) {
+    LineStore result;
+
+    // Fill leaves completely, level by level. Only the last node of each level can be underfull and then gets
+    // balanced with its predecessor.
+    QVector<std::shared_ptr<Node>> level;
+    std::shared_ptr<Node> current;
+    for (const QVector<LineData> &chunk: chunks) {
+        for (const LineData &line: chunk) {
+            if (!current || current->lines.size() == maxLeafLines) {
+                current = std::make_shared<Node>();
+                current->lines.reserve(maxLeafLines);
+                level.append(current);
+            }
+            current->lines.append(line);
+        }
+    }
+
+    if (level.isEmpty()) {
+        return result;
+    }
+
+    while (true) {
+        for (const auto &node: level) {
+            node->recalculateCount();
+        }
+        if (level.size() > 1 && level.last()->items() < level.last()->minItems()) {
+            redistribute(level[level.size() - 2].get(), level.last().get());
+        }
+        if (level.size() == 1) {
+            break;
+        }
+
+        QVector<std::shared_ptr<Node>> parents;
+        for (const auto &node: level) {
+            if (parents.isEmpty() || parents.last()->children.size() == maxChildren) {
+                auto parent = std::make_shared<Node>();
+                parent->leaf = false;
+                parents.append(parent);
+            }
+            parents.last()->children.append(node);
+        }
+        level = std::move(parents);
+    }
+
+    result.root = level.first();
+    return result;
+}
+
+const LineStore::Node *LineStore::findLeaf(const Node *node, int *index, bool fromEnd, NodePath *aligned) {
+    // Collects the nodes on the path whose first (or last if fromEnd) line is the line at index.
+    aligned->clear();
+    while (true) {
+        if (*index == (fromEnd ? node->count - 1 : 0)) {
+            aligned->append(node);
+        }
+        if (node->leaf) {
+            return node;
+        }
+        node = node->children[node->findChild(index)].get();
+    }
+}
+
+void LineStore::commonPrefixAndSuffix(const LineStore &a, const LineStore &b, int *prefix, int *suffix) {
+    const int limit = std::min(a.size(), b.size());
+    NodePath alignedA;
+    NodePath alignedB;
+
+    // Returns the number of lines covered by the largest subtree that is aligned in both stores, or 0.
+    auto sharedSubtree = [&] {
+        for (const Node *node: alignedA) {
+            if (std::find(alignedB.begin(), alignedB.end(), node) != alignedB.end()) {
+                return node->count;
+            }
+        }
+        return 0;
+    };
+
+    int commonStart = 0;
+    while (commonStart < limit) {
+        int indexA = commonStart;
+        int indexB = commonStart;
+        const Node *leafA = findLeaf(a.root.get(), &indexA, false, &alignedA);
+        const Node *leafB = findLeaf(b.root.get(), &indexB, false, &alignedB);
+        if (const int count = sharedSubtree()) {
+            commonStart += count;
+            continue;
+        }
+        const int before = commonStart;
+        while (indexA < leafA->lines.size() && indexB < leafB->lines.size()
+               && sameLine(leafA->lines[indexA], leafB->lines[indexB])) {
+            indexA++;
+            indexB++;
+            commonStart++;
+        }
+        if (commonStart == before || (indexA < leafA->lines.size() && indexB < leafB->lines.size())) {
+            break;
+        }
+    }
+    commonStart = std::min(commonStart, limit);
+
+    const int suffixLimit = limit - commonStart;
+    int commonEnd = 0;
+    while (commonEnd < suffixLimit) {
+        int indexA = a.size() - 1 - commonEnd;
+        int indexB = b.size() - 1 - commonEnd;
+        const Node *leafA = findLeaf(a.root.get(), &indexA, true, &alignedA);
+        const Node *leafB = findLeaf(b.root.get(), &indexB, true, &alignedB);
+        if (const int count = sharedSubtree()) {
+            commonEnd += count;
+            continue;
+        }
+        const int before = commonEnd;
+        while (indexA >= 0 && indexB >= 0 && commonEnd < suffixLimit
+               && sameLine(leafA->lines[indexA], leafB->lines[indexB])) {
+            indexA--;
+            indexB--;
+            commonEnd++;
+        }
+        if (commonEnd == before || (indexA >= 0 && indexB >= 0)) {
+            break;
+        }
+    }
+
+    *prefix = commonStart;
+    *suffix = std::min(commonEnd, suffixLimit);
+}
+
+void LineStore::matchSubtrees(const LineStore &a, const LineStore &b, std::vector<SharedSubtree> *shared,
+                              std::vector<const Node*> *unsharedA, std::vector<const Node*> *unsharedB) {
+    struct Item {
+        const Node *node;
+        int start;
+        int height;
+    };
+
+    auto height = [](const Node *node) {
+        int result = 0;
+        while (!node->leaf) {
+            node = node->children.first().get();
+            result++;
+        }
+        return result;
+    };
+
+    auto rootItems = [&](const LineStore &store) {
+        std::vector<Item> result;
+        if (store.root) {
+            result.push_back({store.root.get(), 0, height(store.root.get())});
+        }
+        return result;
+    };
+
+    std::vector<Item> frontierA = rootItems(a);
+    std::vector<Item> frontierB = rootItems(b);
+
+    // Both frontiers cover their store completely. Nodes contained in both are shared subtrees and are removed, the
+    // remaining nodes are replaced by their children, highest nodes first. As a node can only be shared with a node of
+    // the same height, this finds all shared subtrees while only expanding nodes that are not shared.
+    while (!frontierA.empty() || !frontierB.empty()) {
+        QHash<const Node*, int> indexInB;
+        for (int i = 0; i < static_cast<int>(frontierB.size()); i++) {
+            indexInB.insert(frontierB[i].node, i);
+        }
+        std::vector<bool> sharedInB(frontierB.size(), false);
+
+        std::vector<Item> remainingA;
+        for (const Item &item: frontierA) {
+            const auto it = indexInB.constFind(item.node);
+            if (it != indexInB.constEnd()) {
+                if (shared) {
+                    shared->push_back({item.start, frontierB[*it].start, item.node->count});
+                }
+                sharedInB[*it] = true;
+            } else {
+                remainingA.push_back(item);
+            }
+        }
+        std::vector<Item> remainingB;
+        for (int i = 0; i < static_cast<int>(frontierB.size()); i++) {
+            if (!sharedInB[i]) {
+                remainingB.push_back(frontierB[i]);
+            }
+        }
+
+        int maxHeight = 0;
+        for (const Item &item: remainingA) {
+            maxHeight = std::max(maxHeight, item.height);
+        }
+        for (const Item &item: remainingB) {
+            maxHeight = std::max(maxHeight, item.height);
+        }
+
+        auto expand = [maxHeight](const std::vector<Item> &items, std::vector<const Node*> *unshared) {
+            std::vector<Item> result;
+            for (const Item &item: items) {
+                if (item.height != maxHeight) {
+                    result.push_back(item);
+                    continue;
+                }
+                if (unshared) {
+                    unshared->push_back(item.node);
+                }
+                int start = item.start;
+                for (const auto &child: item.node->children) {
+                    result.push_back({child.get(), start, item.height - 1});
+                    start += child->count;
+                }
+            }
+            return result;
+        };
+        if (maxHeight == 0) {
+            // Only unshared leaves remain.
+            expand(remainingA, unsharedA);
+            expand(remainingB, unsharedB);
+            break;
+        }
+        frontierA = expand(remainingA, unsharedA);
+        frontierB = expand(remainingB, unsharedB);
+    }
+}
+
+QVector<LineStore::Difference> LineStore::differences(const LineStore &a, const LineStore &b) {
+    std::vector<SharedSubtree> shared;
+    matchSubtrees(a, b, &shared, nullptr, nullptr);
+
+    std::sort(shared.begin(), shared.end(), [](const SharedSubtree &x, const SharedSubtree &y) {
+        return x.startA < y.startA;
+    });
+
+    // Modifications never reorder nodes, so the shared subtrees are in the same order in both stores and the lines
+    // between them are the differences.
+    QVector<Difference> result;
+    int posA = 0;
+    int posB = 0;
+    for (const SharedSubtree &item: shared) {
+        if (item.startB < posB) {
+            // Not expected, but then report everything as changed instead of wrong differences.
+            return {{0, a.size(), 0, b.size()}};
+        }
+        if (item.startA > posA || item.startB > posB) {
+            result.append({posA, item.startA - posA, posB, item.startB - posB});
+        }
+        posA = item.startA + item.count;
+        posB = item.startB + item.count;
+    }
+    if (posA < a.size() || posB < b.size()) {
+        result.append({posA, a.size() - posA, posB, b.size() - posB});
+    }
+    return result;
+}
+
+qint64 LineStore::unsharedBytes(const LineStore &store, const LineStore &base) {
+    std::vector<const Node*> unshared;
+    std::vector<const Node*> unsharedBase;
+    matchSubtrees(store, base, nullptr, &unshared, &unsharedBase);
+
+    // Lines in copied leaves mostly still share their text with the lines in the leaves they were copied from.
+    QSet<const QChar*> baseText;
+    for (const Node *node: unsharedBase) {
+        for (const LineData &line: node->lines) {
+            baseText.insert(line.chars.constData());
+        }
+    }
+
+    qint64 result = 0;
+    for (const Node *node: unshared) {
+        result += nodeBytes(node);
+        for (const LineData &line: node->lines) {
+            if (!baseText.contains(line.chars.constData())) {
+                result += line.chars.size() * static_cast<qint64>(sizeof(QChar));
+            }
+        }
+    }
+    return result;
+}
+
+void LineStore::debugConsistencyCheck() const {
+    if (!root) {
+        return;
+    }
+    int leafDepth = -1;
+    if (debugCheckNode(root.get(), 0, &leafDepth) != root->count) {
+        qFatal("LineStore::debugConsistencyCheck: Line count of root does not match");
+    }
+}
+
+int LineStore::debugCheckNode(const Node *node, int depth, int *leafDepth) {
+    if (node->leaf) {
+        if (*leafDepth == -1) {
+            *leafDepth = depth;
+        } else if (*leafDepth != depth) {
+            qFatal("LineStore::debugConsistencyCheck: Leaves at different depths");
+        }
+        if (node->count != node->lines.size()) {
+            qFatal("LineStore::debugConsistencyCheck: Line count of leaf does not match");
+        }
+        if (node->lines.size() > maxLeafLines) {
+            qFatal("LineStore::debugConsistencyCheck: Leaf too large");
+        }
+        return node->count;
+    }
+
+    if (node->children.isEmpty() || node->children.size() > maxChildren) {
+        qFatal("LineStore::debugConsistencyCheck: Invalid number of children");
+    }
+    int count = 0;
+    for (const auto &child: node->children) {
+        count += debugCheckNode(child.get(), depth + 1, leafDepth);
+    }
+    if (count != node->count) {
+        qFatal("LineStore::debugConsistencyCheck: Line count of inner node does not match");
+    }
+    return count;
+}
+
+TUIWIDGETS_NS_END
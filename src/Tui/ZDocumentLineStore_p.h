@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef TUIWIDGETS_ZDOCUMENTLINESTORE_P_INCLUDED
+#define TUIWIDGETS_ZDOCUMENTLINESTORE_P_INCLUDED
+
+#include <memory>
+#include <vector>
+
+#include <QString>
+#include <QtGlobal>
+#include <QVarLengthArray>
+#include <QVector>
+
+#include <Tui/tuiwidgets_internal.h>
+
+TUIWIDGETS_NS_START
+
+class ZDocumentLineUserData;
+
+struct LineData {
+    QString chars;
+    unsigned revision = 0;
+    std::shared_ptr<ZDocumentLineUserData> userData;
+};
+
+// Storage for the lines of a document.
+//
+// Lines are kept in the leaves of a b-tree like structure where each node knows the number of lines below it.
+// Thus looking up, inserting and removing lines are O(log n) operations.
+// Copies share all nodes and are cheap. Modifications copy the nodes on the path to the modified line if they are
+// shared (similar to the implicit sharing of Qt's containers), so copies can be used as snapshots and be read from
+// other threads.
+class LineStore {
+public:
+    LineStore();
+    LineStore(const LineStore &other);
+    LineStore(LineStore &&other);
+    ~LineStore();
+
+    LineStore &operator=(const LineStore &other);
+    LineStore &operator=(LineStore &&other);
+
+public:
+    int size() const;
+    bool isEmpty() const;
+
+    const LineData &at(int index) const;
+    const LineData &operator[](int index) const { return at(index); }
+    const LineData &last() const;
+
+    // Returns a modifiable reference, only valid until the next modification of the store or a copy of it is made.
+    LineData &modify(int index);
+
+    void append(LineData line);
+    void insert(int index, LineData line);
+    // Inserts all of lines before index. Descends the tree only once, so this is much faster than inserting the lines
+    // one by one.
+    void insert(int index, const QVector<LineData> &lines);
+    void remove(int index, int count = 1);
+    void removeLast();
+    void clear();
+
+    // Builds a store from the concatenation of the given lines. This is much faster than appending the lines one
+    // by one, as the nodes are filled directly.
+    static LineStore build(const QVector<QVector<LineData>> &chunks);
+
+    // Determines the number of unchanged lines at the start and end of b compared to a. Lines are unchanged if they
+    // have the same revision and share their text. As stores derived from each other share all nodes that were not
+    // modified, shared subtrees are skipped as a whole and the cost mostly depends on the number of modified nodes.
+    // prefix + suffix is at most the size of the smaller store.
+    static void commonPrefixAndSuffix(const LineStore &a, const LineStore &b, int *prefix, int *suffix);
+
+    // A range of lines of a that is replaced by a range of lines of b, see differences().
+    struct Difference {
+        int startA = 0;
+        int countA = 0;
+        int startB = 0;
+        int countB = 0;
+    };
+
+    // Determines the ranges in which a and b differ, ordered by their position. Subtrees shared by both stores are
+    // skipped as a whole wherever they are, so the cost depends on the number of modified nodes and not on the size
+    // of the stores, even for modifications in many places. The ranges cover whole leaves, so they can contain some
+    // unchanged lines too.
+    static QVector<Difference> differences(const LineStore &a, const LineStore &b);
+
+    // Returns an estimate of the memory used by store that is not shared with base, i.e. the nodes not shared with
+    // base and the text of their lines that is not shared with the corresponding nodes of base.
+    static qint64 unsharedBytes(const LineStore &store, const LineStore &base);
+
+    void debugConsistencyCheck() const;
+
+private:
+    struct Node;
+
+    Node *detach(std::shared_ptr<Node> &node);
+    std::shared_ptr<Node> insertRecursive(Node *node, int index, LineData &&line);
+    void removeRecursive(Node *node, int index, int count);
+    void fixUnderflow(Node *node, int childIndex);
+    QVector<std::shared_ptr<Node>> insertRangeRecursive(Node *node, int index, const QVector<LineData> &lines);
+    std::shared_ptr<Node> split(Node *node);
+    QVector<std::shared_ptr<Node>> splitEvenly(Node *node);
+    static void redistribute(Node *left, Node *right);
+    static qint64 nodeBytes(const Node *node);
+    using NodePath = QVarLengthArray<const Node*, 16>;
+    static const Node *findLeaf(const Node *node, int *index, bool fromEnd, NodePath *aligned);
+    static int debugCheckNode(const Node *node, int depth, int *leafDepth);
+    struct SharedSubtree {
+        int startA;
+        int startB;
+        int count;
+    };
+    // Finds the subtrees shared by a and b and the nodes of each store that are not shared.
+    static void matchSubtrees(const LineStore &a, const LineStore &b, std::vector<SharedSubtree> *shared,
+                              std::vector<const Node*> *unsharedA, std::vector<const Node*> *unsharedB);
+
+private:
+    std::shared_ptr<Node> root;
+};
+
+TUIWIDGETS_NS_END
+
+#endif // TUIWIDGETS_ZDOCUMENTLINESTORE_P_INCLUDED
@@ -14,7 +14,7 @@ class ZDocumentSnapshotPrivate {
 
 public:
     unsigned revision = -1;
-    QVector<LineData> lines;
+    LineStore lines;
     std::shared_ptr<std::atomic<unsigned>> revisionShared;
 };
 
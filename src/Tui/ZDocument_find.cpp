@@ -3,12 +3,20 @@
 #include <Tui/ZDocument.h>
 #include <Tui/ZDocument_p.h>
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <optional>
 #include <variant>
+#include <vector>
 
+#include <QHash>
+#include <QSemaphore>
 #include <QThreadPool>
 #include <Qt>
 
 #include <Tui/ZDocumentSnapshot.h>
+#include <Tui/ZDocumentSnapshot_p.h>
 
 TUIWIDGETS_NS_START
 
@@ -82,9 +90,62 @@ namespace {
         return false;
     }
 
-    template <typename CANCEL>
-    static ZDocumentFindAsyncResult snapshotSearchForwardRegex(ZDocumentSnapshot snap, SearchParameter search, CANCEL &canceler) {
+    // Conservative check if the regular expression can only match text within a single line. False negatives only
+    // cost performance, so everything that is not obviously confined to one line is rejected.
+    bool isSingleLineRegex(const QRegularExpression &regex) {
+        if (regex.patternOptions() & (QRegularExpression::PatternOption::DotMatchesEverythingOption
+                                      | QRegularExpression::PatternOption::ExtendedPatternSyntaxOption)) {
+            return false;
+        }
 
+        const QString pattern = regex.pattern();
+        bool inClass = false;
+        for (int i = 0; i < pattern.size(); i++) {
+            const QChar ch = pattern[i];
+            const QChar next = i + 1 < pattern.size() ? pattern[i + 1] : QChar();
+            if (ch.unicode() < 0x20) {
+                // literal line break or other control character
+                return false;
+            } else if (ch == QLatin1Char('\\')) {
+                // Only escaped punctuation and some classes that never match a line break are accepted.
+                if (next.isNull()) {
+                    return false;
+                }
+                if (next.isLetterOrNumber() && next != QLatin1Char('d') && next != QLatin1Char('w')
+                        && next != QLatin1Char('b') && next != QLatin1Char('B')) {
+                    return false;
+                }
+                i++;
+            } else if (inClass) {
+                if (ch == QLatin1Char('[')) {
+                    // posix classes like [:space:]
+                    return false;
+                } else if (ch == QLatin1Char(']')) {
+                    inClass = false;
+                }
+            } else if (ch == QLatin1Char('[')) {
+                if (next == QLatin1Char('^')) {
+                    // negated classes match line breaks
+                    return false;
+                }
+                inClass = true;
+                if (next == QLatin1Char(']')) {
+                    // literal ] as first character of the class
+                    i++;
+                }
+            } else if (ch == QLatin1Char('(') && (next == QLatin1Char('?') || next == QLatin1Char('*'))) {
+                // only non capturing groups, other constructs can change options or look beyond the match
+                if (next == QLatin1Char('?') && i + 2 < pattern.size() && pattern[i + 2] == QLatin1Char(':')) {
+                    i += 2;
+                } else {
+                    return false;
+                }
+            }
+        }
+        return !inClass;
+    }
+
+    QRegularExpression forwardSearchRegex(const SearchParameter &search) {
         auto regex = std::get<QRegularExpression>(search.needle);
         if ((regex.patternOptions() & QRegularExpression::PatternOption::MultilineOption) == 0) {
             regex.setPatternOptions(regex.patternOptions() | QRegularExpression::PatternOption::MultilineOption);
@@ -93,6 +154,13 @@ namespace {
                 (search.caseSensitivity == Qt::CaseInsensitive)) {
             regex.setPatternOptions(regex.patternOptions() ^ QRegularExpression::PatternOption::CaseInsensitiveOption);
         }
+        return regex;
+    }
+
+    template <typename CANCEL>
+    static ZDocumentFindAsyncResult snapshotSearchForwardRegex(ZDocumentSnapshot snap, SearchParameter search, CANCEL &canceler) {
+
+        const QRegularExpression regex = forwardSearchRegex(search);
 
         int line = search.startAtLine;
         int found = search.startCodeUnit - 1;
@@ -471,6 +539,168 @@ namespace {
         }
     }
 
+    // Forward searches for needles that can only match within a single line are split into ranges of lines which
+    // are searched concurrently. The result is the first match of the first range (in search order) that has one.
+    constexpr int parallelSearchLinesPerRange = 16384;
+
+    struct SearchRange {
+        int firstLine = 0;
+        int endLine = 0;
+        int startCodeUnit = 0; // only applies to firstLine
+    };
+
+    struct ParallelSearchState {
+        ZDocumentSnapshot snap;
+        SearchParameter search;
+        QRegularExpression regex; // only used for regular expression searches
+        std::vector<SearchRange> ranges;
+        std::vector<std::optional<ZDocumentFindAsyncResult>> results;
+        std::atomic<int> nextRange { 0 };
+        std::atomic<int> firstRangeWithMatch { std::numeric_limits<int>::max() };
+        QSemaphore helpersDone;
+    };
+
+    bool canSearchInParallel(const ZDocumentSnapshot &snap, const SearchParameter &search) {
+        if (snap.lineCount() < 2 * parallelSearchLinesPerRange) {
+            return false;
+        }
+        if (std::holds_alternative<QRegularExpression>(search.needle)) {
+            return isSingleLineRegex(std::get<QRegularExpression>(search.needle));
+        } else {
+            return !std::get<QString>(search.needle).contains(QLatin1Char('\n'));
+        }
+    }
+
+    template <typename CANCEL>
+    std::optional<ZDocumentFindAsyncResult> searchRange(ParallelSearchState &state, int rangeIndex, CANCEL &canceler) {
+        const ZDocumentSnapshot &snap = state.snap;
+        const SearchRange &range = state.ranges[rangeIndex];
+        const bool regularExpressionMode = std::holds_alternative<QRegularExpression>(state.search.needle);
+
+        int from = range.startCodeUnit;
+        for (int line = range.firstLine; line < range.endLine; line++) {
+            if (canceler.isCanceled() || rangeIndex > state.firstRangeWithMatch.load(std::memory_order_relaxed)) {
+                return std::nullopt;
+            }
+
+            if (regularExpressionMode) {
+                // Same matching as in snapshotSearchForwardRegex, the needle can not match the line break.
+                QString buffer = snap.line(line);
+                replaceInvalidUtf16ForRegexSearch(buffer, 0);
+                if (line + 1 < snap.lineCount()) {
+                    buffer += QStringLiteral("\n");
+                }
+                QRegularExpressionMatchIterator remi
+                        = state.regex.globalMatch(buffer, 0, QRegularExpression::MatchType::NormalMatch,
+                                                  QRegularExpression::MatchOption::DontCheckSubjectStringMatchOption);
+                while (remi.hasNext()) {
+                    QRegularExpressionMatch match = remi.next();
+                    if (match.capturedLength() <= 0) continue;
+                    if (match.capturedStart() < from) continue;
+                    return ZDocumentFindAsyncResultNew({match.capturedStart(), line},
+                                                       {match.capturedStart() + match.capturedLength(), line},
+                                                       snap.revision(),
+                                                       match);
+                }
+            } else {
+                const QString &needle = std::get<QString>(state.search.needle);
+                const int found = snap.line(line).indexOf(needle, from, state.search.caseSensitivity);
+                if (found != -1) {
+                    return ZDocumentFindAsyncResultNew({found, line},
+                                                       {found + needle.size(), line},
+                                                       snap.revision(),
+                                                       QRegularExpressionMatch{});
+                }
+            }
+            from = 0;
+        }
+        return std::nullopt;
+    }
+
+    template <typename CANCEL>
+    void searchRanges(ParallelSearchState &state, CANCEL &canceler) {
+        while (true) {
+            const int rangeIndex = state.nextRange.fetch_add(1);
+            if (rangeIndex >= static_cast<int>(state.ranges.size())
+                    || rangeIndex > state.firstRangeWithMatch.load(std::memory_order_relaxed)) {
+                return;
+            }
+            std::optional<ZDocumentFindAsyncResult> res = searchRange(state, rangeIndex, canceler);
+            if (res) {
+                state.results[rangeIndex] = std::move(res);
+                int current = state.firstRangeWithMatch.load();
+                while (rangeIndex < current && !state.firstRangeWithMatch.compare_exchange_weak(current, rangeIndex)) {
+                    // retry
+                }
+            }
+        }
+    }
+
+    template <typename CANCEL>
+    class SearchRangesOnThread : public QRunnable {
+    public:
+        SearchRangesOnThread(ParallelSearchState *state, CANCEL *canceler) : state(state), canceler(canceler) {
+        }
+
+        void run() override {
+            searchRanges(*state, *canceler);
+            state->helpersDone.release();
+        }
+
+    private:
+        ParallelSearchState *state;
+        CANCEL *canceler;
+    };
+
+    template <typename CANCEL>
+    ZDocumentFindAsyncResult snapshotSearchForwardParallel(QThreadPool *pool, ZDocumentSnapshot snap,
+                                                           SearchParameter search, CANCEL &canceler) {
+        ParallelSearchState state;
+        state.snap = snap;
+        state.search = search;
+        if (std::holds_alternative<QRegularExpression>(search.needle)) {
+            state.regex = forwardSearchRegex(search);
+            state.regex.optimize();
+        }
+
+        auto addRanges = [&](int first, int end, int startCodeUnit) {
+            for (int line = first; line < end; line += parallelSearchLinesPerRange) {
+                state.ranges.push_back({line, std::min(line + parallelSearchLinesPerRange, end),
+                                        line == first ? startCodeUnit : 0});
+            }
+        };
+        addRanges(search.startAtLine, snap.lineCount(), search.startCodeUnit);
+        if (search.searchWrap) {
+            addRanges(0, std::min(search.startAtLine + 1, snap.lineCount()), 0);
+        }
+        state.results.resize(state.ranges.size());
+
+        // Only start helpers if threads are available right now. This thread works on the ranges too, so the search
+        // completes even if the pool is busy.
+        int helpers = 0;
+        const int maxHelpers = std::min<int>(pool->maxThreadCount(), state.ranges.size()) - 1;
+        while (helpers < maxHelpers) {
+            auto *helper = new SearchRangesOnThread<CANCEL>(&state, &canceler);
+            if (!pool->tryStart(helper)) {
+                delete helper;
+                break;
+            }
+            helpers++;
+        }
+
+        searchRanges(state, canceler);
+        state.helpersDone.acquire(helpers);
+
+        if (canceler.isCanceled()) {
+            return noMatch(snap);
+        }
+        const int firstRangeWithMatch = state.firstRangeWithMatch.load();
+        if (firstRangeWithMatch < static_cast<int>(state.results.size())) {
+            return *state.results[firstRangeWithMatch];
+        }
+        return noMatch(snap);
+    }
+
     SearchParameter prepareSearchParameter(const ZDocument *doc, const ZDocumentCursor &start, ZDocument::FindFlags options) {
         SearchParameter res;
 
@@ -518,6 +748,8 @@ namespace {
             ZDocumentFindAsyncResult res = noMatch(snap);
             if (backwards) {
                 res = snapshotSearchBackwards(snap, param, promise);
+            } else if (pool && canSearchInParallel(snap, param)) {
+                res = snapshotSearchForwardParallel(pool, snap, param, promise);
             } else {
                 res = snapshotSearchForward(snap, param, promise);
             }
@@ -532,7 +764,232 @@ namespace {
         ZDocumentSnapshot snap;
         SearchParameter param;
         bool backwards = false;
+        QThreadPool *pool = nullptr;
     };
+
+    QVector<ZDocumentMatchIndex::Match> findAllInLine(const QString &text, const ZDocumentMatchIndexPrivate &index,
+                                                      const QRegularExpression &regex) {
+        QVector<ZDocumentMatchIndex::Match> matches;
+        if (std::holds_alternative<QString>(index.needle)) {
+            const QString &needle = std::get<QString>(index.needle);
+            int found = text.indexOf(needle, 0, index.caseSensitivity);
+            while (found != -1) {
+                matches.append({found, needle.size()});
+                found = text.indexOf(needle, found + needle.size(), index.caseSensitivity);
+            }
+        } else {
+            QString buffer = text;
+            replaceInvalidUtf16ForRegexSearch(buffer, 0);
+            QRegularExpressionMatchIterator remi = regex.globalMatch(buffer);
+            while (remi.hasNext()) {
+                QRegularExpressionMatch match = remi.next();
+                if (match.capturedLength() <= 0) continue;
+                matches.append({match.capturedStart(), match.capturedLength()});
+            }
+        }
+        return matches;
+    }
+
+    bool isSameLine(const LineData &a, const LineData &b) {
+        // Line revisions are not unique for new lines, so the lines also need to share their text. As the index keeps
+        // the snapshot it was built from, the text data can not have been reused for a different line.
+        return a.revision == b.revision && a.chars.constData() == b.chars.constData() && a.chars.size() == b.chars.size();
+    }
+
+    int indexEntryMatchCount(const LineData &entry) {
+        if (!entry.userData) {
+            return 0;
+        }
+        return static_cast<const ZDocumentMatchIndexPrivate::LineMatches*>(entry.userData.get())->matches.size();
+    }
+
+    template <typename CANCEL>
+    std::optional<ZDocumentMatchIndex> snapshotFindAll(ZDocumentSnapshot snap, ZDocumentMatchIndex result,
+                                                       const ZDocumentMatchIndex &previous, CANCEL &canceler) {
+        auto *const p = ZDocumentMatchIndexPrivate::get(&result);
+        const auto *const prev = ZDocumentMatchIndexPrivate::get(&previous);
+
+        QRegularExpression regex;
+        if (std::holds_alternative<QRegularExpression>(p->needle)) {
+            regex = std::get<QRegularExpression>(p->needle);
+            if (regex.patternOptions().testFlag(QRegularExpression::PatternOption::CaseInsensitiveOption) !=
+                    (p->caseSensitivity == Qt::CaseInsensitive)) {
+                regex.setPatternOptions(regex.patternOptions() ^ QRegularExpression::PatternOption::CaseInsensitiveOption);
+            }
+            if (!regex.isValid()) {
+                p->needle = std::monostate{};
+            }
+        }
+
+        const LineStore &lines = ZDocumentSnapshotPrivate::get(&snap)->lines;
+        const int lineCount = lines.size();
+
+        p->lines = lines;
+        p->searchedLineCount = 0;
+
+        // Returns the index entry for line, the matches are kept in its user data.
+        auto searchLine = [&](int line) {
+            LineData entry;
+            if (!std::holds_alternative<std::monostate>(p->needle)) {
+                QVector<ZDocumentMatchIndex::Match> matches = findAllInLine(lines.at(line).chars, *p, regex);
+                if (!matches.isEmpty()) {
+                    p->matchCount += matches.size();
+                    auto lineMatches = std::make_shared<ZDocumentMatchIndexPrivate::LineMatches>();
+                    lineMatches->matches = std::move(matches);
+                    entry.userData = std::move(lineMatches);
+                }
+            }
+            p->searchedLineCount++;
+            return entry;
+        };
+
+        if (prev->needle != p->needle || prev->caseSensitivity != p->caseSensitivity) {
+            QVector<QVector<LineData>> entries = {{}};
+            entries.last().reserve(lineCount);
+            p->matchCount = 0;
+            for (int line = 0; line < lineCount; line++) {
+                if (canceler.isCanceled()) {
+                    return std::nullopt;
+                }
+                entries.last().append(searchLine(line));
+            }
+            p->matchLines = LineStore::build(entries);
+            p->revision = snap.revision();
+            return result;
+        }
+
+        // Start with the entries of the previous index and only replace the entries of lines that changed. Only the
+        // ranges in which the snapshots differ are visited, so edits in several places of the document only search
+        // the edited lines and the cost does not depend on the size of the document.
+        const LineStore &prevLines = prev->lines;
+        p->matchLines = prev->matchLines;
+        p->matchCount = prev->matchCount;
+
+        for (const LineStore::Difference &difference: LineStore::differences(prevLines, lines)) {
+            // p->matchLines[line] and following entries are the entries of prevLines[prevLine] and following.
+            int prevLine = difference.startA;
+            const int prevEnd = difference.startA + difference.countA;
+            int line = difference.startB;
+            const int end = difference.startB + difference.countB;
+
+            // Line in the range of the previous snapshot by its text data, built on first use. For lines sharing the
+            // text data this contains the first of them.
+            QHash<const QChar*, int> prevLineByData;
+            bool prevLineByDataBuilt = false;
+
+            while (line < end) {
+                if (canceler.isCanceled()) {
+                    return std::nullopt;
+                }
+
+                if (prevLine < prevEnd && isSameLine(prevLines.at(prevLine), lines.at(line))) {
+                    prevLine++;
+                    line++;
+                    continue;
+                }
+
+                int removeCount = 0;
+                int insertCount = 0;
+                if (prevLine < prevEnd && (prevLine + 1 == prevEnd ? line + 1 == end
+                                           : line + 1 < end && isSameLine(prevLines.at(prevLine + 1), lines.at(line + 1)))) {
+                    // The common case of a single modified line
+                    removeCount = 1;
+                    insertCount = 1;
+                } else {
+                    if (!prevLineByDataBuilt) {
+                        for (int i = prevEnd - 1; i >= prevLine; i--) {
+                            prevLineByData.insert(prevLines.at(i).chars.constData(), i);
+                        }
+                        prevLineByDataBuilt = true;
+                    }
+                    // Lines are new up to the next line that is found in the previous snapshot. The previous lines
+                    // before that line were removed.
+                    int nextLine = line;
+                    int nextPrevLine = prevEnd;
+                    for (; nextLine < end; nextLine++) {
+                        const LineData &lineData = lines.at(nextLine);
+                        const auto it = prevLineByData.constFind(lineData.chars.constData());
+                        if (it != prevLineByData.constEnd() && *it >= prevLine && isSameLine(prevLines.at(*it), lineData)) {
+                            nextPrevLine = *it;
+                            break;
+                        }
+                    }
+                    removeCount = nextPrevLine - prevLine;
+                    insertCount = nextLine - line;
+                }
+
+                for (int i = line; i < line + removeCount; i++) {
+                    p->matchCount -= indexEntryMatchCount(p->matchLines.at(i));
+                }
+                QVector<LineData> entries;
+                entries.reserve(insertCount);
+                for (int i = line; i < line + insertCount; i++) {
+                    if (canceler.isCanceled()) {
+                        return std::nullopt;
+                    }
+                    entries.append(searchLine(i));
+                }
+                const int replaced = std::min(removeCount, insertCount);
+                for (int i = 0; i < replaced; i++) {
+                    p->matchLines.modify(line + i) = entries[i];
+                }
+                if (removeCount > insertCount) {
+                    p->matchLines.remove(line + insertCount, removeCount - insertCount);
+                } else if (insertCount > removeCount) {
+                    p->matchLines.insert(line + removeCount, entries.mid(removeCount));
+                }
+                prevLine += removeCount;
+                line += insertCount;
+            }
+
+            if (prevLine < prevEnd) {
+                for (int i = line; i < line + prevEnd - prevLine; i++) {
+                    p->matchCount -= indexEntryMatchCount(p->matchLines.at(i));
+                }
+                p->matchLines.remove(line, prevEnd - prevLine);
+            }
+        }
+        Q_ASSERT(p->matchLines.size() == lineCount);
+
+        p->revision = snap.revision();
+        return result;
+    }
+
+    class FindAllOnThread : public QRunnable {
+    public:
+        void run() override {
+            if (!promise.isCanceled()) {
+                std::optional<ZDocumentMatchIndex> res = snapshotFindAll(snap, result, previous, promise);
+                if (res) {
+                    promise.reportResult(*res);
+                }
+            }
+            promise.reportFinished();
+        }
+
+    public:
+        QFutureInterface<ZDocumentMatchIndex> promise;
+        ZDocumentSnapshot snap;
+        ZDocumentMatchIndex result;
+        ZDocumentMatchIndex previous;
+    };
+
+    QFuture<ZDocumentMatchIndex> startFindAll(QThreadPool *pool, int priority, ZDocumentSnapshot snap,
+                                              ZDocumentMatchIndex result, const ZDocumentMatchIndex &previous) {
+        QFutureInterface<ZDocumentMatchIndex> promise;
+        QFuture<ZDocumentMatchIndex> future = promise.future();
+        promise.reportStarted();
+
+        FindAllOnThread *runnable = new FindAllOnThread();
+        runnable->snap = snap;
+        runnable->result = result;
+        runnable->previous = previous;
+        runnable->promise = std::move(promise);
+
+        pool->start(runnable, priority);
+
+        return future;
+    }
 }
 
 ZDocumentCursor ZDocument::findSync(const QString &subString, const ZDocumentCursor &start,
@@ -627,6 +1084,7 @@ QFuture<ZDocumentFindAsyncResult> ZDocument::findAsyncWithPool(QThreadPool *pool
     runnable->param = param;
     runnable->backwards = options & ZDocument::FindFlag::FindBackward;
     runnable->snap = snapshot();
+    runnable->pool = pool;
     runnable->promise = std::move(promise);
 
     pool->start(runnable, priority);
@@ -661,6 +1119,7 @@ QFuture<ZDocumentFindAsyncResult> ZDocument::findAsyncWithPool(QThreadPool *pool
     runnable->param = param;
     runnable->backwards = options & ZDocument::FindFlag::FindBackward;
     runnable->snap = snapshot();
+    runnable->pool = pool;
     runnable->promise = std::move(promise);
 
     pool->start(runnable, priority);
@@ -668,6 +1127,38 @@ QFuture<ZDocumentFindAsyncResult> ZDocument::findAsyncWithPool(QThreadPool *pool
     return future;
 }
 
+QFuture<ZDocumentMatchIndex> ZDocument::findAllAsync(const QString &subString, ZDocument::FindFlags options,
+                                                     const ZDocumentMatchIndex &previous) const {
+    return findAllAsyncWithPool(QThreadPool::globalInstance(), 0, subString, options, previous);
+}
+
+QFuture<ZDocumentMatchIndex> ZDocument::findAllAsync(const QRegularExpression &regex, ZDocument::FindFlags options,
+                                                     const ZDocumentMatchIndex &previous) const {
+    return findAllAsyncWithPool(QThreadPool::globalInstance(), 0, regex, options, previous);
+}
+
+QFuture<ZDocumentMatchIndex> ZDocument::findAllAsyncWithPool(QThreadPool *pool, int priority,
+                                                             const QString &subString, ZDocument::FindFlags options,
+                                                             const ZDocumentMatchIndex &previous) const {
+    ZDocumentMatchIndex result;
+    auto *const resultP = ZDocumentMatchIndexPrivate::get(&result);
+    if (!subString.isEmpty()) {
+        resultP->needle = subString;
+    }
+    resultP->caseSensitivity = (options & ZDocument::FindFlag::FindCaseSensitively) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    return startFindAll(pool, priority, snapshot(), result, previous);
+}
+
+QFuture<ZDocumentMatchIndex> ZDocument::findAllAsyncWithPool(QThreadPool *pool, int priority,
+                                                             const QRegularExpression &regex, ZDocument::FindFlags options,
+                                                             const ZDocumentMatchIndex &previous) const {
+    ZDocumentMatchIndex result;
+    auto *const resultP = ZDocumentMatchIndexPrivate::get(&result);
+    resultP->needle = regex;
+    resultP->caseSensitivity = (options & ZDocument::FindFlag::FindCaseSensitively) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    return startFindAll(pool, priority, snapshot(), result, previous);
+}
+
 ZDocumentFindAsyncResult::ZDocumentFindAsyncResult()
     : tuiwidgets_pimpl_ptr(std::make_unique<ZDocumentFindAsyncResultPrivate>())
 {
@@ -767,4 +1258,52 @@ ZDocumentFindResult::ZDocumentFindResult(ZDocumentCursor cursor, QRegularExpress
 
 ZDocumentFindResult::~ZDocumentFindResult() {}
 
+ZDocumentMatchIndexPrivate *ZDocumentMatchIndexPrivate::get(ZDocumentMatchIndex *index) {
+    return index->tuiwidgets_impl();
+}
+
+const ZDocumentMatchIndexPrivate *ZDocumentMatchIndexPrivate::get(const ZDocumentMatchIndex *index) {
+    return index->tuiwidgets_impl();
+}
+
+ZDocumentMatchIndex::ZDocumentMatchIndex() : tuiwidgets_pimpl_ptr(std::make_shared<ZDocumentMatchIndexPrivate>()) {
+}
+
+ZDocumentMatchIndex::ZDocumentMatchIndex(const ZDocumentMatchIndex &other)
+    : tuiwidgets_pimpl_ptr(other.tuiwidgets_pimpl_ptr)
+{
+}
+
+ZDocumentMatchIndex::~ZDocumentMatchIndex() {
+}
+
+ZDocumentMatchIndex &ZDocumentMatchIndex::operator=(const ZDocumentMatchIndex &other) {
+    tuiwidgets_pimpl_ptr = other.tuiwidgets_pimpl_ptr;
+    return *this;
+}
+
+unsigned ZDocumentMatchIndex::revision() const {
+    return tuiwidgets_impl()->revision;
+}
+
+int ZDocumentMatchIndex::lineCount() const {
+    return tuiwidgets_impl()->matchLines.size();
+}
+
+int ZDocumentMatchIndex::matchCount() const {
+    return tuiwidgets_impl()->matchCount;
+}
+
+QVector<ZDocumentMatchIndex::Match> ZDocumentMatchIndex::matchesInLine(int line) const {
+    const LineData &entry = tuiwidgets_impl()->matchLines.at(line);
+    if (!entry.userData) {
+        return {};
+    }
+    return static_cast<const ZDocumentMatchIndexPrivate::LineMatches*>(entry.userData.get())->matches;
+}
+
+int ZDocumentMatchIndex::searchedLineCount() const {
+    return tuiwidgets_impl()->searchedLineCount;
+}
+
 TUIWIDGETS_NS_END
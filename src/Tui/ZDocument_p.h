@@ -5,12 +5,16 @@
 
 #include <memory>
 #include <optional>
+#include <variant>
 
 #include <QString>
+#include <QStringList>
 #include <QVector>
 
 #include <Tui/ListNode_p.h>
 #include <Tui/ZDocument.h>
+#include <Tui/ZDocumentLineMarkerIndex_p.h>
+#include <Tui/ZDocumentLineStore_p.h>
 
 #include <Tui/tuiwidgets_internal.h>
 
@@ -22,12 +26,6 @@ class ZDocumentLineMarkerPrivate;
 struct LineMarkerToDocumentTag;
 struct TextCursorToDocumentTag;
 
-struct LineData {
-    QString chars;
-    unsigned revision = 0;
-    std::shared_ptr<ZDocumentLineUserData> userData;
-};
-
 class ZDocumentFindAsyncResultPrivate {
 public:
     ZDocumentFindAsyncResultPrivate();
@@ -51,6 +49,31 @@ class ZDocumentFindResultPrivate {
     QRegularExpressionMatch _match;
 };
 
+class ZDocumentMatchIndexPrivate {
+public:
+    static ZDocumentMatchIndexPrivate *get(ZDocumentMatchIndex *index);
+    static const ZDocumentMatchIndexPrivate *get(const ZDocumentMatchIndex *index);
+
+    // The matches of a line are kept as user data of the entries in matchLines, lines without matches have none.
+    class LineMatches : public ZDocumentLineUserData {
+    public:
+        QVector<ZDocumentMatchIndex::Match> matches;
+    };
+
+public:
+    unsigned revision = -1;
+    std::variant<std::monostate, QString, QRegularExpression> needle;
+    Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive;
+    // The lines of the snapshot the index was built from. As it shares its nodes with later versions of the document,
+    // updating the index only needs to visit the nodes that differ.
+    LineStore lines;
+    // One entry per line, stored in a LineStore too, so copies are cheap and entries can be replaced, inserted or
+    // removed in O(log n).
+    LineStore matchLines;
+    int matchCount = 0;
+    int searchedLineCount = 0;
+};
+
 class ZDocumentUndoGroupPrivate {
 public:
     ZDocumentUndoGroupPrivate(ZDocumentPrivate *doc, ZDocumentCursor *cursor);
@@ -75,22 +98,18 @@ class ZDocumentPrivate {
         }
     };
 
-    struct UndoLineMarker {
-        ZDocumentLineMarker *marker;
-        bool updated = false;
-        int line = 0;
-    };
-
     struct UndoStep {
-        QVector<LineData> lines;
+        LineStore lines;
         int startCursorCodeUnit;
         int startCursorLine;
         int endCursorCodeUnit;
         int endCursorLine;
         bool noNewlineAtEnd = false;
-        QVector<std::function<void(QVector<UndoCursor>&, QVector<UndoLineMarker>&)>> undoCursorAdjustments;
-        QVector<std::function<void(QVector<UndoCursor>&, QVector<UndoLineMarker>&)>> redoCursorAdjustments;
+        QVector<std::function<void(QVector<UndoCursor>&, LineMarkerIndex&)>> undoCursorAdjustments;
+        QVector<std::function<void(QVector<UndoCursor>&, LineMarkerIndex&)>> redoCursorAdjustments;
         bool collapsable = false;
+        // estimated memory not shared with the previous step
+        qint64 memoryCost = 0;
     };
 
 public:
@@ -107,6 +126,7 @@ class ZDocumentPrivate {
 public: // TextCursor interface
     void removeFromLine(ZDocumentCursor *cursor, int line, int codeUnitStart, int codeUnits);
     void insertIntoLine(ZDocumentCursor *cursor, int line, int codeUnitStart, const QString &data);
+    void insertLines(ZDocumentCursor *cursor, ZDocumentCursor::Position pos, const QStringList &data);
     void removeLines(ZDocumentCursor *cursor, int start, int count);
     void splitLine(ZDocumentCursor *cursor, ZDocumentCursor::Position pos);
     void mergeLines(ZDocumentCursor *cursor, int line);
@@ -119,7 +139,7 @@ class ZDocumentPrivate {
     void closeUndoGroup(ZDocumentCursor *cursor);
 
 public: // LineMarker interface
-    void registerLineMarker(ZDocumentLineMarkerPrivate *marker);
+    void registerLineMarker(ZDocumentLineMarkerPrivate *marker, int line);
     void unregisterLineMarker(ZDocumentLineMarkerPrivate *marker);
 
 public: // TextCursor + LineMarker interface
@@ -127,20 +147,22 @@ class ZDocumentPrivate {
 
 public:
     void applyCursorAdjustments(ZDocumentCursor *cursor,
-                                const QVector<std::function<void(QVector<ZDocumentPrivate::UndoCursor>&, QVector<ZDocumentPrivate::UndoLineMarker>&)>> &cursorAdjustments);
+                                const QVector<std::function<void(QVector<ZDocumentPrivate::UndoCursor>&, LineMarkerIndex&)>> &cursorAdjustments);
     void initalUndoStep(int endCodeUnit, int endLine);
+    void applyUndoMemoryBudget();
     void noteContentsChange();
     void emitModifedSignals();
 
 public:
     QString filename;
-    QVector<LineData> lines;
+    LineStore lines;
     bool newlineAfterLastLineMissing = false;
     bool crLfMode = false;
 
     QVector<UndoStep> undoSteps;
     int currentUndoStep = -1;
     int savedUndoStep = -1;
+    qint64 undoMemoryBudget = 0;
 
     bool collapseUndoStep = false;
     int groupUndo = 0;
@@ -149,12 +171,17 @@ class ZDocumentPrivate {
     bool undoGroupCollapse = false;
     struct PendingUndoStep {
         ZDocumentCursor::Position preModificationCursorPosition;
-        QVector<std::function<void(QVector<UndoCursor>&, QVector<UndoLineMarker>&)>> redoCursorAdjustments;
-        QVector<std::function<void(QVector<UndoCursor>&, QVector<UndoLineMarker>&)>> undoCursorAdjustments;
+        QVector<std::function<void(QVector<UndoCursor>&, LineMarkerIndex&)>> redoCursorAdjustments;
+        QVector<std::function<void(QVector<UndoCursor>&, LineMarkerIndex&)>> undoCursorAdjustments;
     };
     std::optional<PendingUndoStep> pendingUpdateStep;
 
+    // in registration order, the order change signals are emitted in
     ListHead<ZDocumentLineMarkerPrivate, LineMarkerToDocumentTag> lineMarkerList;
+    quint64 lineMarkerRegistrationCounter = 0;
+    LineMarkerIndex lineMarkerIndex;
+    // markers whose change signal is currently emitted, unregistered markers are replaced by nullptr
+    std::vector<std::vector<ZDocumentLineMarkerPrivate*>*> lineMarkersInEmission;
     ListHead<ZDocumentCursorPrivate, TextCursorToDocumentTag> cursorList;
     bool changeScheduled = false;
     bool contentsChangedSignalToBeEmitted = false;
@@ -27,6 +27,10 @@ TUIWIDGETS_EXPORT QEvent::Type ZEventType::paste() {
     CALL_ONCE_REGISTEREVENTTYPE;
 }
 
+TUIWIDGETS_EXPORT QEvent::Type ZEventType::pasteChunk() {
+    CALL_ONCE_REGISTEREVENTTYPE;
+}
+
 TUIWIDGETS_EXPORT QEvent::Type ZEventType::queryAcceptsEnter() {
     CALL_ONCE_REGISTEREVENTTYPE;
 }
@@ -194,8 +198,8 @@ KeyboardModifiers ZKeyEvent::modifiers() const {
     return tuiwidgets_impl()->modifiers;
 }
 
-ZPasteEventPrivate::ZPasteEventPrivate(const QString &text)
-    : text(text)
+ZPasteEventPrivate::ZPasteEventPrivate(const QString &text, bool initial, bool final)
+    : text(text), initial(initial), final(final)
 {
 }
 
@@ -203,7 +207,12 @@ ZPasteEventPrivate::~ZPasteEventPrivate() {
 }
 
 ZPasteEvent::ZPasteEvent(const QString &text)
-    : ZEvent(ZEventType::paste(), std::make_unique<ZPasteEventPrivate>(text))
+    : ZEvent(ZEventType::paste(), std::make_unique<ZPasteEventPrivate>(text, true, true))
+{
+}
+
+ZPasteEvent::ZPasteEvent(Chunk, const QString &text, bool initial, bool final)
+    : ZEvent(ZEventType::pasteChunk(), std::make_unique<ZPasteEventPrivate>(text, initial, final))
 {
 }
 
@@ -214,6 +223,14 @@ QString ZPasteEvent::text() const {
     return tuiwidgets_impl()->text;
 }
 
+bool ZPasteEvent::isInitialChunk() const {
+    return tuiwidgets_impl()->initial;
+}
+
+bool ZPasteEvent::isFinalChunk() const {
+    return tuiwidgets_impl()->final;
+}
+
 ZFocusEventPrivate::ZFocusEventPrivate(FocusReason reason)
     : reason(reason)
 {
@@ -36,6 +36,7 @@ namespace ZEventType {
     QEvent::Type paint();
     QEvent::Type key();
     QEvent::Type paste();
+    QEvent::Type pasteChunk();
     QEvent::Type queryAcceptsEnter();
     QEvent::Type focusIn();
     QEvent::Type focusOut();
@@ -125,11 +126,15 @@ class TUIWIDGETS_EXPORT ZKeyEvent : public ZEvent {
 
 class TUIWIDGETS_EXPORT ZPasteEvent : public ZEvent {
 public:
+    class Chunk{}; static constexpr Chunk chunk {};
     ZPasteEvent(const QString &text);
+    ZPasteEvent(Chunk, const QString &text, bool initial, bool final);
     ~ZPasteEvent() override;
 
 public:
     QString text() const;
+    bool isInitialChunk() const;
+    bool isFinalChunk() const;
 
 private:
     TUIWIDGETS_DECLARE_PRIVATE(ZPasteEvent)
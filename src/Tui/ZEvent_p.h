@@ -55,11 +55,13 @@ class ZKeyEventPrivate : public ZEventPrivate {
 
 class ZPasteEventPrivate : public ZEventPrivate {
 public:
-    ZPasteEventPrivate(const QString &text);
+    ZPasteEventPrivate(const QString &text, bool initial, bool final);
     ~ZPasteEventPrivate() override;
 
 public:
     QString text;
+    bool initial = true;
+    bool final = true;
 };
 
 class ZFocusEventPrivate : public ZEventPrivate {
@@ -79,8 +79,14 @@ void ZHBoxLayout::setGeometry(QRect toFill) {
     auto place = [&visibleItems, height, toFill] (int x, int wi, int idx) {
         placeWidgetInCell(toFill.x() + x, toFill.y(), wi, height, visibleItems[idx], Alignment());
     };
-    auto getHint = [&visibleItems] (int idx) {
-        return visibleItems[idx]->sizeHint().width();
+    // boxLayouter asks for the hints multiple times
+    std::vector<int> hints;
+    hints.reserve(visibleItems.size());
+    for (ZLayoutItem *item : visibleItems) {
+        hints.push_back(item->sizeHint().width());
+    }
+    auto getHint = [&hints] (int idx) {
+        return hints[idx];
     };
 
     auto getPolicy = [&visibleItems] (int idx) {
@@ -111,6 +117,11 @@ void ZHBoxLayout::removeWidgetRecursively(ZWidget *widget) {
 QSize ZHBoxLayout::sizeHint() const {
     auto *const p = tuiwidgets_impl();
 
+    QSize cached;
+    if (p->lookupSizeHint(&cached)) {
+        return cached;
+    }
+
     int hintSize = 0;
     int hintOther = 0;
     int numSpacer = 0;
@@ -131,7 +142,7 @@ QSize ZHBoxLayout::sizeHint() const {
 
     hintSize += p->spacing * (visibleItems - 1 - numSpacer);
 
-    return { hintSize, hintOther };
+    return p->storeSizeHint(QSize{ hintSize, hintOther });
 }
 
 SizePolicy ZHBoxLayout::sizePolicyH() const {
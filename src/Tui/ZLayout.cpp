@@ -12,7 +12,9 @@
 
 #include <Tui/ZSymbol.h>
 #include <Tui/ZTerminal.h>
+#include <Tui/ZTerminal_p.h>
 #include <Tui/ZWidget.h>
+#include <Tui/ZWidget_p.h>
 
 
 TUIWIDGETS_NS_START
@@ -44,6 +46,10 @@ void ZLayout::widgetEvent(QEvent *event) {
         ZWidget *w = parentWidget();
         ZTerminal *term = w->terminal();
         ZWidget *chainRoot = w->resolveSizeHintChain();
+        ZTest::LayoutPassCounters *counters = term ? ZTerminalPrivate::get(term)->testingLayoutPassCounters : nullptr;
+        if (counters) {
+            counters->widgetsVisited += 1;
+        }
 
         // ensure that the root of the layout chain gets to layout first
         if (chainRoot != w && !ZLayoutPrivate::alreadyLayoutedInThisGeneration(term, chainRoot)) {
@@ -58,6 +64,9 @@ void ZLayout::widgetEvent(QEvent *event) {
         // i.e. one widget was replaced with a widget of the same size
         if (!ZLayoutPrivate::alreadyLayoutedInThisGeneration(term, w)) {
             ZLayoutPrivate::markAsAlreadyLayouted(term, w);
+            if (counters) {
+                counters->widgetsRelayouted += 1;
+            }
             setGeometry(w->layoutArea());
         }
     } else if (event->type() == QEvent::ChildRemoved) {
@@ -118,6 +127,7 @@ bool ZLayout::isSpacer() const {
 void ZLayout::relayout() {
     ZWidget *w = parentWidget();
     if (w) {
+        ZWidgetPrivate::get(w)->invalidateSizeHintCache();
         auto *term = w->terminal();
         if (term) {
             term->requestLayout(w);
@@ -205,5 +215,19 @@ void ZLayoutPrivate::LayoutGenData::reset() {
     alreadyDone.clear();
 }
 
+bool ZLayoutPrivate::lookupSizeHint(QSize *hint) const {
+    if (!sizeHintCachePass || sizeHintCachePass != ZTerminalPrivate::activeLayoutPass) {
+        return false;
+    }
+    *hint = cachedSizeHint;
+    return true;
+}
+
+QSize ZLayoutPrivate::storeSizeHint(QSize hint) const {
+    sizeHintCachePass = ZTerminalPrivate::activeLayoutPass;
+    cachedSizeHint = hint;
+    return hint;
+}
+
 
 TUIWIDGETS_NS_END
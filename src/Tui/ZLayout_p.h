@@ -5,8 +5,11 @@
 
 #include <Tui/ZLayout.h>
 
+#include <cstdint>
+
 #include <QHash>
 #include <QSet>
+#include <QSize>
 
 TUIWIDGETS_NS_START
 
@@ -28,6 +31,25 @@ class ZLayoutPrivate {
     static bool alreadyLayoutedInThisGeneration(ZTerminal *term, ZWidget *w);
 
     static bool ensureLayoutGenData(ZTerminal *term);
+
+    // Memoization of sizeHint() for the duration of one layout pass (see ZTerminalPrivate::activeLayoutPass).
+    // Outside of a layout pass lookups always miss.
+    bool lookupSizeHint(QSize *hint) const;
+    QSize storeSizeHint(QSize hint) const;
+    // Invalidates the memoized hint of layout and all its sub layouts.
+    // Inline because ZWidget.cpp uses it and the internal tests link ZWidget.cpp without ZLayout.cpp.
+    static void invalidateSizeHintCache(ZLayout *layout) {
+        get(layout)->sizeHintCachePass = 0;
+        for (ZLayout *subLayout : layout->findChildren<ZLayout*>()) {
+            get(subLayout)->sizeHintCachePass = 0;
+        }
+    }
+
+    mutable int sizeHintCachePass = 0;
+    mutable QSize cachedSizeHint;
+
+    // back door
+    static ZLayoutPrivate *get(ZLayout *layout) { return layout->tuiwidgets_impl(); }
 };
 
 namespace Private {
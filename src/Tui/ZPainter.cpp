@@ -4,7 +4,7 @@
 #include <Tui/ZPainter_p.h>
 
 #include <QRect>
-#include <QTextCodec>
+#include <QVarLengthArray>
 
 #include <Tui/ZColor.h>
 #include <Tui/ZImage_p.h>
@@ -23,6 +23,52 @@ namespace {
     int toTermPaintColor(ZColor color) {
         return color.nativeValue();
     }
+
+    constexpr int maxAttributeCacheSize = 1024;
+
+    // Large enough for most strings, so that writing text usually does not allocate.
+    using Utf8Buffer = QVarLengthArray<char, 512>;
+
+    // Converts like QString::toUtf8, i.e. code units that are not valid utf16 are replaced by '?'.
+    void toUtf8(const char16_t *string, int size, Utf8Buffer *buffer) {
+        buffer->resize(std::max(size, 0) * 3);
+        char *out = buffer->data();
+        int i = 0;
+        while (i < size) {
+            const int ascii = printableAsciiPrefix(string + i, size - i);
+            for (int j = 0; j < ascii; j++) {
+                out[j] = static_cast<char>(string[i + j]);
+            }
+            out += ascii;
+            i += ascii;
+            if (i == size) {
+                break;
+            }
+
+            const char16_t ch = string[i];
+            i++;
+            if (ch < 0x80) {
+                *out++ = static_cast<char>(ch);
+            } else if (ch < 0x800) {
+                *out++ = static_cast<char>(0xc0 | (ch >> 6));
+                *out++ = static_cast<char>(0x80 | (ch & 0x3f));
+            } else if (!QChar::isSurrogate(ch)) {
+                *out++ = static_cast<char>(0xe0 | (ch >> 12));
+                *out++ = static_cast<char>(0x80 | ((ch >> 6) & 0x3f));
+                *out++ = static_cast<char>(0x80 | (ch & 0x3f));
+            } else if (QChar::isHighSurrogate(ch) && i < size && QChar::isLowSurrogate(string[i])) {
+                const char32_t ch32 = QChar::surrogateToUcs4(ch, string[i]);
+                i++;
+                *out++ = static_cast<char>(0xf0 | (ch32 >> 18));
+                *out++ = static_cast<char>(0x80 | ((ch32 >> 12) & 0x3f));
+                *out++ = static_cast<char>(0x80 | ((ch32 >> 6) & 0x3f));
+                *out++ = static_cast<char>(0x80 | (ch32 & 0x3f));
+            } else {
+                *out++ = '?';
+            }
+        }
+        buffer->resize(static_cast<int>(out - buffer->data()));
+    }
 }
 
 ZPainterPrivate::ZPainterPrivate(termpaint_surface *surface, int width, int height, std::shared_ptr<char> token)
@@ -34,6 +80,47 @@ ZPainterPrivate::~ZPainterPrivate()
 {
 }
 
+termpaint_attr *ZPainterPrivate::termpaintAttr(ZColor fg, ZColor bg, ZTextAttributes attr) {
+    if (!attributeCache) {
+        attributeCache = std::make_shared<ZPainterAttributeCache>();
+    }
+    return attributeCache->lookup(fg, bg, attr);
+}
+
+ZPainterAttributeCache::ZPainterAttributeCache() {
+}
+
+ZPainterAttributeCache::~ZPainterAttributeCache() {
+    for (termpaint_attr *termpaintAttr: qAsConst(entries)) {
+        termpaint_attr_free(termpaintAttr);
+    }
+}
+
+termpaint_attr *ZPainterAttributeCache::lookup(ZColor fg, ZColor bg, ZTextAttributes attr) {
+    const Key key{fg.nativeValue(), bg.nativeValue(), static_cast<int>(attr)};
+    auto it = entries.constFind(key);
+    if (it != entries.constEnd()) {
+        return it.value();
+    }
+
+    if (entries.size() >= maxAttributeCacheSize) {
+        // Typical applications only use a few styles, just start over if that is not the case.
+        for (termpaint_attr *termpaintAttr: qAsConst(entries)) {
+            termpaint_attr_free(termpaintAttr);
+        }
+        entries.clear();
+    }
+
+    termpaint_attr *termpaintAttr = termpaint_attr_new(toTermPaintColor(fg), toTermPaintColor(bg));
+    termpaint_attr_set_style(termpaintAttr, attr);
+    entries.insert(key, termpaintAttr);
+    return termpaintAttr;
+}
+
+int ZPainterAttributeCache::size() const {
+    return entries.size();
+}
+
 ZPainter::ZPainter(std::unique_ptr<ZPainterPrivate> impl)
     : tuiwidgets_pimpl_ptr(move(impl))
 {
@@ -75,8 +162,7 @@ ZPainter ZPainter::translateAndClip(int x, int y, int width, int height) {
 }
 
 void ZPainter::writeWithColors(int x, int y, const QString &string, ZColor fg, ZColor bg) {
-    auto utf8 = string.toUtf8();
-    writeWithColors(x, y, utf8.data(), utf8.size(), fg, bg);
+    writeWithColors(x, y, string.constData(), string.size(), fg, bg);
 }
 
 void ZPainter::writeWithColors(int x, int y, const char *stringUtf8, int utf8CodeUnits, ZColor fg, ZColor bg) {
@@ -95,18 +181,17 @@ void ZPainter::writeWithColors(int x, int y, const char *stringUtf8, int utf8Cod
 }
 
 void ZPainter::writeWithColors(int x, int y, const QChar *string, int size, ZColor fg, ZColor bg) {
-    QByteArray utf8 = QTextCodec::codecForMib(106)->fromUnicode(string, size);
-    writeWithColors(x, y, utf8.data(), utf8.size(), fg, bg);
+    writeWithColors(x, y, reinterpret_cast<const char16_t*>(string), size, fg, bg);
 }
 
 void ZPainter::writeWithColors(int x, int y, const char16_t *string, int size, ZColor fg, ZColor bg) {
-    QByteArray utf8 = QTextCodec::codecForMib(106)->fromUnicode(reinterpret_cast<const QChar*>(string), size);
+    Utf8Buffer utf8;
+    toUtf8(string, size, &utf8);
     writeWithColors(x, y, utf8.data(), utf8.size(), fg, bg);
 }
 
 void ZPainter::writeWithAttributes(int x, int y, const QString &string, ZColor fg, ZColor bg, ZTextAttributes attr) {
-    auto utf8 = string.toUtf8();
-    writeWithAttributes(x, y, utf8.data(), utf8.size(), fg, bg, attr);
+    writeWithAttributes(x, y, string.constData(), string.size(), fg, bg, attr);
 }
 
 void ZPainter::writeWithAttributes(int x, int y, const char *stringUtf8, int utf8CodeUnits, ZColor fg, ZColor bg, ZTextAttributes attr) {
@@ -117,23 +202,21 @@ void ZPainter::writeWithAttributes(int x, int y, const char *stringUtf8, int utf
 
     if (y >= pimpl->height || y < 0) return;
 
-    termpaint_attr *termpaintAttr = termpaint_attr_new(toTermPaintColor(fg), toTermPaintColor(bg));
-    termpaint_attr_set_style(termpaintAttr, attr);
+    termpaint_attr *termpaintAttr = pimpl->termpaintAttr(fg, bg, attr);
     termpaint_surface_write_with_len_attr_clipped(pimpl->surface,
                                                   x + pimpl->x, y + pimpl->y,
                                                   stringUtf8, utf8CodeUnits,
                                                   termpaintAttr,
                                                   pimpl->x, pimpl->x + pimpl->width - 1);
-    termpaint_attr_free(termpaintAttr);
 }
 
 void ZPainter::writeWithAttributes(int x, int y, const QChar *string, int size, ZColor fg, ZColor bg, ZTextAttributes attr) {
-    QByteArray utf8 = QTextCodec::codecForMib(106)->fromUnicode(string, size);
-    writeWithAttributes(x, y, utf8.data(), utf8.size(), fg, bg, attr);
+    writeWithAttributes(x, y, reinterpret_cast<const char16_t*>(string), size, fg, bg, attr);
 }
 
 void ZPainter::writeWithAttributes(int x, int y, const char16_t *string, int size, ZColor fg, ZColor bg, ZTextAttributes attr) {
-    QByteArray utf8 = QTextCodec::codecForMib(106)->fromUnicode(reinterpret_cast<const QChar*>(string), size);
+    Utf8Buffer utf8;
+    toUtf8(string, size, &utf8);
     writeWithAttributes(x, y, utf8.data(), utf8.size(), fg, bg, attr);
 }
 
@@ -143,12 +226,10 @@ void ZPainter::clear(ZColor fg, ZColor bg, ZTextAttributes attr) {
 
 void ZPainter::clearWithChar(ZColor fg, ZColor bg, int fillChar, ZTextAttributes attr) {
     auto *const pimpl = tuiwidgets_impl();
-    termpaint_attr *termpaintAttr = termpaint_attr_new(toTermPaintColor(fg), toTermPaintColor(bg));
-    termpaint_attr_set_style(termpaintAttr, attr);
+    termpaint_attr *termpaintAttr = pimpl->termpaintAttr(fg, bg, attr);
     termpaint_surface_clear_rect_with_attr_char(pimpl->surface,
                                  pimpl->x, pimpl->y, pimpl->width, pimpl->height,
                                  termpaintAttr, fillChar);
-    termpaint_attr_free(termpaintAttr);
 }
 
 void ZPainter::clearRectWithChar(int x, int y, int width, int height, ZColor fg, ZColor bg, int fillChar, ZTextAttributes attr) {
@@ -170,8 +251,7 @@ void ZPainter::clearRectWithChar(int x, int y, int width, int height, ZColor fg,
     if (width < 0 || height < 0) {
         return;
     }
-    termpaint_attr *termpaintAttr = termpaint_attr_new(toTermPaintColor(fg), toTermPaintColor(bg));
-    termpaint_attr_set_style(termpaintAttr, attr);
+    termpaint_attr *termpaintAttr = pimpl->termpaintAttr(fg, bg, attr);
 
     x += pimpl->x;
     y += pimpl->y;
@@ -179,7 +259,6 @@ void ZPainter::clearRectWithChar(int x, int y, int width, int height, ZColor fg,
     termpaint_surface_clear_rect_with_attr_char(pimpl->surface,
                                  x, y, width, height,
                                  termpaintAttr, fillChar);
-    termpaint_attr_free(termpaintAttr);
 }
 
 void ZPainter::clearRect(int x, int y, int width, int height, ZColor fg, ZColor bg, ZTextAttributes attr) {
@@ -3,6 +3,9 @@
 #ifndef TUIWIDGETS_ZPAINTER_P_INCLUDED
 #define TUIWIDGETS_ZPAINTER_P_INCLUDED
 
+#include <memory>
+
+#include <QHash>
 #include <QPointer>
 
 #include <termpaint.h>
@@ -17,6 +20,38 @@ class ZWidget;
 
 class ZTerminalPrivate;
 
+// Creating termpaint attributes for every write is costly, so they are kept for reuse. Painters of a terminal share
+// one cache, which lives as long as the terminal.
+class ZPainterAttributeCache {
+public:
+    ZPainterAttributeCache();
+    ~ZPainterAttributeCache();
+
+    ZPainterAttributeCache(const ZPainterAttributeCache&) = delete;
+    ZPainterAttributeCache &operator=(const ZPainterAttributeCache&) = delete;
+
+    // The returned attribute is owned by the cache and only valid until the next call.
+    termpaint_attr *lookup(ZColor fg, ZColor bg, ZTextAttributes attr);
+    int size() const;
+
+private:
+    struct Key {
+        uint32_t fg;
+        uint32_t bg;
+        int attr;
+
+        bool operator==(const Key &other) const {
+            return fg == other.fg && bg == other.bg && attr == other.attr;
+        }
+
+        friend uint qHash(const Key &key, uint seed = 0) {
+            return qHash(key.fg, seed) ^ qHash(key.bg * 31 + key.attr, seed);
+        }
+    };
+
+    QHash<Key, termpaint_attr*> entries;
+};
+
 class ZPainterPrivate {
 public:
     ZPainterPrivate(termpaint_surface *surface, int width, int height, std::shared_ptr<char> token = nullptr);
@@ -28,9 +63,18 @@ class ZPainterPrivate {
     int x = 0, y = 0, width = 0, height = 0;
     // Translation relative to top-left corner of clipping rect
     int offsetX = 0, offsetY = 0;
+    // Set when only damaged parts of the terminal are repainted. Widgets completely outside of the clip rect
+    // can then be skipped.
+    bool damagedAreaOnly = false;
+    // Set by the terminal to count the widgets painted in a frame.
+    int *widgetsPainted = nullptr;
 
     QPointer<ZWidget> widget;
 
+    // Shared with copies of the painter, created on first use if the creator of the painter did not supply one.
+    std::shared_ptr<ZPainterAttributeCache> attributeCache;
+    termpaint_attr *termpaintAttr(ZColor fg, ZColor bg, ZTextAttributes attr);
+
     // back door
     static ZPainterPrivate *get(ZPainter *painter) { return painter->tuiwidgets_impl(); }
     static ZPainter createForTesting(termpaint_surface *surface);
@@ -7,6 +7,7 @@
 
 #include <Tui/ZColor.h>
 #include <Tui/ZWidget.h>
+#include <Tui/ZWidget_p.h>
 
 TUIWIDGETS_NS_START
 
@@ -26,57 +27,75 @@ ZPalette::~ZPalette() {
 
 }
 
-ZColor ZPalette::getColor(ZWidget *targetWidget, ZImplicitSymbol x) {
-    // TODO Most stupid impl., needs optimization
-
-    QList<ZWidget*> widgets;
-    {
-        ZWidget *w = targetWidget;
-        while (w) {
-            widgets.prepend(w);
-            w = w->parentWidget();
-        }
-    }
+namespace {
+    void applyPaletteLevel(ZWidget *w, const QList<const ZPalette::RuleDef*> &rules, QHash<ZSymbol, ZColor> &defs,
+                           bool includeLocal) {
+        const QSet<QString> widgetClasses = w->paletteClass().toSet();
 
-    QHash<ZSymbol, ZColor> defs;
-    QList<const RuleDef*> rules;
+        QMap<int, QList<const ZPalette::RuleDef*>> matchingRulesByLen;
 
-    for (ZWidget *w : widgets) {
-        QSet<QString> widgetClasses = w->paletteClass().toSet();
-
-        const ZPalettePrivate &pal = *w->palette().tuiwidgets_pimpl_ptr;
-
-        for (const auto &rule : qAsConst(pal.rules)) {
-            rules.append(&rule);
-        }
-
-        QMap<int, QList<const RuleDef*>> matchingRulesByLen;
-
-        for (const RuleDef *rule : rules) {
+        for (const ZPalette::RuleDef *rule : rules) {
             if (widgetClasses.contains(rule->classes)) {
                 matchingRulesByLen[rule->classes.size()].append(rule);
             }
         }
 
         for (auto &rs : qAsConst(matchingRulesByLen)) {
-            for (const RuleDef *r : qAsConst(rs)) {
-                for (const RuleCmd &cmd : r->cmds) {
-                    if (cmd.type == Publish || w == targetWidget) {
-                        if (defs.contains(cmd.reference)) {
-                            defs[cmd.name] = defs[cmd.reference];
+            for (const ZPalette::RuleDef *r : qAsConst(rs)) {
+                for (const ZPalette::RuleCmd &cmd : r->cmds) {
+                    if (cmd.type == ZPalette::Publish || includeLocal) {
+                        auto it = defs.constFind(cmd.reference);
+                        if (it != defs.constEnd()) {
+                            defs[cmd.name] = it.value();
                         }
                     }
                 }
             }
         }
+    }
+
+    const ZWidgetPrivate::PaletteCache &ensurePaletteCache(ZWidget *w) {
+        auto *const wp = ZWidgetPrivate::get(w);
+        auto &cache = wp->paletteCache;
+        if (cache.valid) {
+            return cache;
+        }
+
+        if (w->parentWidget()) {
+            const auto &parentCache = ensurePaletteCache(w->parentWidget());
+            cache.rules = parentCache.rules;
+            cache.published = parentCache.published;
+        } else {
+            cache.rules.clear();
+            cache.published.clear();
+        }
 
-        for (ZSymbol key : pal.colorDefinitions.keys()) {
-            defs[key] = pal.colorDefinitions[key];
+        const ZPalettePrivate &pal = *ZPalettePrivate::get(&wp->palette);
+        for (const auto &rule : qAsConst(pal.rules)) {
+            cache.rules.append(&rule);
         }
+
+        // QHash is implicitly shared, so this only copies if local rules apply.
+        cache.resolved = cache.published;
+        applyPaletteLevel(w, cache.rules, cache.published, false);
+        applyPaletteLevel(w, cache.rules, cache.resolved, true);
+
+        for (auto it = pal.colorDefinitions.constBegin(); it != pal.colorDefinitions.constEnd(); ++it) {
+            cache.published[it.key()] = it.value();
+            cache.resolved[it.key()] = it.value();
+        }
+
+        cache.valid = true;
+        return cache;
     }
+}
+
+ZColor ZPalette::getColor(ZWidget *targetWidget, ZImplicitSymbol x) {
+    const QHash<ZSymbol, ZColor> &defs = ensurePaletteCache(targetWidget).resolved;
 
-    if (defs.contains(x)) {
-        return defs.value(x);
+    auto it = defs.constFind(x);
+    if (it != defs.constEnd()) {
+        return it.value();
     }
     return {0xff, 0, 0};
 }
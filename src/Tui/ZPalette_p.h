@@ -21,6 +21,9 @@ class ZPalettePrivate {
     QHash<ZSymbol, ZSymbol> localAlias;
     QList<ZPalette::RuleDef> rules;
 
+    // back door
+    static const ZPalettePrivate *get(const ZPalette *palette) { return palette->tuiwidgets_impl(); }
+
     ZPalette *pub_ptr;
     TUIWIDGETS_DECLARE_PUBLIC(ZPalette)
 };
@@ -2,53 +2,192 @@
 
 #include "ZSymbol.h"
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <QDebug>
-#include <QHash>
+#include <QtAlgorithms>
 
 TUIWIDGETS_NS_START
 
-static QHash<QString, int> &ZSymbol_table() {
-    static QHash<QString, int> data;
-    return data;
-}
-static QList<QString> &ZSymbol_reverse() {
-    static QList<QString> data;
-    return data;
+// The symbol registry is read much more often than it is written. Lookups of already known symbols and toString
+// don't take any locks. Writers are serialized by a mutex and only ever publish fully constructed, immutable data.
+// Tables that have been replaced are kept alive, as readers might still use them.
+
+namespace {
+    struct SymbolEntry {
+        unsigned hash;
+        int id;
+        QString str;
+    };
+
+    struct SymbolTable {
+        explicit SymbolTable(int size) : mask(size - 1), slots(new std::atomic<const SymbolEntry*>[size]) {
+            for (int i = 0; i < size; i++) {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        // linear probing, load factor is kept below 1/2
+        const int mask;
+        std::unique_ptr<std::atomic<const SymbolEntry*>[]> slots;
+    };
+
+    // id - 1 is used as index into segments of doubling size, so that existing segments never need to move.
+    constexpr int firstSegmentSize = 64;
+    constexpr int maxSegments = 26;
+
+    struct SymbolRegistry {
+        std::mutex mutex;
+        std::atomic<const SymbolTable*> table { nullptr };
+        std::atomic<std::atomic<const SymbolEntry*>*> segments[maxSegments] = {};
+
+        // only accessed with mutex held
+        std::deque<SymbolEntry> entries;
+        std::vector<std::unique_ptr<SymbolTable>> tables;
+        std::vector<std::unique_ptr<std::atomic<const SymbolEntry*>[]>> segmentStorage;
+    };
+
+    SymbolRegistry &registry() {
+        static SymbolRegistry data;
+        return data;
+    }
+
+    void segmentForIndex(int index, int *segment, int *offset) {
+        const unsigned v = static_cast<unsigned>(index) / firstSegmentSize + 1;
+        *segment = 31 - qCountLeadingZeroBits(v);
+        *offset = index - firstSegmentSize * ((1 << *segment) - 1);
+    }
+
+    template <typename Eq>
+    const SymbolEntry *findEntry(const SymbolTable *table, unsigned hash, Eq eq) {
+        if (!table) {
+            return nullptr;
+        }
+        for (unsigned i = hash & table->mask;; i = (i + 1) & table->mask) {
+            const SymbolEntry *entry = table->slots[i].load(std::memory_order_acquire);
+            if (!entry) {
+                return nullptr;
+            }
+            if (entry->hash == hash && eq(entry->str)) {
+                return entry;
+            }
+        }
+    }
+
+    void insertIntoTable(SymbolTable *table, const SymbolEntry *entry) {
+        unsigned i = entry->hash & table->mask;
+        while (table->slots[i].load(std::memory_order_relaxed)) {
+            i = (i + 1) & table->mask;
+        }
+        table->slots[i].store(entry, std::memory_order_release);
+    }
+
+    // needs registry mutex
+    int createSymbol(SymbolRegistry &reg, unsigned hash, QString str) {
+        const int id = static_cast<int>(reg.entries.size()) + 1;
+        reg.entries.push_back(SymbolEntry{hash, id, str});
+        const SymbolEntry *entry = &reg.entries.back();
+
+        int segment;
+        int offset;
+        segmentForIndex(id - 1, &segment, &offset);
+        std::atomic<const SymbolEntry*> *segmentData = reg.segments[segment].load(std::memory_order_relaxed);
+        if (!segmentData) {
+            const int segmentSize = firstSegmentSize << segment;
+            segmentData = new std::atomic<const SymbolEntry*>[segmentSize];
+            for (int i = 0; i < segmentSize; i++) {
+                segmentData[i].store(nullptr, std::memory_order_relaxed);
+            }
+            reg.segmentStorage.emplace_back(segmentData);
+            reg.segments[segment].store(segmentData, std::memory_order_release);
+        }
+        // publish for toString before the symbol can be found by lookups
+        segmentData[offset].store(entry, std::memory_order_release);
+
+        const SymbolTable *current = reg.table.load(std::memory_order_relaxed);
+        if (current && static_cast<int>(reg.entries.size()) * 2 <= current->mask + 1) {
+            insertIntoTable(reg.tables.back().get(), entry);
+        } else {
+            auto newTable = std::make_unique<SymbolTable>(current ? (current->mask + 1) * 2 : 512);
+            for (const SymbolEntry &e: reg.entries) {
+                insertIntoTable(newTable.get(), &e);
+            }
+            reg.table.store(newTable.get(), std::memory_order_release);
+            reg.tables.push_back(std::move(newTable));
+        }
+
+        return id;
+    }
+
+    template <typename Eq, typename Make>
+    int lookupCommon(unsigned hash, Eq eq, Make make, bool create) {
+        SymbolRegistry &reg = registry();
+
+        if (const SymbolEntry *entry = findEntry(reg.table.load(std::memory_order_acquire), hash, eq)) {
+            return entry->id;
+        }
+
+        std::lock_guard<std::mutex> g(reg.mutex);
+
+        // The symbol might have been created or the table might have been replaced in the meantime.
+        if (const SymbolEntry *entry = findEntry(reg.table.load(std::memory_order_relaxed), hash, eq)) {
+            return entry->id;
+        }
+
+        if (create) {
+            return createSymbol(reg, hash, make());
+        }
+
+        return 0;
+    }
 }
 
 QString ZSymbol::toString() const {
     if (id == 0) {
         return QStringLiteral("");
     }
-    return ZSymbol_reverse().at(id - 1);
+
+    int segment;
+    int offset;
+    segmentForIndex(id - 1, &segment, &offset);
+    const SymbolEntry *entry = registry().segments[segment].load(std::memory_order_acquire)[offset]
+            .load(std::memory_order_acquire);
+    return entry->str;
 }
 
 int ZSymbol::lookup(QString str, bool create) {
-    static int max = 0;
-    static std::mutex mut;
-
     if (str.isEmpty()) {
         return 0;
     }
 
-    std::lock_guard<std::mutex> g(mut);
+    const unsigned hash = hashCodeUnits(str.utf16(), str.size());
+    return lookupCommon(hash,
+                        [&str](const QString &candidate) { return candidate == str; },
+                        [&str] { return str; },
+                        create);
+}
 
-    auto &table = ZSymbol_table();
-    auto it = table.find(str);
-    if (it != table.end()) {
-        return it.value();
+int ZSymbol::lookupUtf8(const char *utf8, int size, unsigned hash) {
+    if (size == 0) {
+        return 0;
     }
 
-    if (create) {
-        ++max;
-        table.insert(str, max);
-        ZSymbol_reverse().append(str);
-        return max;
+    for (int i = 0; i < size; i++) {
+        if (static_cast<unsigned char>(utf8[i]) >= 0x80) {
+            // The hash of the utf8 bytes does not match the hash of the utf16 code units.
+            return lookup(QString::fromUtf8(utf8, size), true);
+        }
     }
 
-    return 0;
+    const QLatin1String str(utf8, size);
+    return lookupCommon(hash,
+                        [str](const QString &candidate) { return candidate == str; },
+                        [str] { return QString(str); },
+                        true);
 }
 
 QDebug operator<<(QDebug dbg, const ZSymbol &sym) {
@@ -3,6 +3,8 @@
 #ifndef TUIWIDGETS_ZSYMBOL_INCLUDED
 #define TUIWIDGETS_ZSYMBOL_INCLUDED
 
+#include <type_traits>
+
 #include <QMetaType>
 #include <QString>
 
@@ -54,8 +56,34 @@ class TUIWIDGETS_EXPORT ZSymbol {
 
     friend struct std::hash<ZSymbol>;
 
+protected:
+    struct LiteralTag {};
+    // size is in bytes, hash must be hashCodeUnits(utf8, size)
+    ZSymbol(LiteralTag, const char *utf8, int size, unsigned hash) : id(lookupUtf8(utf8, size, hash)) {}
+
+    // FNV-1a over the (utf16) code units. For ascii text the bytes are the code units, thus string literals can be
+    // hashed at compile time and still match symbols created from QString.
+    template <typename T>
+    static constexpr unsigned hashCodeUnits(const T *str, int size) {
+        unsigned hash = 2166136261u;
+        for (int i = 0; i < size; i++) {
+            hash ^= static_cast<std::make_unsigned_t<T>>(str[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static constexpr int literalLength(const char *literal, int max) {
+        int len = 0;
+        while (len < max && literal[len]) {
+            len++;
+        }
+        return len;
+    }
+
 private:
     static int lookup(QString str, bool create);
+    static int lookupUtf8(const char *utf8, int size, unsigned hash);
 
 private:
     int id = 0;
@@ -63,14 +91,16 @@ class TUIWIDGETS_EXPORT ZSymbol {
 
 QDebug operator<<(QDebug dbg, const ZSymbol &message);
 
-#define TUISYM_LITERAL(x) ([] { static ::Tui::ZSymbol m{QString::fromUtf8(x)}; return m; }())
+#define TUISYM_LITERAL(x) ([] { static const ::Tui::ZSymbol m = ::Tui::ZImplicitSymbol(x); return m; }())
 
 class TUIWIDGETS_EXPORT ZImplicitSymbol : public ZSymbol {
 public:
     constexpr ZImplicitSymbol() = default;
     ZImplicitSymbol(const ZSymbol &other) : ZSymbol(other) {}
     ZImplicitSymbol(QString str) : ZSymbol(str) {}
-    template <int N> ZImplicitSymbol(const char(&literal)[N]) : ZSymbol(QString::fromUtf8(literal)) {}
+    template <int N> ZImplicitSymbol(const char(&literal)[N])
+        : ZSymbol(LiteralTag{}, literal, literalLength(literal, N),
+                  hashCodeUnits(literal, literalLength(literal, N))) {}
 };
 
 TUIWIDGETS_NS_END
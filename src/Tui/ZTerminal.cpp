@@ -7,6 +7,7 @@
 
 #include <QAbstractEventDispatcher>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QMetaMethod>
 #include <QPointer>
 #include <QThread>
@@ -24,6 +25,9 @@
 
 TUIWIDGETS_NS_START
 
+// Initial capacity of the buffer used to assemble bracketed pastes for widgets that don't accept paste chunks
+static constexpr int pasteBufferReserve = 64 * 1024;
+
 class ZTerminal::TerminalConnectionPrivate {
 public:
     static TerminalConnectionPrivate *get(ZTerminal::TerminalConnection *data) { return data->tuiwidgets_pimpl_ptr.get(); }
@@ -38,6 +42,15 @@ class ZTerminal::TerminalConnectionPrivate {
 
 static ZSymbol extendedCharset = TUISYM_LITERAL("extendedCharset");
 
+namespace {
+    // Frame times below 250µs, 500µs, ..., 128ms and above that.
+    constexpr int frameTimeHistogramBuckets = 11;
+    constexpr qint64 frameTimeHistogramFirstLimit = 250000;
+    constexpr int frameTimeHistogramWindow = 256;
+
+    constexpr qint64 maxAdaptiveFrameInterval = 500;
+}
+
 ZTerminalPrivate::ZTerminalPrivate(ZTerminal *pub, ZTerminal::Options options)
     : options(options)
 {
@@ -69,6 +82,8 @@ void ZTerminalPrivate::setFocus(ZWidget *w) {
         focusWidget = ZWidgetPrivate::get(w);
         focusHistory.appendOrMoveToLast(focusWidget);
     }
+    // focus influences the look of more than just the involved widgets (e.g. window frames, labels with buddies)
+    pub()->update();
     Q_EMIT pub()->focusChanged();
 }
 
@@ -223,6 +238,19 @@ namespace {
         int& _generation;
         bool nested = false;
     };
+
+    struct LayoutPassScope {
+        LayoutPassScope() : _previous(ZTerminalPrivate::activeLayoutPass) {
+            ZTerminalPrivate::activeLayoutPass = ++ZTerminalPrivate::layoutPassCounter;
+        }
+
+        ~LayoutPassScope() {
+            ZTerminalPrivate::activeLayoutPass = _previous;
+        }
+
+    private:
+        uint64_t _previous;
+    };
 }
 
 void ZTerminal::doLayout() {
@@ -230,6 +258,11 @@ void ZTerminal::doLayout() {
     QList<QPointer<ZWidget>> copy = p->layoutPendingWidgets;
     p->layoutPendingWidgets.clear();
     LayoutGenerationUpdaterScope generationUpdater(p->layoutGeneration);
+    LayoutPassScope layoutPass;
+
+    if (p->testingLayoutPassCounters) {
+        *p->testingLayoutPassCounters = {};
+    }
 
     auto last = std::remove(copy.begin(), copy.end(), nullptr);
     copy.erase(last, copy.end());
@@ -283,14 +316,111 @@ void ZTerminalPrivate::resetTestLayoutRequestTracker() {
     testingLayoutRequestTrackingClosure = {};
 }
 
+namespace {
+    constexpr int maxDamagedRects = 16;
+
+    void mergeDamagedRect(QVector<QRect> &rects, QRect rect) {
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (int i = 0; i < rects.size(); i++) {
+                if (rects[i].contains(rect)) {
+                    return;
+                }
+                if (rects[i].intersects(rect)) {
+                    rect = rect.united(rects[i]);
+                    rects.remove(i);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        rects.append(rect);
+        if (rects.size() > maxDamagedRects) {
+            // Too fragmented, fall back to painting the bounding rect.
+            QRect bounding;
+            for (const QRect &r : rects) {
+                bounding = bounding.united(r);
+            }
+            rects.clear();
+            rects.append(bounding);
+        }
+    }
+}
+
+void ZTerminalPrivate::scheduleUpdate() {
+    if (updateRequested) {
+        if (inputSinceLastFrame && frameLimitTimer && frameLimitTimer->isActive()) {
+            // Don't delay the reaction to input.
+            frameLimitTimer->stop();
+            QCoreApplication::postEvent(pub(), new ZPaintEvent(ZPaintEvent::update, nullptr), Qt::LowEventPriority);
+        }
+        return;
+    }
+    updateRequested = true;
+    // XXX ZTerminal uses updateRequest with null painter internally
+    QCoreApplication::postEvent(pub(), new ZPaintEvent(ZPaintEvent::update, nullptr), Qt::LowEventPriority);
+}
+
+int ZTerminalPrivate::frameDelay() const {
+    int interval = minimumFrameInterval;
+    if (adaptiveFrameInterval) {
+        // Writing to the terminal blocks when the terminal does not keep up. Waiting as long as the last flush took
+        // limits the time spent blocked to about half of the time.
+        const qint64 flushMsec = ZTerminal::RenderStatisticsData::get(&renderStatistics)->flushNanoseconds / 1000000;
+        interval = std::max(interval, static_cast<int>(std::min(flushMsec, maxAdaptiveFrameInterval)));
+    }
+    if (interval <= 0 || !lastFrameEnd.isValid()) {
+        return 0;
+    }
+    return static_cast<int>(std::max<qint64>(0, interval - lastFrameEnd.elapsed()));
+}
+
+void ZTerminalPrivate::startFrameLimitTimer(int msec) {
+    if (!frameLimitTimer) {
+        frameLimitTimer = std::make_unique<QTimer>();
+        frameLimitTimer->setSingleShot(true);
+        QObject::connect(frameLimitTimer.get(), &QTimer::timeout, pub(), [this] {
+            if (!pendingOutput.isEmpty()) {
+                // updateRequested stays set until the pending output is written
+                frameDeferredByOutput = true;
+                return;
+            }
+            updateRequested = false;
+            processPaintingAndUpdateOutput(false);
+        });
+    }
+    frameLimitTimer->start(msec);
+}
+
+void ZTerminalPrivate::addDamagedRect(QRect rect) {
+    if (rect.isEmpty()) {
+        return;
+    }
+    if (!fullRepaintPending) {
+        mergeDamagedRect(damagedRects, rect);
+    }
+    scheduleUpdate();
+}
+
 void ZTerminalPrivate::processPaintingAndUpdateOutput(bool fullRepaint) {
+    if (frameLimitTimer && frameLimitTimer->isActive()) {
+        // this frame covers the delayed update
+        frameLimitTimer->stop();
+        updateRequested = false;
+    }
+    inputSinceLastFrame = false;
+
     if (mainWidgetFullyAttached()) {
         Q_EMIT pub()->beforeRendering();
 
+        QElapsedTimer frameTimer;
+        frameTimer.start();
+
         if (pub()->isLayoutPending()) {
             pub()->doLayout();
         }
-        cursorPosition = QPoint{-1, -1};
+        const bool viewportWasActive = viewportActive;
         const QSize minSize = mainWidget->minimumSize().expandedTo(mainWidget->minimumSizeHint());
         {
             int geoWidth = std::max(minSize.width(), termpaint_surface_width(surface));
@@ -304,6 +434,8 @@ void ZTerminalPrivate::processPaintingAndUpdateOutput(bool fullRepaint) {
             }
         }
 
+        const qint64 layoutNanoseconds = frameTimer.nsecsElapsed();
+
         std::unique_ptr<ZPainter> paint;
         std::unique_ptr<ZImage> img;
         if (minSize.width() > termpaint_surface_width(surface) || minSize.height() > termpaint_surface_height(surface)) {
@@ -323,9 +455,56 @@ void ZTerminalPrivate::processPaintingAndUpdateOutput(bool fullRepaint) {
             viewportOffset.setY(0);
             paint = std::make_unique<ZPainter>(pub()->painter());
         }
-        paint->setWidget(mainWidget.data());
-        ZPaintEvent event(ZPaintEvent::update, paint.get());
-        QCoreApplication::sendEvent(mainWidget.data(), &event);
+
+        // The viewport renders into a temporary image, so partial repaints are only possible when painting
+        // directly to the terminal and the previous frame did that too.
+        const bool repaintAll = fullRepaint || fullRepaintPending || viewportActive || viewportWasActive;
+        QVector<QRect> damage = std::move(damagedRects);
+        damagedRects.clear();
+        fullRepaintPending = false;
+
+        widgetsPainted = 0;
+        ZPainterPrivate::get(paint.get())->widgetsPainted = &widgetsPainted;
+        int cellsRepainted = 0;
+
+        if (repaintAll) {
+            cellsRepainted = termpaint_surface_width(surface) * termpaint_surface_height(surface);
+            cursorPosition = QPoint{-1, -1};
+            paint->setWidget(mainWidget.data());
+            ZPaintEvent event(ZPaintEvent::update, paint.get());
+            QCoreApplication::sendEvent(mainWidget.data(), &event);
+        } else {
+            if (focusWidget) {
+                // The cursor position is only set while the focus widget paints. So if it needs to paint at all
+                // it is repainted completely, otherwise the cursor position of the previous frame is kept.
+                const QRect focusRect = focusWidget->visibleRectInTerminal();
+                bool focusDamaged = false;
+                for (const QRect &rect : qAsConst(damage)) {
+                    if (rect.intersects(focusRect)) {
+                        focusDamaged = true;
+                        break;
+                    }
+                }
+                if (focusDamaged) {
+                    mergeDamagedRect(damage, focusRect);
+                    cursorPosition = QPoint{-1, -1};
+                }
+            } else {
+                cursorPosition = QPoint{-1, -1};
+            }
+
+            for (const QRect &rect : qAsConst(damage)) {
+                cellsRepainted += rect.width() * rect.height();
+                // clip to the damaged rect but keep the origin of the terminal
+                ZPainter clipped = paint->translateAndClip(rect).translateAndClip(-rect.x(), -rect.y(),
+                                                                                  rect.x() + rect.width(),
+                                                                                  rect.y() + rect.height());
+                ZPainterPrivate::get(&clipped)->damagedAreaOnly = true;
+                clipped.setWidget(mainWidget.data());
+                ZPaintEvent event(ZPaintEvent::update, &clipped);
+                QCoreApplication::sendEvent(mainWidget.data(), &event);
+            }
+        }
         if (initState == ZTerminalPrivate::InitState::Ready) {
             QPoint realCursorPosition = cursorPosition + viewportOffset;
             const bool cursorVisible = !(realCursorPosition.x() < 0
@@ -359,13 +538,52 @@ void ZTerminalPrivate::processPaintingAndUpdateOutput(bool fullRepaint) {
                                                 ZColor::defaultColor(), ZColor::defaultColor());
             }
         }
+        const qint64 paintNanoseconds = frameTimer.nsecsElapsed() - layoutNanoseconds;
+
         Q_EMIT pub()->afterRendering();
+
+        frameTimer.restart();
+        const qint64 bytesWrittenBefore = bytesWritten;
         if (fullRepaint) {
             pub()->updateOutputForceFullRepaint();
         } else {
             pub()->updateOutput();
         }
+        recordFrame(layoutNanoseconds, paintNanoseconds, frameTimer.nsecsElapsed(),
+                    bytesWritten - bytesWrittenBefore, cellsRepainted);
+        lastFrameEnd.start();
+    }
+}
+
+void ZTerminalPrivate::recordFrame(qint64 layoutNanoseconds, qint64 paintNanoseconds, qint64 flushNanoseconds,
+                                   qint64 bytesWrittenInFrame, int cellsRepainted) {
+    auto *const stats = ZTerminal::RenderStatisticsData::get(&renderStatistics);
+    stats->frameCount++;
+    stats->layoutNanoseconds = layoutNanoseconds;
+    stats->paintNanoseconds = paintNanoseconds;
+    stats->flushNanoseconds = flushNanoseconds;
+    stats->frameNanoseconds = layoutNanoseconds + paintNanoseconds + flushNanoseconds;
+    stats->bytesWritten = bytesWrittenInFrame;
+    stats->cellsRepainted = cellsRepainted;
+    stats->widgetsPainted = widgetsPainted;
+
+    auto bucketFor = [](qint64 nanoseconds) {
+        int bucket = 0;
+        while (bucket + 1 < frameTimeHistogramBuckets
+               && nanoseconds >= ZTerminal::RenderStatistics::frameTimeHistogramBucketLimit(bucket)) {
+            bucket++;
+        }
+        return bucket;
+    };
+
+    if (recentFrameTimes.size() < frameTimeHistogramWindow) {
+        recentFrameTimes.append(stats->frameNanoseconds);
+    } else {
+        stats->frameTimeHistogram[bucketFor(recentFrameTimes[recentFrameIndex])]--;
+        recentFrameTimes[recentFrameIndex] = stats->frameNanoseconds;
+        recentFrameIndex = (recentFrameIndex + 1) % frameTimeHistogramWindow;
     }
+    stats->frameTimeHistogram[bucketFor(stats->frameNanoseconds)]++;
 }
 
 void ZTerminal::dispatcherIsAboutToBlock() {
@@ -596,15 +814,24 @@ bool ZTerminal::isDefaultTerminalAvailable() {
 }
 
 ZPainter ZTerminal::painter() {
-    auto *surface = tuiwidgets_impl()->surface;
-    return ZPainter(std::make_unique<ZPainterPrivate>(surface,
-                                                      termpaint_surface_width(surface),
-                                                      termpaint_surface_height(surface)));
+    auto *const p = tuiwidgets_impl();
+    auto *surface = p->surface;
+    if (!p->painterAttributeCache) {
+        p->painterAttributeCache = std::make_shared<ZPainterAttributeCache>();
+    }
+    auto painterPrivate = std::make_unique<ZPainterPrivate>(surface,
+                                                            termpaint_surface_width(surface),
+                                                            termpaint_surface_height(surface));
+    painterPrivate->attributeCache = p->painterAttributeCache;
+    return ZPainter(std::move(painterPrivate));
 }
 
 ZTextMetrics ZTerminal::textMetrics() const {
-    auto *surface = tuiwidgets_impl()->surface;
-    return ZTextMetrics(std::make_shared<ZTextMetricsPrivate>(surface));
+    auto *const p = tuiwidgets_impl();
+    if (!p->textMetrics || p->textMetrics->surface != p->surface) {
+        p->textMetrics = std::make_shared<ZTextMetricsPrivate>(p->surface);
+    }
+    return ZTextMetrics(p->textMetrics);
 }
 
 ZWidget *ZTerminal::mainWidget() const {
@@ -708,12 +935,10 @@ ZWidget *ZTerminal::keyboardGrabber() const {
 }
 
 void ZTerminal::update() {
-    if (tuiwidgets_impl()->updateRequested) {
-        return;
-    }
-    tuiwidgets_impl()->updateRequested = true;
-    // XXX ZTerminal uses updateRequest with null painter internally
-    QCoreApplication::postEvent(this, new ZPaintEvent(ZPaintEvent::update, nullptr), Qt::LowEventPriority);
+    auto *const p = tuiwidgets_impl();
+    p->fullRepaintPending = true;
+    p->damagedRects.clear();
+    p->scheduleUpdate();
 }
 
 void ZTerminal::forceRepaint() {
@@ -808,6 +1033,48 @@ void ZTerminal::updateOutputForceFullRepaint() {
     }
 }
 
+ZTerminal::RenderStatistics ZTerminal::renderStatistics() const {
+    auto *const p = tuiwidgets_impl();
+    return p->renderStatistics;
+}
+
+void ZTerminal::resetRenderStatistics() {
+    auto *const p = tuiwidgets_impl();
+    p->renderStatistics = RenderStatistics();
+    p->recentFrameTimes.clear();
+    p->recentFrameIndex = 0;
+}
+
+int ZTerminal::minimumFrameInterval() const {
+    auto *const p = tuiwidgets_impl();
+    return p->minimumFrameInterval;
+}
+
+void ZTerminal::setMinimumFrameInterval(int msec) {
+    auto *const p = tuiwidgets_impl();
+    p->minimumFrameInterval = std::max(0, msec);
+}
+
+bool ZTerminal::adaptiveFrameInterval() const {
+    auto *const p = tuiwidgets_impl();
+    return p->adaptiveFrameInterval;
+}
+
+void ZTerminal::setAdaptiveFrameInterval(bool enable) {
+    auto *const p = tuiwidgets_impl();
+    p->adaptiveFrameInterval = enable;
+}
+
+int ZTerminal::outputBufferLimit() const {
+    auto *const p = tuiwidgets_impl();
+    return p->outputBufferLimit;
+}
+
+void ZTerminal::setOutputBufferLimit(int bytes) {
+    auto *const p = tuiwidgets_impl();
+    p->outputBufferLimit = std::max(0, bytes);
+}
+
 QString ZTerminal::title() const {
     auto *const p = tuiwidgets_impl();
     return p->title;
@@ -1055,6 +1322,7 @@ std::unique_ptr<ZKeyEvent> ZTerminal::translateKeyEvent(const ZTerminalNativeEve
 
 void ZTerminal::dispatchKeyboardEvent(ZKeyEvent &translated) {
     auto *const p = tuiwidgets_impl();
+    p->inputSinceLastFrame = true;
     if (p->keyboardGrabWidget) {
         if (p->keyboardGrabHandler) {
             p->keyboardGrabHandler(&translated);
@@ -1076,6 +1344,7 @@ void ZTerminal::dispatchKeyboardEvent(ZKeyEvent &translated) {
 
 void ZTerminal::dispatchPasteEvent(ZPasteEvent &translated) {
     auto *const p = tuiwidgets_impl();
+    p->inputSinceLastFrame = true;
     if (p->keyboardGrabWidget) {
         if (p->keyboardGrabHandler) {
             p->keyboardGrabHandler(&translated);
@@ -1095,6 +1364,67 @@ void ZTerminal::dispatchPasteEvent(ZPasteEvent &translated) {
     }
 }
 
+void ZTerminalPrivate::processPasteChunk(const QString &text, bool initial, bool final) {
+    inputSinceLastFrame = true;
+
+    if (initial) {
+        pasteTemp.clear();
+        ZPasteEvent event{ZPasteEvent::chunk, text, true, final};
+        pasteChunkReceiver = dispatchPasteChunkEvent(&event);
+        pasteChunked = !pasteChunkReceiver.isNull();
+        if (!pasteChunked) {
+            pasteTemp.reserve(std::max(pasteBufferReserve, text.size()));
+            pasteTemp += text;
+        }
+    } else if (pasteChunked) {
+        // If the receiving widget was deleted while the paste is in progress the rest of the paste is dropped.
+        if (pasteChunkReceiver) {
+            ZPasteEvent event{ZPasteEvent::chunk, text, false, final};
+            QCoreApplication::sendEvent(pasteChunkReceiver, &event);
+        }
+    } else {
+        pasteTemp += text;
+    }
+
+    if (final) {
+        if (!pasteChunked) {
+            ZPasteEvent event{pasteTemp};
+            // Don't keep the (possibly large) buffer around after the paste.
+            pasteTemp.clear();
+            pub()->dispatchPasteEvent(event);
+        }
+        pasteChunkReceiver = nullptr;
+        pasteChunked = false;
+    }
+}
+
+ZWidget *ZTerminalPrivate::dispatchPasteChunkEvent(ZPasteEvent *event) {
+    // Widgets opt in to chunked pastes by accepting the initial chunk, so the event is sent in the ignored state.
+    if (keyboardGrabWidget) {
+        if (keyboardGrabHandler) {
+            // grab handlers only get complete paste events
+            return nullptr;
+        }
+        event->ignore();
+        QCoreApplication::sendEvent(keyboardGrabWidget, event);
+        return event->isAccepted() ? keyboardGrabWidget.data() : nullptr;
+    }
+
+    QPointer<ZWidget> w = focus();
+    while (w) {
+        event->ignore();
+        QCoreApplication::sendEvent(w, event);
+        if (!w) {
+            break;
+        }
+        if (event->isAccepted()) {
+            return w;
+        }
+        w = w->parentWidget();
+    }
+    return nullptr;
+}
+
 void ZTerminalPrivate::adjustViewportOffset() {
     viewportOffset.setX(std::min(0, std::max(viewportRange.x(), viewportOffset.x())));
     viewportOffset.setY(std::min(0, std::max(viewportRange.y(), viewportOffset.y())));
@@ -1148,15 +1478,8 @@ bool ZTerminal::event(QEvent *event) {
                 }
             }
         } else if (native->type == TERMPAINT_EV_PASTE) {
-            if (native->paste.initial) {
-                p->pasteTemp = QString::fromUtf8(native->paste.string, native->paste.length);
-            } else {
-                p->pasteTemp += QString::fromUtf8(native->paste.string, native->paste.length);
-            }
-            if (native->paste.final) {
-                std::unique_ptr<ZPasteEvent> translated = std::make_unique<ZPasteEvent>(p->pasteTemp);
-                dispatchPasteEvent(*translated);
-            }
+            p->processPasteChunk(QString::fromUtf8(native->paste.string, native->paste.length),
+                                 native->paste.initial, native->paste.final);
         } else if (native->type == TERMPAINT_EV_REPAINT_REQUESTED) {
             update();
         } else if (native->type == TERMPAINT_EV_AUTO_DETECT_FINISHED) {
@@ -1230,8 +1553,19 @@ bool ZTerminal::event(QEvent *event) {
     }
     if (event->type() == ZEventType::updateRequest()) {
         // XXX ZTerminal uses updateRequest with null painter internally
-        p->updateRequested = false;
-        p->processPaintingAndUpdateOutput(false);
+        const int delay = p->inputSinceLastFrame ? 0 : p->frameDelay();
+        if (!p->pendingOutput.isEmpty()) {
+            // The terminal did not yet accept all output of the previous frame. Painting now would only queue more
+            // output, so skip this frame. When the output is written the next frame contains all changes since.
+            // updateRequested stays set until then.
+            p->frameDeferredByOutput = true;
+        } else if (delay > 0) {
+            // updateRequested stays set until the timer triggers the frame
+            p->startFrameLimitTimer(delay);
+        } else {
+            p->updateRequested = false;
+            p->processPaintingAndUpdateOutput(false);
+        }
     }
     if (event->type() == QEvent::LayoutRequest) {
         Q_EMIT beforeRendering();
@@ -1292,6 +1626,57 @@ ZTerminal::OffScreen ZTerminal::OffScreen::withoutCapability(ZSymbol capability)
 ZTerminal::OffScreenData::OffScreenData(int width, int height) : width(width), height(height) {
 }
 
+ZTerminal::RenderStatistics::RenderStatistics() {
+    tuiwidgets_pimpl_ptr.get()->frameTimeHistogram.fill(0, frameTimeHistogramBuckets);
+}
+
+ZTerminal::RenderStatistics::RenderStatistics(const ZTerminal::RenderStatistics&) = default;
+ZTerminal::RenderStatistics::~RenderStatistics() = default;
+ZTerminal::RenderStatistics& ZTerminal::RenderStatistics::operator=(const ZTerminal::RenderStatistics&) = default;
+
+int ZTerminal::RenderStatistics::frameCount() const {
+    return tuiwidgets_pimpl_ptr.get()->frameCount;
+}
+
+qint64 ZTerminal::RenderStatistics::layoutNanoseconds() const {
+    return tuiwidgets_pimpl_ptr.get()->layoutNanoseconds;
+}
+
+qint64 ZTerminal::RenderStatistics::paintNanoseconds() const {
+    return tuiwidgets_pimpl_ptr.get()->paintNanoseconds;
+}
+
+qint64 ZTerminal::RenderStatistics::flushNanoseconds() const {
+    return tuiwidgets_pimpl_ptr.get()->flushNanoseconds;
+}
+
+qint64 ZTerminal::RenderStatistics::frameNanoseconds() const {
+    return tuiwidgets_pimpl_ptr.get()->frameNanoseconds;
+}
+
+qint64 ZTerminal::RenderStatistics::bytesWritten() const {
+    return tuiwidgets_pimpl_ptr.get()->bytesWritten;
+}
+
+int ZTerminal::RenderStatistics::cellsRepainted() const {
+    return tuiwidgets_pimpl_ptr.get()->cellsRepainted;
+}
+
+int ZTerminal::RenderStatistics::widgetsPainted() const {
+    return tuiwidgets_pimpl_ptr.get()->widgetsPainted;
+}
+
+QVector<int> ZTerminal::RenderStatistics::frameTimeHistogram() const {
+    return tuiwidgets_pimpl_ptr.get()->frameTimeHistogram;
+}
+
+qint64 ZTerminal::RenderStatistics::frameTimeHistogramBucketLimit(int bucket) {
+    if (bucket < 0 || bucket + 1 >= frameTimeHistogramBuckets) {
+        return -1;
+    }
+    return frameTimeHistogramFirstLimit << bucket;
+}
+
 void ZTerminal::TerminalConnectionDelegate::pause() {
 }
 
@@ -1365,7 +1750,9 @@ void ZTerminalPrivate::initExternal(ZTerminal::TerminalConnectionPrivate *connec
         // this does not really free, because ZTerminalPrivate which contains the integration struct is externally owned
     };
     auto write = [] (termpaint_integration *ptr, const char *data, int length) {
-        container_of(ptr, ZTerminalPrivate, integration)->externalConnection->delegate->write(data, length);
+        auto *const p = container_of(ptr, ZTerminalPrivate, integration);
+        p->bytesWritten += length;
+        p->externalConnection->delegate->write(data, length);
     };
     auto flush = [] (termpaint_integration *ptr) {
         container_of(ptr, ZTerminalPrivate, integration)->externalConnection->delegate->flush();
@@ -1387,5 +1774,7 @@ void ZTerminalPrivate::initExternal(ZTerminal::TerminalConnectionPrivate *connec
 }
 
 thread_local uint64_t ZTerminalPrivate::focusCounter = 0;
+thread_local uint64_t ZTerminalPrivate::activeLayoutPass = 0;
+thread_local uint64_t ZTerminalPrivate::layoutPassCounter = 0;
 
 TUIWIDGETS_NS_END
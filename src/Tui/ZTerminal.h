@@ -6,6 +6,7 @@
 #include <memory>
 
 #include <QObject>
+#include <QVector>
 
 #include <Tui/ZCommon.h>
 #include <Tui/ZValuePtr.h>
@@ -70,6 +71,35 @@ class TUIWIDGETS_EXPORT ZTerminal : public QObject {
         ZValuePtr<OffScreenData> tuiwidgets_pimpl_ptr;
     };
 
+    class RenderStatisticsData;
+    class RenderStatistics {
+    public:
+        RenderStatistics();
+        RenderStatistics(const RenderStatistics&);
+        ~RenderStatistics();
+
+    public:
+        RenderStatistics& operator=(const RenderStatistics&);
+
+    public:
+        int frameCount() const;
+
+        qint64 layoutNanoseconds() const;
+        qint64 paintNanoseconds() const;
+        qint64 flushNanoseconds() const;
+        qint64 frameNanoseconds() const;
+        qint64 bytesWritten() const;
+        int cellsRepainted() const;
+        int widgetsPainted() const;
+
+        QVector<int> frameTimeHistogram() const;
+        static qint64 frameTimeHistogramBucketLimit(int bucket);
+
+    private:
+        friend class RenderStatisticsData;
+        ZValuePtr<RenderStatisticsData> tuiwidgets_pimpl_ptr;
+    };
+
     class TerminalConnectionDelegate {
     public:
         TerminalConnectionDelegate();
@@ -141,6 +171,17 @@ class TUIWIDGETS_EXPORT ZTerminal : public QObject {
     void updateOutput();
     void updateOutputForceFullRepaint();
 
+    RenderStatistics renderStatistics() const;
+    void resetRenderStatistics();
+
+    int minimumFrameInterval() const;
+    void setMinimumFrameInterval(int msec);
+    bool adaptiveFrameInterval() const;
+    void setAdaptiveFrameInterval(bool enable);
+
+    int outputBufferLimit() const;
+    void setOutputBufferLimit(int bytes);
+
     QString title() const;
     void setTitle(const QString &title);
     QString iconTitle() const;
@@ -77,8 +77,32 @@ ZTerminalDiagnosticsDialog::ZTerminalDiagnosticsDialog(ZWidget *parent) : ZDialo
     p->terminalSelfId->setEnabled(false);
     layout->addWidget(p->terminalSelfId);
 
+    layout->addSpacing(1);
+
+    ZTextLine *l3 = new ZTextLine(QStringLiteral("Rendering (last frame)"), this);
+    layout->addWidget(l3);
+
+    p->renderTiming = new ZTextLine(this);
+    layout->addWidget(p->renderTiming);
+
+    p->renderOutput = new ZTextLine(this);
+    layout->addWidget(p->renderOutput);
+
+    p->renderHistogram = new ZTextLine(this);
+    layout->addWidget(p->renderHistogram);
+
+    // Updating on each frame would cause a new frame, so poll instead.
+    QObject::connect(&p->renderStatisticsTimer, &QTimer::timeout, this, [this] {
+        if (terminal()) {
+            auto *const p = tuiwidgets_impl();
+            p->updateRenderStatistics();
+        }
+    });
+    p->renderStatisticsTimer.start(1000);
+
     if (terminal()) {
         p->updateInfo();
+        p->updateRenderStatistics();
     }
 
     layout->addSpacing(1);
@@ -173,6 +197,29 @@ void ZTerminalDiagnosticsDialogPrivate::updateInfo() {
     }
 }
 
+void ZTerminalDiagnosticsDialogPrivate::updateRenderStatistics() {
+    const ZTerminal::RenderStatistics stats = pub()->terminal()->renderStatistics();
+
+    auto ms = [](qint64 nanoseconds) {
+        return QString::number(nanoseconds / 1000000.0, 'f', 2) + QStringLiteral("ms");
+    };
+
+    renderTiming->setText(QStringLiteral("Time ") + ms(stats.frameNanoseconds())
+                          + QStringLiteral(": layout ") + ms(stats.layoutNanoseconds())
+                          + QStringLiteral(", paint ") + ms(stats.paintNanoseconds())
+                          + QStringLiteral(", flush ") + ms(stats.flushNanoseconds()));
+    renderOutput->setText(QStringLiteral("Output ") + QString::number(stats.bytesWritten())
+                          + QStringLiteral(" bytes, ") + QString::number(stats.cellsRepainted())
+                          + QStringLiteral(" cells, ") + QString::number(stats.widgetsPainted())
+                          + QStringLiteral(" widgets"));
+
+    QString histogram = QStringLiteral("Histogram (0.25ms-128ms):");
+    for (int count: stats.frameTimeHistogram()) {
+        histogram += QStringLiteral(" ") + QString::number(count);
+    }
+    renderHistogram->setText(histogram);
+}
+
 void ZTerminalDiagnosticsDialogPrivate::keyboardTest() {
     ZWidget *const w = pub();
 
@@ -390,6 +437,7 @@ bool ZTerminalDiagnosticsDialog::event(QEvent *event) {
         if (terminal()) {
             auto *const p = tuiwidgets_impl();
             p->updateInfo();
+            p->updateRenderStatistics();
         }
     }
     return ZDialog::event(event);
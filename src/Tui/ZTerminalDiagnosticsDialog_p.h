@@ -3,6 +3,8 @@
 #ifndef TUIWIDGETS_ZTERMINALDIAGNOSTICSDIALOG_P_INCLUDED
 #define TUIWIDGETS_ZTERMINALDIAGNOSTICSDIALOG_P_INCLUDED
 
+#include <QTimer>
+
 #include <Tui/ZTerminalDiagnosticsDialog.h>
 #include <Tui/ZDialog_p.h>
 
@@ -20,12 +22,17 @@ class ZTerminalDiagnosticsDialogPrivate : public ZDialogPrivate {
 
 public:
     void updateInfo();
+    void updateRenderStatistics();
     void keyboardTest();
 
 public:
     ZInputBox *terminalInfo = nullptr;
     ZInputBox *terminalCaps = nullptr;
     ZInputBox *terminalSelfId = nullptr;
+    ZTextLine *renderTiming = nullptr;
+    ZTextLine *renderOutput = nullptr;
+    ZTextLine *renderHistogram = nullptr;
+    QTimer renderStatisticsTimer;
     ZTextLine *keyHeader = nullptr;
     ZInputBox *keyRaw = nullptr;
     ZTextLine *keyParsed = nullptr;
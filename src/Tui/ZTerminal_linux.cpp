@@ -360,6 +360,7 @@ bool ZTerminalPrivate::setupInternalConnection(ZTerminal::Options options, ZTerm
 
 void ZTerminalPrivate::deinitTerminalForInternalConnection() {
     inputNotifier = nullptr; // ensure no more notifications from this point
+    outputNotifier = nullptr;
     if (fd_read != -1 && fd_read == systemRestoreFd.load()) {
         const char *old = systemRestoreEscape.load();
         systemRestoreEscape.store(nullptr);
@@ -574,6 +575,7 @@ void ZTerminalPrivate::pauseTerminalForInternalConnection() {
 
     inputNotifier->setEnabled(false);
     termpaint_terminal_pause(terminal);
+    internalConnection_drainPendingOutput();
     tcsetattr(fd_read, TCSAFLUSH, &originalTerminalAttributes);
     if (fd_read == systemRestoreFd.load()) {
         systemTerminalPaused.store(true);
@@ -613,54 +615,116 @@ void ZTerminalPrivate::internalConnectionTerminalFdHasData(int socket) {
     inputFromConnection(buff, amount);
 }
 
+void ZTerminalPrivate::internalConnectionTerminalFdWritable() {
+    internalConnection_writePendingOutput();
+    if (pendingOutput.isEmpty() && frameDeferredByOutput) {
+        frameDeferredByOutput = false;
+        updateRequested = false;
+        processPaintingAndUpdateOutput(false);
+    }
+}
+
 void ZTerminalPrivate::internalConnection_integration_free() {
     // this does not really free, because ZTerminalPrivate which contains the integration struct is externally owned
+    // termpaint has written the restore sequence at this point, that must reach the terminal before closing.
+    internalConnection_drainPendingOutput();
     if (auto_close && fd_read != -1) {
         // assumnes that auto_close will only be true if fd_read == fd_write
         close(fd_read);
     }
 }
 
-void ZTerminalPrivate::internalConnection_integration_write_unbuffered(char *data, int length) {
+int ZTerminalPrivate::internalConnection_writeAvailable(const char *data, int length) {
+    // Returns the number of bytes written before the fd would block or -1 if the fd is unusable.
     int written = 0;
-    int ret;
-    errno = 0;
     while (written != length) {
-        ret = write(fd_write, data + written, length - written);
+        const int ret = static_cast<int>(write(fd_write, data + written, length - written));
         if (ret > 0) {
             written += ret;
-        } else {
-            // error handling?
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // fatal, non blocking is not supported by this integration
-                fd_read = fd_write = -1;
-                return;
-            }
-            if (errno == EIO || errno == ENOSPC) {
-                // fatal?
-                fd_read = fd_write = -1;
-                return;
-            }
-            if (errno == EBADF || errno == EINVAL || errno == EPIPE) {
-                // fatal, or fd is gone bad
-                fd_read = fd_write = -1;
-                return;
-            }
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // non blocking fd and the terminal does not keep up
+            return written;
+        }
+        // EIO, ENOSPC, EBADF, EINVAL, EPIPE, etc: fatal, or fd is gone bad
+        fd_read = fd_write = -1;
+        return -1;
+    }
+    return written;
+}
+
+void ZTerminalPrivate::internalConnection_integration_write_unbuffered(char *data, int length) {
+    if (!pendingOutput.isEmpty()) {
+        // keep the order with output that is still waiting for the terminal
+        pendingOutput.append(data, length);
+        return;
+    }
+
+    const int written = internalConnection_writeAvailable(data, length);
+    if (written >= 0 && written != length) {
+        pendingOutput.append(data + written, length - written);
+        if (!outputNotifier) {
+            outputNotifier.reset(new QSocketNotifier(fd_write, QSocketNotifier::Write));
+            QObject::connect(outputNotifier.get(), &QSocketNotifier::activated,
+                             pub(), [this] { internalConnectionTerminalFdWritable(); });
+        }
+        outputNotifier->setEnabled(true);
+    }
+}
+
+void ZTerminalPrivate::internalConnection_writePendingOutput() {
+    const int written = internalConnection_writeAvailable(pendingOutput.constData() + pendingOutputOffset,
+                                                          pendingOutput.size() - pendingOutputOffset);
+    if (written < 0 || pendingOutputOffset + written == pendingOutput.size()) {
+        pendingOutput.clear();
+        pendingOutputOffset = 0;
+    } else {
+        pendingOutputOffset += written;
+        // Only drop the written part once it is the larger part of the buffer, so that a slow terminal does not
+        // cause the remaining output to be moved for every partial write.
+        if (pendingOutputOffset > pendingOutput.size() / 2) {
+            pendingOutput.remove(0, pendingOutputOffset);
+            pendingOutputOffset = 0;
+        }
+    }
+    if (pendingOutput.isEmpty() && outputNotifier) {
+        outputNotifier->setEnabled(false);
+    }
+}
+
+void ZTerminalPrivate::internalConnection_drainPendingOutput() {
+    // Blocks until all pending output is written, used where the terminal must be in a known state afterwards.
+    while (!pendingOutput.isEmpty() && fd_write != -1) {
+        struct pollfd info;
+        info.fd = fd_write;
+        info.events = POLLOUT;
+        const int ret = poll(&info, 1, -1);
+        if (ret < 0) {
             if (errno == EINTR) {
                 continue;
             }
+            break;
         }
+        internalConnection_writePendingOutput();
     }
 }
 
 void ZTerminalPrivate::internalConnection_integration_write(const char *data, int length) {
+    bytesWritten += length;
     output_buffer.append(data, length);
-    if (output_buffer.size() > 512 || options.testFlag(ZTerminal::DebugDisableBufferedIo)) {
+    if (output_buffer.size() > outputBufferLimit || options.testFlag(ZTerminal::DebugDisableBufferedIo)) {
         internalConnection_integration_flush();
     }
 }
 
 void ZTerminalPrivate::internalConnection_integration_flush() {
+    if (output_buffer.isEmpty()) {
+        return;
+    }
     internalConnection_integration_write_unbuffered(output_buffer.data(), output_buffer.size());
     output_buffer.clear();
 }
@@ -3,29 +3,37 @@
 #ifndef TUIWIDGETS_ZTERMINAL_P_INCLUDED
 #define TUIWIDGETS_ZTERMINAL_P_INCLUDED
 
+#include <memory>
+
 #include <termios.h>
 
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QMap>
 #include <QPoint>
 #include <QPointer>
+#include <QRect>
 #include <QSocketNotifier>
 #include <QTimer>
+#include <QVector>
 
 #include <termpaint.h>
 
 #include <Tui/ListNode_p.h>
 #include <Tui/ZMoFunc_p.h>
 #include <Tui/ZTerminal.h>
+#include <Tui/ZTest.h>
 
 #include <Tui/tuiwidgets_internal.h>
 
 TUIWIDGETS_NS_START
 
+class ZPainterAttributeCache;
 class ZWidget;
 class ZWidgetPrivate;
 class ZShortcutManager;
 class ZSymbol;
+class ZTextMetricsPrivate;
 
 struct FocusHistoryTag;
 
@@ -53,7 +61,16 @@ class ZTerminalPrivate {
     void adjustViewportOffset();
     bool viewportKeyEvent(ZKeyEvent *translated);
 
+    void processPasteChunk(const QString &text, bool initial, bool final);
+    ZWidget *dispatchPasteChunkEvent(ZPasteEvent *event);
+
+    void scheduleUpdate();
+    int frameDelay() const;
+    void startFrameLimitTimer(int msec);
+    void addDamagedRect(QRect rect);
     void processPaintingAndUpdateOutput(bool fullRepaint);
+    void recordFrame(qint64 layoutNanoseconds, qint64 paintNanoseconds, qint64 flushNanoseconds,
+                     qint64 bytesWrittenInFrame, int cellsRepainted);
     void updateNativeTerminalState();
 
     bool setTestLayoutRequestTracker(std::function<void(ZWidget *)> closure);
@@ -83,6 +100,10 @@ class ZTerminalPrivate {
     bool internalConnection_integration_is_bad();
     void internalConnection_integration_restore_sequence_updated(const char *data, int len, bool force);
     void internalConnectionTerminalFdHasData(int socket);
+    void internalConnectionTerminalFdWritable();
+    int internalConnection_writeAvailable(const char *data, int length);
+    void internalConnection_writePendingOutput();
+    void internalConnection_drainPendingOutput();
     // ^^
 
     // external connection
@@ -100,6 +121,10 @@ class ZTerminalPrivate {
     // ^^
 
     termpaint_surface *surface = nullptr; // TODO use ref counted ptr of some kind
+    // Shared by all text metrics of this terminal, so its cached measurement object is reused.
+    mutable std::shared_ptr<ZTextMetricsPrivate> textMetrics;
+    // Shared by all painters of this terminal, so attributes are reused across paint calls and frames.
+    std::shared_ptr<ZPainterAttributeCache> painterAttributeCache;
     termpaint_terminal *terminal = nullptr;
     QPoint terminalCursorPosition;
     CursorStyle terminalCursorStyle = CursorStyle::Unset;
@@ -107,8 +132,26 @@ class ZTerminalPrivate {
     int terminalCursorR = -1, terminalCursorG = -1, terminalCursorB = -1;
     termpaint_integration integration;
     std::unique_ptr<QSocketNotifier> inputNotifier;
+    // Output that a non blocking terminal fd did not yet accept. Written when outputNotifier reports the fd writable.
+    // The bytes before pendingOutputOffset are already written. pendingOutput is cleared when everything is written.
+    QByteArray pendingOutput;
+    int pendingOutputOffset = 0;
+    std::unique_ptr<QSocketNotifier> outputNotifier;
+    // Set when an update was skipped because of pendingOutput, the frame is painted once pendingOutput is written.
+    bool frameDeferredByOutput = false;
 
     bool updateRequested = false;
+    // Frame rate limiting, updates are delayed until the frame interval since the end of the last frame has passed
+    // unless there was input since then.
+    int minimumFrameInterval = 0;
+    bool adaptiveFrameInterval = false;
+    bool inputSinceLastFrame = false;
+    QElapsedTimer lastFrameEnd;
+    std::unique_ptr<QTimer> frameLimitTimer;
+    // Areas (in terminal coordinates) that need to be repainted in the next paint pass. Only used when
+    // fullRepaintPending is false.
+    bool fullRepaintPending = true;
+    QVector<QRect> damagedRects;
 
     QPointer<ZWidget> mainWidget;
     QPoint cursorPosition = {-1, -1};
@@ -122,14 +165,35 @@ class ZTerminalPrivate {
     bool titleNeedsUpdate = false;
     QString iconTitle;
     bool iconTitleNeedsUpdate = false;
+    // Buffers the chunks of a bracketed paste for widgets that only handle complete paste events
     QString pasteTemp;
+    // Widget that accepted the initial chunk of the current paste as pasteChunk event
+    QPointer<ZWidget> pasteChunkReceiver;
+    bool pasteChunked = false;
+
+    ZTerminal::RenderStatistics renderStatistics;
+    // Frame times of the most recent frames (ring buffer) to remove them from the histogram again.
+    QVector<qint64> recentFrameTimes;
+    int recentFrameIndex = 0;
+    // Total output of the integration, frame statistics use the difference.
+    qint64 bytesWritten = 0;
+    // Incremented by the paint event dispatch through the painter of the frame.
+    int widgetsPainted = 0;
 
     QList<QPointer<ZWidget>> layoutPendingWidgets;
     bool layoutRequested = false;
     int layoutGeneration = -1;
     std::function<void(ZWidget *)> testingLayoutRequestTrackingClosure;
+    // counters of the last layout pass, reset when doLayout starts
+    ZTest::LayoutPassCounters *testingLayoutPassCounters = nullptr;
 
     static thread_local uint64_t focusCounter;
+    // Identifies the doLayout call running in this thread, otherwise 0. Size hints are only memoized for the duration
+    // of one layout pass, as widgets are not required to call updateGeometry() when their size hint changes. Unlike
+    // layoutGeneration the id is unique across terminals, so checking memoized hints does not need to find the
+    // terminal of the widget.
+    static thread_local uint64_t activeLayoutPass;
+    static thread_local uint64_t layoutPassCounter;
 
     bool viewportActive = false;
     bool viewportUI = false;
@@ -149,6 +213,8 @@ class ZTerminalPrivate {
     int fd_write = -1;
     bool auto_close = false; // if true fd_read == fd_write is assumed
     QByteArray output_buffer;
+    // Output is written when termpaint flushes (usually once per frame) or when the buffer exceeds this size.
+    int outputBufferLimit = 64 * 1024;
     termios originalTerminalAttributes;
     termios prepauseTerminalAttributes;
     // ^^
@@ -186,6 +252,23 @@ class ZTerminal::OffScreenData : public QSharedData {
     static const OffScreenData *get(const ZTerminal::OffScreen *data) { return data->tuiwidgets_pimpl_ptr.get(); }
 };
 
+class ZTerminal::RenderStatisticsData {
+public:
+    int frameCount = 0;
+    qint64 layoutNanoseconds = 0;
+    qint64 paintNanoseconds = 0;
+    qint64 flushNanoseconds = 0;
+    qint64 frameNanoseconds = 0;
+    qint64 bytesWritten = 0;
+    int cellsRepainted = 0;
+    int widgetsPainted = 0;
+    QVector<int> frameTimeHistogram;
+
+    // back door
+    static RenderStatisticsData *get(ZTerminal::RenderStatistics *data) { return data->tuiwidgets_pimpl_ptr.get(); }
+    static const RenderStatisticsData *get(const ZTerminal::RenderStatistics *data) { return data->tuiwidgets_pimpl_ptr.get(); }
+};
+
 TUIWIDGETS_NS_END
 
 #endif // TUIWIDGETS_ZTERMINAL_P_INCLUDED
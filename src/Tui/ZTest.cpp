@@ -45,6 +45,12 @@ namespace ZTest {
         terminal->dispatchPasteEvent(event);
     }
 
+    TUIWIDGETS_EXPORT void sendPasteChunks(ZTerminal *terminal, const QStringList &chunks) {
+        for (int i = 0; i < chunks.size(); i++) {
+            ZTerminalPrivate::get(terminal)->processPasteChunk(chunks[i], i == 0, i == chunks.size() - 1);
+        }
+    }
+
     TUIWIDGETS_EXPORT ZImage waitForNextRenderAndGetContents(ZTerminal *terminal) {
 
         std::unique_ptr<ZImage> result;
@@ -79,6 +85,27 @@ namespace ZTest {
         p->resetTestLayoutRequestTracker();
     }
 
+    TUIWIDGETS_EXPORT void withLayoutRequestTracking(ZTerminal *terminal,
+                                                     std::function<void(QSet<ZWidget*> *layoutRequested,
+                                                                        const LayoutPassCounters *counters)> closure) {
+        auto *const p = ZTerminalPrivate::get(terminal);
+        if (p->testingLayoutPassCounters) {
+            qWarning("nested layout request tracking not supported");
+            return;
+        }
+        LayoutPassCounters counters;
+        p->testingLayoutPassCounters = &counters;
+        try {
+            withLayoutRequestTracking(terminal, [&](QSet<ZWidget*> *layoutRequested) {
+                closure(layoutRequested, &counters);
+            });
+        } catch (...) {
+            p->testingLayoutPassCounters = nullptr;
+            throw;
+        }
+        p->testingLayoutPassCounters = nullptr;
+    }
+
 }
 
 TUIWIDGETS_NS_END
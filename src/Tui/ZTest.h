@@ -6,6 +6,7 @@
 #include <functional>
 
 #include <QString>
+#include <QStringList>
 
 #include <Tui/ZCommon.h>
 
@@ -23,11 +24,20 @@ namespace ZTest {
     TUIWIDGETS_EXPORT void sendKey(ZTerminal *terminal, Key key, KeyboardModifiers modifiers);
     TUIWIDGETS_EXPORT void sendKeyToWidget(ZWidget *w, Key key, KeyboardModifiers modifiers);
     TUIWIDGETS_EXPORT void sendPaste(ZTerminal *terminal, const QString &text);
+    TUIWIDGETS_EXPORT void sendPasteChunks(ZTerminal *terminal, const QStringList &chunks);
 
     TUIWIDGETS_EXPORT ZImage waitForNextRenderAndGetContents(ZTerminal *terminal);
 
+    struct LayoutPassCounters {
+        int widgetsVisited = 0;
+        int widgetsRelayouted = 0;
+    };
+
     TUIWIDGETS_EXPORT void withLayoutRequestTracking(ZTerminal *terminal,
                                                      std::function<void(QSet<ZWidget*> *layoutRequested)> closure);
+    TUIWIDGETS_EXPORT void withLayoutRequestTracking(ZTerminal *terminal,
+                                                     std::function<void(QSet<ZWidget*> *layoutRequested,
+                                                                        const LayoutPassCounters *counters)> closure);
 }
 
 TUIWIDGETS_NS_END
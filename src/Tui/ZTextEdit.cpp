@@ -6,11 +6,17 @@
 #include <QFutureWatcher>
 
 #include <Tui/ZClipboard.h>
+#include <Tui/ZDocument_p.h>
 #include <Tui/ZPainter.h>
 #include <Tui/ZSymbol.h>
 
 TUIWIDGETS_NS_START
 
+namespace {
+    // Enough for a few screens of wrapped lines in both the wrapping and non wrapping variants.
+    constexpr std::size_t maxLayoutCacheEntries = 512;
+}
+
 ZTextEditPrivate::ZTextEditPrivate(const ZTextMetrics &textMetrics, ZDocument *document, ZWidget *pub)
     : ZWidgetPrivate(pub), textMetrics(textMetrics),
       doc(document ? document : new ZDocument()),
@@ -178,6 +184,7 @@ void ZTextEdit::setSelection(Position anchor, Position position) {
 void ZTextEdit::setTextCursor(const ZDocumentCursor &cursor) {
     auto *const p = tuiwidgets_impl();
 
+    p->finishChunkedPaste();
     clearAdvancedSelection();
 
     p->cursor.setAnchorPosition(cursor.anchor());
@@ -203,18 +210,14 @@ ZDocumentCursor ZTextEdit::makeCursor() {
 
 ZDocumentCursor ZTextEditPrivate::makeCursor() {
     return ZDocumentCursor(doc, [this](int line, bool wrappingAllowed) {
-        ZTextLayout lay(textMetrics, doc->line(line));
         ZTextOption option;
         option.setTabStopDistance(tabsize);
         if (wrappingAllowed) {
             option.setWrapMode(wrapMode);
-            lay.setTextOption(option);
-            lay.doLayout(std::max(pub()->rect().width() - pub()->allBordersWidth(), 0));
+            return cachedTextLayout(option, line, std::max(pub()->rect().width() - pub()->allBordersWidth(), 0));
         } else {
-            lay.setTextOption(option);
-            lay.doLayout(std::numeric_limits<unsigned short>::max() - 1);
+            return cachedTextLayout(option, line, std::numeric_limits<unsigned short>::max() - 1);
         }
-        return lay;
     });
 }
 
@@ -405,6 +408,18 @@ bool ZTextEdit::isUndoRedoEnabled() const {
     return p->undoRedoEnabled;
 }
 
+void ZTextEdit::setChunkedPasteEnabled(bool enabled) {
+    auto *const p = tuiwidgets_impl();
+
+    p->chunkedPasteEnabled = enabled;
+}
+
+bool ZTextEdit::isChunkedPasteEnabled() const {
+    auto *const p = tuiwidgets_impl();
+
+    return p->chunkedPasteEnabled;
+}
+
 bool ZTextEdit::isModified() const {
     auto *const p = tuiwidgets_impl();
 
@@ -461,15 +476,7 @@ void ZTextEdit::copy() {
 void ZTextEdit::pasteEvent(ZPasteEvent *event) {
     auto *const p = tuiwidgets_impl();
 
-    QString text = event->text();
-
-    text.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
-    text.replace(QLatin1Char('\r'), QString(QLatin1Char('\n')));
-
-    // Inserting might adjust the scroll position, so save it here and restore it later.
-    const int line = p->scrollPositionLine.line();
-    p->cursor.insertText(text);
-    p->scrollPositionLine.setLine(line);
+    p->insertPastedText(event->text());
 
     p->doc->clearCollapseUndoStep();
     adjustScrollPosition();
@@ -1037,8 +1044,7 @@ void ZTextEdit::setScrollPosition(int column, int line, int fineLine) {
         }
 
         if (fineLine > 0) {
-            ZTextLayout lay = textLayoutForLine(textOption(), line);
-            if (fineLine >= lay.lineCount()) {
+            if (fineLine >= p->visualRowsOfLine(line)) {
                 return;
             }
         }
@@ -1280,16 +1286,133 @@ ZTextOption ZTextEdit::textOption() const {
 ZTextLayout ZTextEdit::textLayoutForLine(const ZTextOption &option, int line) const {
     auto *const p = tuiwidgets_impl();
 
-    ZTextLayout lay(p->textMetrics, p->doc->line(line));
-    lay.setTextOption(option);
     if (p->wrapMode != ZTextOption::WrapMode::NoWrap) {
-        lay.doLayout(std::max(rect().width() - allBordersWidth(), 0));
+        return p->cachedTextLayout(option, line, std::max(rect().width() - allBordersWidth(), 0));
     } else {
-        lay.doLayout(std::numeric_limits<unsigned short>::max() - 1);
+        return p->cachedTextLayout(option, line, std::numeric_limits<unsigned short>::max() - 1);
+    }
+}
+
+ZTextLayout ZTextEditPrivate::cachedTextLayout(const ZTextOption &option, int line, int width) const {
+    const LayoutCacheKey key{line, doc->lineRevision(line), width, option.tabStopDistance(),
+                             option.wrapMode(), static_cast<int>(option.flags())};
+    const QString text = doc->line(line);
+
+    auto it = layoutCacheIndex.find(key);
+    if (it != layoutCacheIndex.end()) {
+        auto entry = it.value();
+        // Line revisions are not unique (new lines start with revision 0 and undo restores old revisions) and
+        // lines move when lines are inserted or removed above them, so the key alone does not identify the text.
+        if (entry->layout.text() == text && entry->tabs == option.tabs()) {
+            layoutCacheLru.splice(layoutCacheLru.begin(), layoutCacheLru, entry);
+            ZTextLayout lay = entry->layout;
+            // The remaining parts of the option (color mappers) only affect drawing.
+            lay.setTextOption(option);
+            return lay;
+        }
+        layoutCacheLru.erase(entry);
+        layoutCacheIndex.erase(it);
+    }
+
+    // Edits mostly change a small part of a line, so if a layout of another revision of the line is cached only the
+    // wrapped lines around the change need to be laid out again.
+    for (const LayoutCacheEntry &entry: layoutCacheLru) {
+        if (entry.key.line == line && entry.key.width == width && entry.key.tabStopDistance == key.tabStopDistance
+                && entry.key.wrapMode == key.wrapMode && entry.key.flags == key.flags && entry.tabs == option.tabs()) {
+            const QString oldText = entry.layout.text();
+            const int maxCommon = std::min(oldText.size(), text.size());
+            int prefix = 0;
+            while (prefix < maxCommon && oldText[prefix] == text[prefix]) {
+                prefix++;
+            }
+            int suffix = 0;
+            while (suffix < maxCommon - prefix
+                   && oldText[oldText.size() - 1 - suffix] == text[text.size() - 1 - suffix]) {
+                suffix++;
+            }
+
+            ZTextLayout lay = entry.layout;
+            // Only differs in the parts that affect drawing, so this keeps the layout usable for relayout.
+            lay.setTextOption(option);
+            lay.setText(text);
+            lay.relayout(width, prefix, oldText.size() - prefix - suffix, text.size() - prefix - suffix);
+
+            insertIntoLayoutCache(key, option, lay);
+            return lay;
+        }
     }
+
+    ZTextLayout lay(textMetrics, text);
+    lay.setTextOption(option);
+    lay.doLayout(width);
+
+    insertIntoLayoutCache(key, option, lay);
     return lay;
 }
 
+void ZTextEditPrivate::insertIntoLayoutCache(const LayoutCacheKey &key, const ZTextOption &option,
+                                             const ZTextLayout &lay) const {
+    layoutCacheLru.push_front(LayoutCacheEntry{key, option.tabs(), lay});
+    layoutCacheIndex.insert(key, layoutCacheLru.begin());
+    if (layoutCacheLru.size() > maxLayoutCacheEntries) {
+        layoutCacheIndex.remove(layoutCacheLru.back().key);
+        layoutCacheLru.pop_back();
+    }
+}
+
+void ZTextEditPrivate::syncVisualRows() const {
+    const ZTextOption option = pub()->textOption();
+    const int width = wrapMode != ZTextOption::WrapMode::NoWrap
+            ? std::max(pub()->rect().width() - pub()->allBordersWidth(), 0)
+            : std::numeric_limits<unsigned short>::max() - 1;
+
+    if (width != visualRowWidth || option.wrapMode() != visualRowOption.wrapMode()
+            || option.tabStopDistance() != visualRowOption.tabStopDistance()
+            || option.flags() != visualRowOption.flags() || option.tabs() != visualRowOption.tabs()) {
+        visualRowWidth = width;
+        visualRowOption = option;
+        visualRowMap.clear();
+        visualRowLines.clear();
+    } else if (visualRowDocumentRevision == doc->revision() && visualRowLines.size() == doc->lineCount()) {
+        return;
+    }
+    visualRowDocumentRevision = doc->revision();
+
+    const LineStore &lines = ZDocumentPrivate::get(doc)->lines;
+    int prefix = 0;
+    int suffix = 0;
+    LineStore::commonPrefixAndSuffix(visualRowLines, lines, &prefix, &suffix);
+    const int oldCount = visualRowLines.size();
+    const int newCount = lines.size();
+    visualRowLines = lines;
+
+    // Changed lines are only laid out when their exact row count is needed.
+    auto estimatedRows = [&](int line) {
+        return width > 0 ? std::max(1, (lines.at(line).chars.size() + width - 1) / width) : 1;
+    };
+
+    if (oldCount == newCount) {
+        for (int line = prefix; line < newCount - suffix; line++) {
+            visualRowMap.setRows(line, estimatedRows(line), false);
+        }
+        return;
+    }
+
+    QVector<int> rows;
+    for (int line = prefix; line < newCount - suffix; line++) {
+        rows.append(estimatedRows(line));
+    }
+    visualRowMap.replace(prefix, oldCount - prefix - suffix, rows);
+}
+
+int ZTextEditPrivate::visualRowsOfLine(int line) const {
+    syncVisualRows();
+    if (!visualRowMap.isExact(line)) {
+        visualRowMap.setRows(line, pub()->textLayoutForLine(visualRowOption, line).lineCount(), true);
+    }
+    return visualRowMap.rows(line);
+}
+
 ZTextLayout ZTextEdit::textLayoutForLineWithoutWrapping(int line) const {
     ZTextOption option = textOption();
     option.setWrapMode(ZTextOption::NoWrap);
@@ -1388,20 +1511,20 @@ void ZTextEdit::adjustScrollPosition() {
             }
         } else {
             for (int line = cursorLine - 1; line >= 0; line--) {
-                ZTextLayout lay = textLayoutForLine(option, line);
-                if (linesAbove + lay.lineCount() >= availableLinesAbove) {
+                const int rows = p->visualRowsOfLine(line);
+                if (linesAbove + rows >= availableLinesAbove) {
                     if (newScrollPositionLine < line) {
                         newScrollPositionLine = line;
-                        newScrollPositionFineLine = (linesAbove + lay.lineCount()) - availableLinesAbove;
+                        newScrollPositionFineLine = (linesAbove + rows) - availableLinesAbove;
                     }
                     if (newScrollPositionLine == line) {
-                        if (newScrollPositionFineLine < (linesAbove + lay.lineCount()) - availableLinesAbove) {
-                            newScrollPositionFineLine = (linesAbove + lay.lineCount()) - availableLinesAbove;
+                        if (newScrollPositionFineLine < (linesAbove + rows) - availableLinesAbove) {
+                            newScrollPositionFineLine = (linesAbove + rows) - availableLinesAbove;
                         }
                     }
                     break;
                 }
-                linesAbove += lay.lineCount();
+                linesAbove += rows;
             }
         }
 
@@ -1418,20 +1541,25 @@ void ZTextEdit::adjustScrollPosition() {
 
         // scroll when window is larger than the document shown (unless scrolled to top)
         if (newScrollPositionLine && newScrollPositionLine + (geometry().height() - 1) > p->doc->lineCount()) {
-            int linesCounted = 0;
+            const int rowsShown = geometry().height() - 1;
+            const int lineCount = p->doc->lineCount();
 
-            for (int line = p->doc->lineCount() - 1; line >= 0; line--) {
-                ZTextLayout lay = textLayoutForLine(option, line);
-                linesCounted += lay.lineCount();
-                if (linesCounted >= geometry().height() - 1) {
-                    if (newScrollPositionLine > line) {
-                        newScrollPositionLine = line;
-                        newScrollPositionFineLine = linesCounted - (geometry().height() - 1);
-                    } else if (newScrollPositionLine == line &&
-                               newScrollPositionFineLine > linesCounted - (geometry().height() - 1)) {
-                        newScrollPositionFineLine = linesCounted - (geometry().height() - 1);
-                    }
-                    break;
+            // Every line has at least one row, so the first of the last rowsShown rows is in one of the last
+            // rowsShown lines. Only their row counts need to be exact, earlier lines cancel out.
+            for (int line = std::max(0, lineCount - std::max(rowsShown, 1)); line < lineCount; line++) {
+                p->visualRowsOfLine(line);
+            }
+
+            const int totalRows = p->visualRowMap.totalRows();
+            if (totalRows >= rowsShown) {
+                const int firstRow = totalRows - rowsShown;
+                const int line = p->visualRowMap.lineForRow(firstRow);
+                const int fineLine = firstRow - p->visualRowMap.rowsBefore(line);
+                if (newScrollPositionLine > line) {
+                    newScrollPositionLine = line;
+                    newScrollPositionFineLine = fineLine;
+                } else if (newScrollPositionLine == line && newScrollPositionFineLine > fineLine) {
+                    newScrollPositionFineLine = fineLine;
                 }
             }
         }
@@ -1526,8 +1654,7 @@ void ZTextEdit::detachedScrollUp() {
         int newScrollPositionFineLine = 0;
 
         if (wordWrapMode() != ZTextOption::WrapMode::NoWrap) {
-            ZTextLayout lay = textLayoutForLine(textOption(), newScrollPositionLine);
-            newScrollPositionFineLine = lay.lineCount() - 1;
+            newScrollPositionFineLine = p->visualRowsOfLine(newScrollPositionLine) - 1;
         }
         setScrollPosition(p->scrollPositionColumn, newScrollPositionLine, newScrollPositionFineLine);
     }
@@ -1537,8 +1664,7 @@ void ZTextEdit::detachedScrollDown() {
     auto *const p = tuiwidgets_impl();
 
     if (wordWrapMode() != ZTextOption::WrapMode::NoWrap) {
-        ZTextLayout lay = textLayoutForLine(textOption(), p->scrollPositionLine.line());
-        if (lay.lineCount() - 1 > p->scrollPositionFineLine) {
+        if (p->visualRowsOfLine(p->scrollPositionLine.line()) - 1 > p->scrollPositionFineLine) {
             setScrollPosition(p->scrollPositionColumn, p->scrollPositionLine.line(), p->scrollPositionFineLine + 1);
             return;
         }
@@ -1577,6 +1703,31 @@ QPair<int, int> ZTextEditPrivate::getSelectedLines() {
     return {std::max(0, startY), std::max(0, endY)};
 }
 
+void ZTextEditPrivate::insertPastedText(QString text) {
+    text.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+    text.replace(QLatin1Char('\r'), QString(QLatin1Char('\n')));
+
+    // Inserting might adjust the scroll position, so save it here and restore it later.
+    const int line = scrollPositionLine.line();
+    cursor.insertText(text);
+    scrollPositionLine.setLine(line);
+}
+
+void ZTextEditPrivate::finishChunkedPaste() {
+    if (!pasteUndoGroup) {
+        return;
+    }
+    if (pasteCarriageReturnPending) {
+        // No later chunk can complete a CRLF anymore.
+        pasteCarriageReturnPending = false;
+        insertPastedText(QString(QLatin1Char('\r')));
+        pub()->adjustScrollPosition();
+        pub()->update();
+    }
+    pasteUndoGroup.reset();
+    doc->clearCollapseUndoStep();
+}
+
 void ZTextEditPrivate::selectLines(int startLine, int endLine) {
     if (startLine > endLine) {
         cursor.setPosition({doc->lineCodeUnits(startLine), startLine});
@@ -1588,6 +1739,46 @@ void ZTextEditPrivate::selectLines(int startLine, int endLine) {
 }
 
 bool ZTextEdit::event(QEvent *event) {
+    auto *const p = tuiwidgets_impl();
+    if (event->type() == ZEventType::key() || event->type() == ZEventType::paste()) {
+        // Other input while a chunked paste is open means the rest of the paste got lost.
+        p->finishChunkedPaste();
+    }
+
+    // Chunks after the initial chunk are only sent if the initial chunk was accepted.
+    if (event->type() == ZEventType::pasteChunk()
+            && (p->chunkedPasteEnabled || !static_cast<ZPasteEvent*>(event)->isInitialChunk())) {
+        auto *const pasteEvent = static_cast<ZPasteEvent*>(event);
+
+        if (pasteEvent->isInitialChunk()) {
+            p->finishChunkedPaste();
+            p->pasteUndoGroup.emplace(p->doc->startUndoGroup(&p->cursor));
+            p->pasteCarriageReturnPending = false;
+        }
+
+        QString text = pasteEvent->text();
+        if (p->pasteCarriageReturnPending) {
+            text.prepend(QLatin1Char('\r'));
+            p->pasteCarriageReturnPending = false;
+        }
+        // A trailing CR might be the first half of a CRLF split between chunks.
+        if (!pasteEvent->isFinalChunk() && text.endsWith(QLatin1Char('\r'))) {
+            text.chop(1);
+            p->pasteCarriageReturnPending = true;
+        }
+
+        p->insertPastedText(text);
+
+        if (pasteEvent->isFinalChunk()) {
+            p->pasteUndoGroup.reset();
+            p->doc->clearCollapseUndoStep();
+        }
+        adjustScrollPosition();
+        update();
+
+        event->accept();
+        return true;
+    }
     return ZWidget::event(event);
 }
 
@@ -1640,6 +1831,9 @@ void ZTextEdit::focusInEvent(ZFocusEvent *event) {
 }
 
 void ZTextEdit::focusOutEvent(ZFocusEvent *event) {
+    auto *const p = tuiwidgets_impl();
+    // Don't keep a paste that did not complete open while the user works elsewhere.
+    p->finishChunkedPaste();
     return ZWidget::focusOutEvent(event);
 }
 
@@ -68,6 +68,8 @@ class TUIWIDGETS_EXPORT ZTextEdit : public ZWidget {
     bool isReadOnly() const;
     void setUndoRedoEnabled(bool enabled);
     bool isUndoRedoEnabled() const;
+    void setChunkedPasteEnabled(bool enabled);
+    bool isChunkedPasteEnabled() const;
 
     bool isModified() const;
 
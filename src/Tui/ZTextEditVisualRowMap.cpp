@@ -0,0 +1,370 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "ZTextEditVisualRowMap_p.h"
+
+#include <algorithm>
+
+#include <QVarLengthArray>
+#include <QtGlobal>
+
+TUIWIDGETS_NS_START
+
+namespace {
+    constexpr int maxLeafLines = 64;
+    constexpr int minLeafLines = maxLeafLines / 4;
+    constexpr int maxChildren = 32;
+    constexpr int minChildren = maxChildren / 4;
+}
+
+struct VisualRowMap::Node {
+    bool leaf = true;
+    int lineCount = 0; // number of lines in this subtree
+    int rowCount = 0; // number of rows of all lines in this subtree
+    QVector<Entry> entries; // only used in leaves
+    QVector<std::shared_ptr<Node>> children; // only used in inner nodes
+
+    int items() const {
+        return leaf ? entries.size() : children.size();
+    }
+
+    int maxItems() const {
+        return leaf ? maxLeafLines : maxChildren;
+    }
+
+    int minItems() const {
+        return leaf ? minLeafLines : minChildren;
+    }
+
+    void recalculateCounts() {
+        lineCount = 0;
+        rowCount = 0;
+        if (leaf) {
+            lineCount = entries.size();
+            for (const Entry &entry: entries) {
+                rowCount += entry.rows;
+            }
+        } else {
+            for (const auto &child: children) {
+                lineCount += child->lineCount;
+                rowCount += child->rowCount;
+            }
+        }
+    }
+
+    // Translates line into the index of the child containing it and the line relative to that child.
+    int findChild(int *line) const {
+        int i = 0;
+        while (i + 1 < children.size() && *line >= children[i]->lineCount) {
+            *line -= children[i]->lineCount;
+            i++;
+        }
+        return i;
+    }
+};
+
+VisualRowMap::VisualRowMap() = default;
+VisualRowMap::~VisualRowMap() = default;
+
+int VisualRowMap::lineCount() const {
+    return root ? root->lineCount : 0;
+}
+
+void VisualRowMap::clear() {
+    root.reset();
+}
+
+void VisualRowMap::replace(int start, int removed, const QVector<int> &rows) {
+    Q_ASSERT(start >= 0 && removed >= 0 && start + removed <= lineCount());
+
+    if (removed == lineCount()) {
+        root.reset();
+    } else if (removed > 0) {
+        removeRecursive(root.get(), start, removed);
+        while (!root->leaf && root->children.size() == 1) {
+            std::shared_ptr<Node> child = root->children[0];
+            root = child;
+        }
+    }
+
+    if (rows.isEmpty()) {
+        return;
+    }
+    QVector<Entry> entries;
+    entries.reserve(rows.size());
+    for (int lineRows: rows) {
+        entries.append(Entry{lineRows, false});
+    }
+    if (!root) {
+        root = std::make_shared<Node>();
+    }
+    QVector<std::shared_ptr<Node>> siblings = insertRecursive(root.get(), start, entries);
+    while (!siblings.isEmpty()) {
+        auto newRoot = std::make_shared<Node>();
+        newRoot->leaf = false;
+        newRoot->children.append(root);
+        newRoot->children.append(siblings);
+        newRoot->recalculateCounts();
+        root = newRoot;
+        siblings = newRoot->items() > newRoot->maxItems() ? splitEvenly(newRoot.get())
+                                                          : QVector<std::shared_ptr<Node>>();
+    }
+}
+
+const VisualRowMap::Entry &VisualRowMap::entry(int line) const {
+    Q_ASSERT(line >= 0 && line < lineCount());
+    const Node *node = root.get();
+    while (!node->leaf) {
+        node = node->children[node->findChild(&line)].get();
+    }
+    return node->entries[line];
+}
+
+int VisualRowMap::rows(int line) const {
+    return entry(line).rows;
+}
+
+bool VisualRowMap::isExact(int line) const {
+    return entry(line).exact;
+}
+
+void VisualRowMap::setRows(int line, int rows, bool exact) {
+    Q_ASSERT(line >= 0 && line < lineCount());
+    QVarLengthArray<Node*, 16> path;
+    Node *node = root.get();
+    while (!node->leaf) {
+        path.append(node);
+        node = node->children[node->findChild(&line)].get();
+    }
+    Entry &entry = node->entries[line];
+    const int diff = rows - entry.rows;
+    entry.rows = rows;
+    entry.exact = exact;
+    if (diff != 0) {
+        node->rowCount += diff;
+        for (Node *parent: path) {
+            parent->rowCount += diff;
+        }
+    }
+}
+
+int VisualRowMap::rowsBefore(int line) const {
+    Q_ASSERT(line >= 0 && line <= lineCount());
+    if (line == lineCount()) {
+        return totalRows();
+    }
+    int sum = 0;
+    const Node *node = root.get();
+    while (!node->leaf) {
+        int i = 0;
+        while (i + 1 < node->children.size() && line >= node->children[i]->lineCount) {
+            line -= node->children[i]->lineCount;
+            sum += node->children[i]->rowCount;
+            i++;
+        }
+        node = node->children[i].get();
+    }
+    for (int i = 0; i < line; i++) {
+        sum += node->entries[i].rows;
+    }
+    return sum;
+}
+
+int VisualRowMap::totalRows() const {
+    return root ? root->rowCount : 0;
+}
+
+int VisualRowMap::lineForRow(int row) const {
+    const int n = lineCount();
+    if (n == 0 || row >= root->rowCount) {
+        return std::max(n - 1, 0);
+    }
+
+    int line = 0;
+    const Node *node = root.get();
+    while (!node->leaf) {
+        int i = 0;
+        while (i + 1 < node->children.size() && row >= node->children[i]->rowCount) {
+            row -= node->children[i]->rowCount;
+            line += node->children[i]->lineCount;
+            i++;
+        }
+        node = node->children[i].get();
+    }
+    for (const Entry &entry: node->entries) {
+        if (row < entry.rows) {
+            break;
+        }
+        row -= entry.rows;
+        line++;
+    }
+    return std::min(line, n - 1);
+}
+
+QVector<std::shared_ptr<VisualRowMap::Node>> VisualRowMap::insertRecursive(Node *node, int index,
+                                                                           const QVector<Entry> &entries) {
+    if (node->leaf) {
+        QVector<Entry> merged;
+        merged.reserve(node->entries.size() + entries.size());
+        merged.append(node->entries.mid(0, index));
+        merged.append(entries);
+        merged.append(node->entries.mid(index));
+        node->entries = std::move(merged);
+    } else {
+        const int childIndex = node->findChild(&index);
+        const QVector<std::shared_ptr<Node>> siblings = insertRecursive(node->children[childIndex].get(), index,
+                                                                        entries);
+        if (!siblings.isEmpty()) {
+            node->children = node->children.mid(0, childIndex + 1) + siblings + node->children.mid(childIndex + 1);
+        }
+    }
+    node->recalculateCounts();
+
+    if (node->items() > node->maxItems()) {
+        return splitEvenly(node);
+    }
+    return {};
+}
+
+void VisualRowMap::removeRecursive(Node *node, int index, int count) {
+    if (node->leaf) {
+        node->entries.remove(index, count);
+        node->recalculateCounts();
+        return;
+    }
+
+    int childIndex = node->findChild(&index);
+    const int firstTouched = childIndex;
+    while (count > 0) {
+        const int childCount = node->children[childIndex]->lineCount;
+        const int toRemove = std::min(count, childCount - index);
+        if (index == 0 && toRemove == childCount) {
+            // whole subtree
+            node->children.remove(childIndex);
+        } else {
+            removeRecursive(node->children[childIndex].get(), index, toRemove);
+            childIndex++;
+        }
+        count -= toRemove;
+        index = 0;
+    }
+
+    // Only the partially touched children at the start and end of the removed range can be too small now, after
+    // removing the fully covered children in between they are adjacent.
+    for (int i = std::min(childIndex, node->children.size() - 1); i >= firstTouched && i >= 0; i--) {
+        if (i < node->children.size()) {
+            fixUnderflow(node, i);
+        }
+    }
+    node->recalculateCounts();
+}
+
+void VisualRowMap::fixUnderflow(Node *node, int childIndex) {
+    if (node->children.size() < 2) {
+        return;
+    }
+    if (node->children[childIndex]->items() >= node->children[childIndex]->minItems()) {
+        return;
+    }
+
+    const int leftIndex = childIndex > 0 ? childIndex - 1 : childIndex;
+    Node *left = node->children[leftIndex].get();
+    Node *right = node->children[leftIndex + 1].get();
+
+    if (left->items() + right->items() <= left->maxItems()) {
+        if (left->leaf) {
+            left->entries.append(right->entries);
+        } else {
+            left->children.append(right->children);
+        }
+        left->recalculateCounts();
+        node->children.remove(leftIndex + 1);
+    } else {
+        redistribute(left, right);
+    }
+}
+
+void VisualRowMap::redistribute(Node *left, Node *right) {
+    const int total = left->items() + right->items();
+    const int leftItems = total / 2;
+    if (left->leaf) {
+        QVector<Entry> all = left->entries + right->entries;
+        left->entries = all.mid(0, leftItems);
+        right->entries = all.mid(leftItems);
+    } else {
+        QVector<std::shared_ptr<Node>> all = left->children + right->children;
+        left->children = all.mid(0, leftItems);
+        right->children = all.mid(leftItems);
+    }
+    left->recalculateCounts();
+    right->recalculateCounts();
+}
+
+QVector<std::shared_ptr<VisualRowMap::Node>> VisualRowMap::splitEvenly(Node *node) {
+    // Splits an overfull node into as few nodes as possible. As all parts get about the same number of items, each
+    // part is at least half full.
+    const int items = node->items();
+    const int parts = (items + node->maxItems() - 1) / node->maxItems();
+    QVector<std::shared_ptr<Node>> siblings;
+    int start = items;
+    for (int part = parts - 1; part > 0; part--) {
+        const int partStart = static_cast<int>(static_cast<qint64>(items) * part / parts);
+        auto sibling = std::make_shared<Node>();
+        sibling->leaf = node->leaf;
+        if (node->leaf) {
+            sibling->entries = node->entries.mid(partStart, start - partStart);
+        } else {
+            sibling->children = node->children.mid(partStart, start - partStart);
+        }
+        sibling->recalculateCounts();
+        siblings.prepend(sibling);
+        start = partStart;
+    }
+    if (node->leaf) {
+        node->entries.resize(start);
+    } else {
+        node->children.resize(start);
+    }
+    node->recalculateCounts();
+    return siblings;
+}
+
+void VisualRowMap::debugConsistencyCheck() const {
+    if (!root) {
+        return;
+    }
+    int leafDepth = -1;
+    debugCheckNode(root.get(), 0, &leafDepth);
+}
+
+void VisualRowMap::debugCheckNode(const Node *node, int depth, int *leafDepth) {
+    int lines = 0;
+    int rows = 0;
+    if (node->leaf) {
+        if (*leafDepth == -1) {
+            *leafDepth = depth;
+        } else if (*leafDepth != depth) {
+            qFatal("VisualRowMap::debugConsistencyCheck: Leaves at different depths");
+        }
+        if (node->entries.size() > maxLeafLines) {
+            qFatal("VisualRowMap::debugConsistencyCheck: Leaf too large");
+        }
+        lines = node->entries.size();
+        for (const Entry &entry: node->entries) {
+            rows += entry.rows;
+        }
+    } else {
+        if (node->children.isEmpty() || node->children.size() > maxChildren) {
+            qFatal("VisualRowMap::debugConsistencyCheck: Invalid number of children");
+        }
+        for (const auto &child: node->children) {
+            debugCheckNode(child.get(), depth + 1, leafDepth);
+            lines += child->lineCount;
+            rows += child->rowCount;
+        }
+    }
+    if (lines != node->lineCount || rows != node->rowCount) {
+        qFatal("VisualRowMap::debugConsistencyCheck: Counts of node do not match");
+    }
+}
+
+TUIWIDGETS_NS_END
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef TUIWIDGETS_ZTEXTEDITVISUALROWMAP_P_INCLUDED
+#define TUIWIDGETS_ZTEXTEDITVISUALROWMAP_P_INCLUDED
+
+#include <memory>
+
+#include <QVector>
+
+#include <Tui/tuiwidgets_internal.h>
+
+TUIWIDGETS_NS_START
+
+// Number of visual rows (wrapped lines) of each document line and whether that number is exact or only estimated.
+//
+// Lines are kept in the leaves of a b-tree like structure where each node knows the number of lines and rows below
+// it. Thus mapping between visual rows and document lines, updating the row count of a line and replacing a range of
+// k lines are O(log n) (respectively O(log n + k)) operations.
+class VisualRowMap {
+public:
+    VisualRowMap();
+    VisualRowMap(const VisualRowMap&) = delete;
+    VisualRowMap &operator=(const VisualRowMap&) = delete;
+    ~VisualRowMap();
+
+public:
+    int lineCount() const;
+    void clear();
+
+    // Replaces the lines [start, start + removed) by lines with the row counts in rows. The new row counts are not
+    // exact.
+    void replace(int start, int removed, const QVector<int> &rows);
+
+    int rows(int line) const;
+    bool isExact(int line) const;
+    void setRows(int line, int rows, bool exact = false);
+
+    // Number of rows of all lines before line. line may be lineCount() to get the total number of rows.
+    int rowsBefore(int line) const;
+    int totalRows() const;
+
+    // Returns the line containing row (the largest line with rowsBefore(line) <= row). Rows past the end map to
+    // the last line.
+    int lineForRow(int row) const;
+
+    void debugConsistencyCheck() const;
+
+private:
+    struct Entry {
+        int rows = 0;
+        bool exact = false;
+    };
+    struct Node;
+
+    const Entry &entry(int line) const;
+    QVector<std::shared_ptr<Node>> insertRecursive(Node *node, int index, const QVector<Entry> &entries);
+    void removeRecursive(Node *node, int index, int count);
+    void fixUnderflow(Node *node, int childIndex);
+    static void redistribute(Node *left, Node *right);
+    static QVector<std::shared_ptr<Node>> splitEvenly(Node *node);
+    static void debugCheckNode(const Node *node, int depth, int *leafDepth);
+
+private:
+    // Nodes are never shared, copies are disabled.
+    std::shared_ptr<Node> root;
+};
+
+TUIWIDGETS_NS_END
+
+#endif // TUIWIDGETS_ZTEXTEDITVISUALROWMAP_P_INCLUDED
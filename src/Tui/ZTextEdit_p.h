@@ -3,7 +3,14 @@
 #ifndef TUIWIDGETS_ZTEXTEDIT_P_INCLUDED
 #define TUIWIDGETS_ZTEXTEDIT_P_INCLUDED
 
+#include <list>
+#include <optional>
+
+#include <QHash>
+
+#include <Tui/ZDocumentLineStore_p.h>
 #include <Tui/ZTextEdit.h>
+#include <Tui/ZTextEditVisualRowMap_p.h>
 #include <Tui/ZWidget_p.h>
 
 #include <Tui/tuiwidgets_internal.h>
@@ -24,9 +31,47 @@ class ZTextEditPrivate : public ZWidgetPrivate {
     QPair<int, int> getSelectedLinesSort();
     QPair<int, int> getSelectedLines();
     void selectLines(int startLine, int endLine);
+    void insertPastedText(QString text);
+    // Ends a paste received in chunks that did not get its final chunk, so later edits are not merged into its undo
+    // step.
+    void finishChunkedPaste();
 
     void updatePasteCommandEnabled();
 
+    ZTextLayout cachedTextLayout(const Tui::ZTextOption &option, int line, int width) const;
+
+    void syncVisualRows() const;
+    int visualRowsOfLine(int line) const;
+
+public:
+    struct LayoutCacheKey {
+        int line;
+        unsigned revision;
+        int width;
+        int tabStopDistance;
+        int wrapMode;
+        int flags;
+
+        bool operator==(const LayoutCacheKey &other) const {
+            return line == other.line && revision == other.revision && width == other.width
+                    && tabStopDistance == other.tabStopDistance && wrapMode == other.wrapMode
+                    && flags == other.flags;
+        }
+
+        friend uint qHash(const LayoutCacheKey &key, uint seed = 0) {
+            return qHash(key.line, seed) ^ qHash(key.revision, seed) ^ qHash(key.width * 31 + key.wrapMode, seed);
+        }
+    };
+
+    struct LayoutCacheEntry {
+        LayoutCacheKey key;
+        QList<Tui::ZTextOption::Tab> tabs;
+        Tui::ZTextLayout layout;
+    };
+
+    void insertIntoLayoutCache(const LayoutCacheKey &key, const Tui::ZTextOption &option,
+                               const Tui::ZTextLayout &lay) const;
+
 public:
     Tui::ZTextMetrics textMetrics;
     Tui::ZDocument *doc = nullptr;
@@ -56,6 +101,24 @@ class ZTextEditPrivate : public ZWidgetPrivate {
     Tui::ZCommandNotifier *cmdUndo = nullptr;
     Tui::ZCommandNotifier *cmdRedo = nullptr;
 
+    // most recently used entry first
+    mutable std::list<LayoutCacheEntry> layoutCacheLru;
+    mutable QHash<LayoutCacheKey, std::list<LayoutCacheEntry>::iterator> layoutCacheIndex;
+
+    // visual rows per line for textOption() and the current width, synchronized lazily with the document. Row counts
+    // of changed lines are only estimated from the length of the line until they are needed.
+    mutable Tui::VisualRowMap visualRowMap;
+    // snapshot of the document lines the row counts are for, shares all unchanged nodes with the document
+    mutable Tui::LineStore visualRowLines;
+    mutable unsigned visualRowDocumentRevision = 0;
+    mutable Tui::ZTextOption visualRowOption;
+    mutable int visualRowWidth = -1;
+
+    bool chunkedPasteEnabled = false;
+    // state of a paste received in chunks, the undo group keeps the whole paste in one undo step
+    std::optional<Tui::ZDocument::UndoGroup> pasteUndoGroup;
+    bool pasteCarriageReturnPending = false;
+
     TUIWIDGETS_DECLARE_PUBLIC(ZTextEdit)
 };
 
@@ -3,16 +3,24 @@
 #include "ZTextLayout.h"
 #include "ZTextLayout_p.h"
 
+#include <algorithm>
+
 #include <QList>
 #include <QTextBoundaryFinder>
 
 #include <Tui/ZFormatRange.h>
 #include <Tui/ZPainter.h>
+#include <Tui/ZTextMetrics_p.h>
 #include <Tui/ZTextStyle.h>
 
 
 TUIWIDGETS_NS_START
 
+namespace {
+    // Code units after the end of a line that can still influence how the line is wrapped.
+    constexpr int relayoutContext = 16;
+}
+
 ZTextLayout::ZTextLayout(ZTextMetrics metrics) : tuiwidgets_pimpl_ptr(ZTextLayoutPrivate(metrics))
 {
 }
@@ -35,6 +43,7 @@ QString ZTextLayout::text() const {
 void ZTextLayout::setText(const QString &text) {
     auto *const p = tuiwidgets_impl();
     p->text = text;
+    p->lineBreaksValid = false;
 }
 
 const ZTextOption &ZTextLayout::textOption() const {
@@ -44,7 +53,15 @@ const ZTextOption &ZTextLayout::textOption() const {
 
 void ZTextLayout::setTextOption(const ZTextOption &option) {
     auto *const p = tuiwidgets_impl();
+    // The color mappers only affect drawing, so changing only them keeps the layout usable for relayout().
+    const bool layoutChanged = p->textOption.flags() != option.flags()
+            || p->textOption.wrapMode() != option.wrapMode()
+            || p->textOption.tabStopDistance() != option.tabStopDistance()
+            || p->textOption.tabs() != option.tabs();
     p->textOption = option;
+    if (layoutChanged) {
+        p->layoutWidth = -1;
+    }
 }
 
 void ZTextLayout::beginLayout() {
@@ -52,6 +69,7 @@ void ZTextLayout::beginLayout() {
     p->lines.clear();
     p->nextIndex = 0;
     p->columns.resize(p->text.size());
+    p->layoutWidth = -1;
 }
 
 void ZTextLayout::doLayout(int width) {
@@ -70,6 +88,94 @@ void ZTextLayout::doLayout(int width) {
         ++y;
     }
     endLayout();
+
+    auto *const p = tuiwidgets_impl();
+    p->layoutWidth = width;
+    p->layoutTextSize = p->text.size();
+    p->lineBreaksForLayoutText = p->lineBreaksValid;
+}
+
+void ZTextLayout::relayout(int width, int position, int charsRemoved, int charsAdded) {
+    auto *const p = tuiwidgets_impl();
+    const int delta = charsAdded - charsRemoved;
+    if (p->layoutWidth != width || p->lines.isEmpty() || position < 0 || charsRemoved < 0 || charsAdded < 0
+            || position + charsRemoved > p->layoutTextSize || p->layoutTextSize + delta != p->text.size()) {
+        doLayout(width);
+        return;
+    }
+    if (p->testingCounters) {
+        p->testingCounters->incrementalRelayouts++;
+    }
+
+    if (!p->lineBreaksValid && p->lineBreaksForLayoutText && p->lineBreaks.size() == p->layoutTextSize + 1) {
+        p->updateLineBreakOpportunities(position, charsRemoved, charsAdded);
+    }
+
+    // Wrapping a line looks at the text up to the end of the following line (word wrap) and a bit further to find
+    // the end of clusters and line break opportunities. Lines are reused if all of that is before the change.
+    const QVector<ZTextLayoutPrivate::LineData> oldLines = p->lines;
+    int firstChanged = 0;
+    while (firstChanged + 1 < oldLines.size()
+           && oldLines[firstChanged + 1].endIndex + relayoutContext <= position) {
+        firstChanged++;
+    }
+
+    p->columns.remove(position, charsRemoved);
+    p->columns.insert(position, charsAdded, 0);
+    // Word wrap clears the columns of code units moved to the next line after they were set, which would damage
+    // the columns of the first reused line.
+    const QVector<unsigned short> shiftedColumns = p->columns;
+
+    p->lines.resize(firstChanged);
+    p->nextIndex = firstChanged ? p->lines.last().endIndex : 0;
+
+    // The layout of a line only depends on the text from its start onwards. So as soon as a new line starts after
+    // the change at the same place as an old line, all following old lines can be reused.
+    int oldIndex = firstChanged;
+    int y = firstChanged;
+    while (true) {
+        if (p->nextIndex >= position + charsAdded && p->nextIndex < p->text.size()) {
+            const int oldOffset = p->nextIndex - delta;
+            while (oldIndex < oldLines.size() && oldLines[oldIndex].offset < oldOffset) {
+                oldIndex++;
+            }
+            if (oldIndex < oldLines.size() && oldLines[oldIndex].offset == oldOffset) {
+                for (int i = p->nextIndex; i < oldLines[oldIndex].endIndex + delta; i++) {
+                    p->columns[i] = shiftedColumns[i];
+                }
+                for (int i = oldIndex; i < oldLines.size(); i++) {
+                    ZTextLayoutPrivate::LineData ld = oldLines[i];
+                    ld.offset += delta;
+                    ld.endIndex += delta;
+                    for (ZTextLayoutPrivate::TextRun &run: ld.textRuns) {
+                        run.offset += delta;
+                        run.endIndex += delta;
+                    }
+                    ld.pos = {0, y};
+                    p->lines.append(ld);
+                    ++y;
+                }
+                p->nextIndex = p->lines.last().endIndex;
+                break;
+            }
+        }
+
+        ZTextLineRef line = createLine();
+
+        if (!line.isValid()) {
+            break;
+        }
+
+        line.setLineWidth(width);
+        line.setPosition({0, y});
+
+        ++y;
+    }
+    endLayout();
+
+    p->layoutWidth = width;
+    p->layoutTextSize = p->text.size();
+    p->lineBreaksForLayoutText = p->lineBreaksValid;
 }
 
 void ZTextLayout::endLayout() {
@@ -307,15 +413,20 @@ void ZTextLayout::layoutLine(int index, int width) {
                 // of ascii spaces should count as a break opportunity as well.
                 return;
             }
-            QTextBoundaryFinder bndFinder(QTextBoundaryFinder::Line, p->text.data() + run.offset, std::max(offset + 2 /* allow for surrogate */, p->text.size()) - run.offset);
-            bndFinder.setPosition(offset - run.offset);
-            int boundary = bndFinder.isAtBoundary() ? bndFinder.position() : bndFinder.toPreviousBoundary();
-            if (boundary != -1 && run.offset + boundary != ld.offset) {
-                for (int i = run.offset + boundary; i < offset; i++) {
+            if (offset == run.offset) {
+                return;
+            }
+            const QVector<bool> &lineBreaks = p->lineBreakOpportunities();
+            int boundary = offset;
+            while (boundary > run.offset && !lineBreaks[boundary]) {
+                --boundary;
+            }
+            if (boundary != ld.offset) {
+                for (int i = boundary; i < offset; i++) {
                     // remove _columns values for wrapped code units
                     p->columns[i] = 0;
                 }
-                offset = run.offset + boundary;
+                offset = boundary;
             }
         }
     };
@@ -345,6 +456,33 @@ void ZTextLayout::layoutLine(int index, int width) {
                 break;
             }
         }
+
+        if (ch >= 0x20 && ch <= 0x7e) {
+            // Fast path for runs of printable ascii, where each code unit is a cluster of width 1 on its own.
+            const char16_t *data = reinterpret_cast<const char16_t*>(p->text.constData()) + offset;
+            int count;
+            if (textOptionWrapMode != ZTextOption::NoWrap) {
+                // but always consume at least one cluster
+                const int room = column ? width - column : std::max(width, 1);
+                // one more code unit is needed to check for a following combining mark
+                count = std::min(room, singleColumnPrefix(data, std::min(room + 1, p->text.size() - offset)));
+            } else {
+                count = singleColumnPrefix(data, p->text.size() - offset);
+            }
+            if (textOptionFlags & (ZTextOption::ShowTabsAndSpaces | ZTextOption::ShowTabsAndSpacesWithColors)) {
+                // visible spaces are separate runs
+                count = std::find(data, data + count, u' ') - data;
+            }
+            if (count > 0) {
+                for (int i = 0; i < count; i++) {
+                    p->columns[offset + i] = column + i + 1;
+                }
+                column += count;
+                offset += count;
+                continue;
+            }
+        }
+
         int chLen = 1;
         if (QChar::isHighSurrogate(ch)) {
             if (offset + 1 < p->text.size() && QChar::isLowSurrogate(p->text[offset + 1].unicode())) {
@@ -688,7 +826,7 @@ void ZTextLineRef::draw(ZPainter painter, const QPoint &pos, ZTextStyle color, Z
             const ZTextLayoutPrivate::TextRun &run = ld.textRuns[i];
             if (run.type == ZTextLayoutPrivate::TextRun::COPY) {
                 painterClipped.writeWithAttributes(pos.x() + ld.pos.x() + run.x, pos.y() + ld.pos.y(),
-                                                   p->text.mid(run.offset, run.endIndex - run.offset),
+                                                   p->text.constData() + run.offset, run.endIndex - run.offset,
                                                    color.foregroundColor(), color.backgroundColor(), color.attributes());
                 for (; nextFormatRange != partitionedRanges.end() && nextFormatRange->run == i; nextFormatRange++) {
                     const ZFormatRange &formatRange = *nextFormatRange->ptr;
@@ -703,7 +841,8 @@ void ZTextLineRef::draw(ZPainter painter, const QPoint &pos, ZTextStyle color, Z
                             ++formatRangeEnd;
                         }
                         painterClipped.writeWithAttributes(pos.x() + ld.pos.x() + run.x, pos.y() + ld.pos.y(),
-                                                    p->text.mid(run.offset, std::min(run.endIndex, formatRangeEnd) - run.offset),
+                                                    p->text.constData() + run.offset,
+                                                    std::min(run.endIndex, formatRangeEnd) - run.offset,
                                                     formatRange.format().foregroundColor(), formatRange.format().backgroundColor(),
                                                     formatRange.format().attributes());
                     } else if (formatRangeStart > run.offset && formatRangeStart < run.endIndex) {
@@ -722,7 +861,8 @@ void ZTextLineRef::draw(ZPainter painter, const QPoint &pos, ZTextStyle color, Z
                             startX = p->columns[start - 1];
                         }
                         painterClipped.writeWithAttributes(pos.x() + ld.pos.x() + startX, pos.y() + ld.pos.y(),
-                                                           p->text.mid(start, std::min(run.endIndex, formatRangeEnd) - start),
+                                                           p->text.constData() + start,
+                                                           std::min(run.endIndex, formatRangeEnd) - start,
                                                            formatRange.format().foregroundColor(),
                                                            formatRange.format().backgroundColor(),
                                                            formatRange.format().attributes());
@@ -962,6 +1102,7 @@ void ZTextLineRef::setPosition(const QPoint &pos) {
         auto *const p = _layout->tuiwidgets_impl();
         ZTextLayoutPrivate::LineData &ld = p->lines[_index];
         ld.pos = pos;
+        p->layoutWidth = -1;
     }
 }
 
@@ -1032,7 +1173,74 @@ int ZTextLineRef::textLength() const {
 void ZTextLineRef::setLineWidth(int width) {
     if (_layout) {
         _layout->layoutLine(_index, width);
+        _layout->tuiwidgets_impl()->layoutWidth = -1;
+    }
+}
+
+const QVector<bool> &ZTextLayoutPrivate::lineBreakOpportunities() {
+    if (!lineBreaksValid) {
+        lineBreaks.fill(false, text.size() + 1);
+        QTextBoundaryFinder finder(QTextBoundaryFinder::Line, text);
+        for (int pos = finder.toNextBoundary(); pos != -1; pos = finder.toNextBoundary()) {
+            lineBreaks[pos] = true;
+        }
+        lineBreaksValid = true;
+        lineBreaksForLayoutText = false;
+        if (testingCounters) {
+            testingCounters->lineBreakAnalyses++;
+        }
+    }
+    return lineBreaks;
+}
+
+void ZTextLayoutPrivate::updateLineBreakOpportunities(int position, int charsRemoved, int charsAdded) {
+    const int delta = charsAdded - charsRemoved;
+    const int changeEnd = position + charsAdded;
+
+    // Line breaking rules look ahead a few code units, so break opportunities shortly before the change might change
+    // too. The analysis starts at an earlier break opportunity that is not followed by a space, no rule looks back
+    // across such a break opportunity.
+    int start = std::max(0, position - relayoutContext);
+    while (start > 0 && (!lineBreaks[start] || text.at(start) == u' ')) {
+        --start;
+    }
+
+    // The analysis is done until a break opportunity after the change is found that also was a break opportunity
+    // before the change. From there on the old break opportunities are still valid. Break opportunities close to the
+    // end of the analysed part could be influenced by the end of the analysed text, so these are not used.
+    int analysisEnd = std::min(text.size(), changeEnd + 4 * relayoutContext);
+    QVector<bool> analysed;
+    int reuseFrom = -1;
+    while (reuseFrom == -1) {
+        analysed.fill(false, analysisEnd - start + 1);
+        QTextBoundaryFinder finder(QTextBoundaryFinder::Line, text.constData() + start, analysisEnd - start);
+        for (int pos = finder.toNextBoundary(); pos != -1; pos = finder.toNextBoundary()) {
+            analysed[pos] = true;
+        }
+
+        if (analysisEnd == text.size()) {
+            reuseFrom = text.size() + 1;
+        } else {
+            for (int pos = std::max(changeEnd, start + 1); pos <= analysisEnd - relayoutContext; pos++) {
+                if (analysed[pos - start] && lineBreaks[pos - delta] && text.at(pos) != u' ') {
+                    reuseFrom = pos;
+                    break;
+                }
+            }
+            analysisEnd = std::min(text.size(), analysisEnd + (analysisEnd - start));
+        }
+    }
+
+    // Entries up to start are unchanged, entries from reuseFrom on are the old entries moved by delta.
+    if (delta > 0) {
+        lineBreaks.insert(start + 1, delta, false);
+    } else if (delta < 0) {
+        lineBreaks.remove(start + 1, -delta);
+    }
+    for (int pos = start + 1; pos < reuseFrom; pos++) {
+        lineBreaks[pos] = analysed[pos - start];
     }
+    lineBreaksValid = true;
 }
 
 ZTextLayoutPrivate::~ZTextLayoutPrivate() {
@@ -51,6 +51,7 @@ class TUIWIDGETS_EXPORT ZTextLayout {
 
     void beginLayout();
     void doLayout(int width);
+    void relayout(int width, int position, int charsRemoved, int charsAdded);
     void endLayout();
     ZTextLineRef createLine();
 
@@ -3,6 +3,8 @@
 #ifndef TUIWIDGETS_ZTEXTLAYOUT_P_INCLUDED
 #define TUIWIDGETS_ZTEXTLAYOUT_P_INCLUDED
 
+#include <QVector>
+
 #include <Tui/ZTextLayout.h>
 
 #include <Tui/ZTextMetrics.h>
@@ -33,6 +35,8 @@ class ZTextLayoutPrivate {
     };
 
 public:
+    static ZTextLayoutPrivate *get(ZTextLayout *layout) { return layout->tuiwidgets_impl(); }
+
     ZTextLayoutPrivate(ZTextMetrics metrics) : metrics(metrics) {}
     ZTextLayoutPrivate(ZTextMetrics metrics, const QString &text) : metrics(metrics), text(text) {}
     virtual ~ZTextLayoutPrivate();
@@ -46,6 +50,25 @@ class ZTextLayoutPrivate {
     QVector<unsigned short> columns; // for each code unit the column (relative to pos in LineData) after the cluster
     QVector<LineData> lines;
     int nextIndex = -1;
+
+    // Width and text size of the last layout done by doLayout, -1 if the last layout was done manually.
+    int layoutWidth = -1;
+    int layoutTextSize = -1;
+
+    // Line break opportunities for word wrapping. Analysed once per text when first needed, relayout() updates them
+    // around the change when they are available for the text of the previous layout.
+    const QVector<bool> &lineBreakOpportunities();
+    void updateLineBreakOpportunities(int position, int charsRemoved, int charsAdded);
+    QVector<bool> lineBreaks; // for each position if a line break is allowed there
+    bool lineBreaksValid = false;
+    bool lineBreaksForLayoutText = false;
+
+    // For tests, only counted while testingCounters is set. Copies of the layout count into the same counters.
+    struct TestingCounters {
+        int incrementalRelayouts = 0;
+        int lineBreakAnalyses = 0;
+    };
+    TestingCounters *testingCounters = nullptr;
 };
 
 TUIWIDGETS_NS_END
@@ -4,8 +4,212 @@
 
 #include "Tui/ZTextMetrics_p.h"
 
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <QtAlgorithms>
+#include <QVector>
+
 TUIWIDGETS_NS_START
 
+namespace {
+    class Measurement {
+    public:
+        explicit Measurement(const ZTextMetricsPrivate *p) : p(p), tm(p->acquireMeasurement()) {
+        }
+
+        ~Measurement() {
+            p->releaseMeasurement(tm);
+        }
+
+        Measurement(const Measurement&) = delete;
+        Measurement &operator=(const Measurement&) = delete;
+
+        operator termpaint_text_measurement*() const {
+            return tm;
+        }
+
+    private:
+        const ZTextMetricsPrivate *p;
+        termpaint_text_measurement *tm;
+    };
+
+    void feed(termpaint_text_measurement *tm, const char32_t *data, int size) {
+        termpaint_text_measurement_feed_utf32(tm, reinterpret_cast<const uint32_t*>(data), size, true);
+    }
+
+    void feed(termpaint_text_measurement *tm, const char16_t *data, int size) {
+        termpaint_text_measurement_feed_utf16(tm, reinterpret_cast<const uint16_t*>(data), size, true);
+    }
+
+    void feed(termpaint_text_measurement *tm, const char *data, int size) {
+        termpaint_text_measurement_feed_utf8(tm, data, size, true);
+    }
+
+    ZTextMetrics::ClusterSize lastClusterSize(termpaint_text_measurement *tm) {
+        ZTextMetrics::ClusterSize result;
+        result.codePoints = termpaint_text_measurement_last_codepoints(tm);
+        result.codeUnits = termpaint_text_measurement_last_ref(tm);
+        result.columns = termpaint_text_measurement_last_width(tm);
+        return result;
+    }
+
+    ZTextMetrics::ClusterSize singleColumnClusters(int count) {
+        ZTextMetrics::ClusterSize result;
+        result.codePoints = count;
+        result.codeUnits = count;
+        result.columns = count;
+        return result;
+    }
+
+    template <typename T>
+    ZTextMetrics::ClusterSize nextClusterImpl(const ZTextMetricsPrivate *p, const T *data, int size) {
+        if (singleColumnPrefix(data, std::min(size, 2)) > 0) {
+            return singleColumnClusters(1);
+        }
+        Measurement tm(p);
+        termpaint_text_measurement_set_limit_clusters(tm, 1);
+        feed(tm, data, size);
+        return lastClusterSize(tm);
+    }
+
+    template <typename T>
+    ZTextMetrics::ClusterSize splitByColumnsImpl(const ZTextMetricsPrivate *p, const T *data, int size, int maxWidth) {
+        int ascii = 0;
+        if (maxWidth >= 0) {
+            ascii = singleColumnPrefix(data, size);
+            if ((ascii > 0 && ascii >= maxWidth) || ascii == size) {
+                return singleColumnClusters(std::min(ascii, maxWidth));
+            }
+        }
+        Measurement tm(p);
+        termpaint_text_measurement_set_limit_width(tm, maxWidth - ascii);
+        feed(tm, data + ascii, size - ascii);
+        ZTextMetrics::ClusterSize result = lastClusterSize(tm);
+        result.codePoints += ascii;
+        result.codeUnits += ascii;
+        result.columns += ascii;
+        return result;
+    }
+
+    struct Totals {
+        int columns;
+        int clusters;
+    };
+
+    template <typename T>
+    Totals measureAll(const ZTextMetricsPrivate *p, const T *data, int size) {
+        const int ascii = singleColumnPrefix(data, size);
+        if (ascii == size) {
+            return { ascii, ascii };
+        }
+        Measurement tm(p);
+        feed(tm, data + ascii, size - ascii);
+        return { ascii + termpaint_text_measurement_last_width(tm), ascii + termpaint_text_measurement_last_clusters(tm) };
+    }
+
+    template <typename T>
+    QVector<ZTextMetrics::ClusterSize> measureClustersImpl(const ZTextMetricsPrivate *p, const T *data, int size) {
+        QVector<ZTextMetrics::ClusterSize> result;
+        result.reserve(size);
+        Measurement tm(p);
+        int offset = 0;
+        bool needsReset = false;
+        while (offset < size) {
+            const int ascii = singleColumnPrefix(data + offset, size - offset);
+            for (int i = 0; i < ascii; i++) {
+                result.append(singleColumnClusters(1));
+            }
+            offset += ascii;
+            if (offset == size) {
+                break;
+            }
+            if (needsReset) {
+                termpaint_text_measurement_reset(tm);
+            }
+            needsReset = true;
+            termpaint_text_measurement_set_limit_clusters(tm, 1);
+            feed(tm, data + offset, size - offset);
+            const ZTextMetrics::ClusterSize cluster = lastClusterSize(tm);
+            if (cluster.codeUnits <= 0) {
+                break;
+            }
+            result.append(cluster);
+            offset += cluster.codeUnits;
+        }
+        return result;
+    }
+}
+
+int printableAsciiPrefix(const char32_t *data, int size) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i below = _mm_set1_epi32(0x20 - 1);
+    const __m128i above = _mm_set1_epi32(0x7e + 1);
+    for (; i + 4 <= size; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // values that are negative in the signed comparison are not printable either.
+        const __m128i printable = _mm_and_si128(_mm_cmpgt_epi32(v, below), _mm_cmplt_epi32(v, above));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(printable));
+        if (mask != 0xffff) {
+            return i + qCountTrailingZeroBits(~mask) / 4;
+        }
+    }
+#endif
+    while (i < size && data[i] >= 0x20 && data[i] <= 0x7e) {
+        i++;
+    }
+    return i;
+}
+
+int printableAsciiPrefix(const char16_t *data, int size) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i first = _mm_set1_epi16(0x20);
+    const __m128i range = _mm_set1_epi16(0x7e - 0x20);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= size; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // After subtracting 0x20 code units below the range wrap around, so in both directions code units outside
+        // of the range end up larger than the width of the range and the saturating subtraction leaves a non zero
+        // value.
+        const __m128i outside = _mm_subs_epu16(_mm_sub_epi16(v, first), range);
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(outside, zero)));
+        if (mask != 0xffff) {
+            return i + qCountTrailingZeroBits(~mask) / 2;
+        }
+    }
+#endif
+    while (i < size && data[i] >= 0x20 && data[i] <= 0x7e) {
+        i++;
+    }
+    return i;
+}
+
+int printableAsciiPrefix(const char *data, int size) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i below = _mm_set1_epi8(0x20 - 1);
+    const __m128i above = _mm_set1_epi8(0x7e + 1);
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // bytes of multi byte sequences are negative in the signed comparison.
+        const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, below), _mm_cmplt_epi8(v, above));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(printable));
+        if (mask != 0xffff) {
+            return i + qCountTrailingZeroBits(~mask);
+        }
+    }
+#endif
+    while (i < size && data[i] >= 0x20 && data[i] <= 0x7e) {
+        i++;
+    }
+    return i;
+}
+
 ZTextMetrics::ZTextMetrics(const ZTextMetrics& other) : tuiwidgets_pimpl_ptr(other.tuiwidgets_pimpl_ptr)
 {
 }
@@ -22,45 +226,15 @@ ZTextMetrics::ClusterSize ZTextMetrics::nextCluster(const QChar *data, int size)
 }
 
 ZTextMetrics::ClusterSize ZTextMetrics::nextCluster(const char32_t *data, int size) const {
-    const auto *const p = tuiwidgets_impl();
-    // TODO have some kind of pool
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_set_limit_clusters(tm, 1);
-    termpaint_text_measurement_feed_utf32(tm, reinterpret_cast<const uint32_t*>(data), size, true);
-    ClusterSize result;
-    result.codePoints = termpaint_text_measurement_last_codepoints(tm);
-    result.codeUnits = termpaint_text_measurement_last_ref(tm);
-    result.columns = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return result;
+    return nextClusterImpl(tuiwidgets_impl(), data, size);
 }
 
 ZTextMetrics::ClusterSize ZTextMetrics::nextCluster(const char16_t *data, int size) const {
-    const auto *const p = tuiwidgets_impl();
-    // TODO have some kind of pool
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_set_limit_clusters(tm, 1);
-    termpaint_text_measurement_feed_utf16(tm, reinterpret_cast<const uint16_t*>(data), size, true);
-    ClusterSize result;
-    result.codePoints = termpaint_text_measurement_last_codepoints(tm);
-    result.codeUnits = termpaint_text_measurement_last_ref(tm);
-    result.columns = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return result;
+    return nextClusterImpl(tuiwidgets_impl(), data, size);
 }
 
 ZTextMetrics::ClusterSize ZTextMetrics::nextCluster(const char *stringUtf8, int utf8CodeUnits) const {
-    const auto *const p = tuiwidgets_impl();
-    // TODO have some kind of pool
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_set_limit_clusters(tm, 1);
-    termpaint_text_measurement_feed_utf8(tm, stringUtf8, utf8CodeUnits, true);
-    ClusterSize result;
-    result.codePoints = termpaint_text_measurement_last_codepoints(tm);
-    result.codeUnits = termpaint_text_measurement_last_ref(tm);
-    result.columns = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return result;
+    return nextClusterImpl(tuiwidgets_impl(), stringUtf8, utf8CodeUnits);
 }
 
 ZTextMetrics::ClusterSize ZTextMetrics::splitByColumns(const QString &data, int maxWidth) const {
@@ -72,45 +246,15 @@ ZTextMetrics::ClusterSize ZTextMetrics::splitByColumns(const QChar *data, int si
 }
 
 ZTextMetrics::ClusterSize ZTextMetrics::splitByColumns(const char32_t *data, int size, int maxWidth) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_set_limit_width(tm, maxWidth);
-    termpaint_text_measurement_feed_utf32(tm, reinterpret_cast<const uint32_t*>(data), size, true);
-
-    ClusterSize result;
-    result.codePoints = termpaint_text_measurement_last_codepoints(tm);
-    result.codeUnits = termpaint_text_measurement_last_ref(tm);
-    result.columns = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return result;
+    return splitByColumnsImpl(tuiwidgets_impl(), data, size, maxWidth);
 }
 
 ZTextMetrics::ClusterSize ZTextMetrics::splitByColumns(const char16_t *data, int size, int maxWidth) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_set_limit_width(tm, maxWidth);
-    termpaint_text_measurement_feed_utf16(tm, reinterpret_cast<const uint16_t*>(data), size, true);
-
-    ClusterSize result;
-    result.codePoints = termpaint_text_measurement_last_codepoints(tm);
-    result.codeUnits = termpaint_text_measurement_last_ref(tm);
-    result.columns = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return result;
+    return splitByColumnsImpl(tuiwidgets_impl(), data, size, maxWidth);
 }
 
 ZTextMetrics::ClusterSize ZTextMetrics::splitByColumns(const char *stringUtf8, int utf8CodeUnits, int maxWidth) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_set_limit_width(tm, maxWidth);
-    termpaint_text_measurement_feed_utf8(tm, stringUtf8, utf8CodeUnits, true);
-
-    ClusterSize result;
-    result.codePoints = termpaint_text_measurement_last_codepoints(tm);
-    result.codeUnits = termpaint_text_measurement_last_ref(tm);
-    result.columns = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return result;
+    return splitByColumnsImpl(tuiwidgets_impl(), stringUtf8, utf8CodeUnits, maxWidth);
 }
 
 int ZTextMetrics::sizeInColumns(const QString &data) const {
@@ -122,33 +266,15 @@ int ZTextMetrics::sizeInColumns(const QChar *data, int size) const {
 }
 
 int ZTextMetrics::sizeInColumns(const char32_t *data, int size) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_feed_utf32(tm, reinterpret_cast<const uint32_t*>(data), size, true);
-
-    int res = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return res;
+    return measureAll(tuiwidgets_impl(), data, size).columns;
 }
 
 int ZTextMetrics::sizeInColumns(const char16_t *data, int size) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_feed_utf16(tm, reinterpret_cast<const uint16_t*>(data), size, true);
-
-    int res = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return res;
+    return measureAll(tuiwidgets_impl(), data, size).columns;
 }
 
 int ZTextMetrics::sizeInColumns(const char *stringUtf8, int utf8CodeUnits) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_feed_utf8(tm, stringUtf8, utf8CodeUnits, true);
-
-    int res = termpaint_text_measurement_last_width(tm);
-    termpaint_text_measurement_free(tm);
-    return res;
+    return measureAll(tuiwidgets_impl(), stringUtf8, utf8CodeUnits).columns;
 }
 
 int ZTextMetrics::sizeInClusters(const QString &data) const {
@@ -160,33 +286,35 @@ int ZTextMetrics::sizeInClusters(const QChar *data, int size) const {
 }
 
 int ZTextMetrics::sizeInClusters(const char32_t *data, int size) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_feed_utf32(tm, reinterpret_cast<const uint32_t*>(data), size, true);
-
-    int res = termpaint_text_measurement_last_clusters(tm);
-    termpaint_text_measurement_free(tm);
-    return res;
+    return measureAll(tuiwidgets_impl(), data, size).clusters;
 }
 
 int ZTextMetrics::sizeInClusters(const char16_t *data, int size) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_feed_utf16(tm, reinterpret_cast<const uint16_t*>(data), size, true);
-
-    int res = termpaint_text_measurement_last_clusters(tm);
-    termpaint_text_measurement_free(tm);
-    return res;
+    return measureAll(tuiwidgets_impl(), data, size).clusters;
 }
 
 int ZTextMetrics::sizeInClusters(const char *stringUtf8, int utf8CodeUnits) const {
-    const auto *const p = tuiwidgets_impl();
-    termpaint_text_measurement *tm = termpaint_text_measurement_new(p->surface);
-    termpaint_text_measurement_feed_utf8(tm, stringUtf8, utf8CodeUnits, true);
+    return measureAll(tuiwidgets_impl(), stringUtf8, utf8CodeUnits).clusters;
+}
+
+QVector<ZTextMetrics::ClusterSize> ZTextMetrics::measureClusters(const QString &data) const {
+    return measureClusters(data.constData(), data.size());
+}
+
+QVector<ZTextMetrics::ClusterSize> ZTextMetrics::measureClusters(const QChar *data, int size) const {
+    return measureClusters(reinterpret_cast<const char16_t*>(data), size);
+}
 
-    int res = termpaint_text_measurement_last_clusters(tm);
-    termpaint_text_measurement_free(tm);
-    return res;
+QVector<ZTextMetrics::ClusterSize> ZTextMetrics::measureClusters(const char32_t *data, int size) const {
+    return measureClustersImpl(tuiwidgets_impl(), data, size);
+}
+
+QVector<ZTextMetrics::ClusterSize> ZTextMetrics::measureClusters(const char16_t *data, int size) const {
+    return measureClustersImpl(tuiwidgets_impl(), data, size);
+}
+
+QVector<ZTextMetrics::ClusterSize> ZTextMetrics::measureClusters(const char *stringUtf8, int utf8CodeUnits) const {
+    return measureClustersImpl(tuiwidgets_impl(), stringUtf8, utf8CodeUnits);
 }
 
 ZTextMetrics &ZTextMetrics::operator=(const ZTextMetrics&) = default;
@@ -200,6 +328,31 @@ ZTextMetricsPrivate::ZTextMetricsPrivate(termpaint_surface *surface) : surface(s
 }
 
 ZTextMetricsPrivate::~ZTextMetricsPrivate() {
+    termpaint_text_measurement *tm = cachedMeasurement.load(std::memory_order_acquire);
+    if (tm) {
+        termpaint_text_measurement_free(tm);
+    }
+}
+
+termpaint_text_measurement *ZTextMetricsPrivate::acquireMeasurement() const {
+    termpaint_text_measurement *tm = cachedMeasurement.exchange(nullptr, std::memory_order_acquire);
+    if (!tm) {
+        return termpaint_text_measurement_new(surface);
+    }
+    termpaint_text_measurement_reset(tm);
+    termpaint_text_measurement_set_limit_codepoints(tm, -1);
+    termpaint_text_measurement_set_limit_clusters(tm, -1);
+    termpaint_text_measurement_set_limit_width(tm, -1);
+    termpaint_text_measurement_set_limit_ref(tm, -1);
+    return tm;
+}
+
+void ZTextMetricsPrivate::releaseMeasurement(termpaint_text_measurement *tm) const {
+    termpaint_text_measurement *expected = nullptr;
+    if (!cachedMeasurement.compare_exchange_strong(expected, tm, std::memory_order_release)) {
+        // Nested or concurrent use, the slot is already taken.
+        termpaint_text_measurement_free(tm);
+    }
 }
 
 ZTextMetrics ZTextMetricsPrivate::createForTesting(termpaint_surface *surface) {
@@ -10,6 +10,7 @@
 #endif
 
 #include <QString>
+#include <QVector>
 
 #include <Tui/tuiwidgets_internal.h>
 
@@ -49,6 +50,11 @@ class TUIWIDGETS_EXPORT ZTextMetrics {
     int sizeInClusters(const char32_t *data, int size) const;
     int sizeInClusters(const char16_t *data, int size) const;
     int sizeInClusters(const char *stringUtf8, int utf8CodeUnits) const;
+    QVector<ClusterSize> measureClusters(const QString &data) const;
+    QVector<ClusterSize> measureClusters(const QChar *data, int size) const;
+    QVector<ClusterSize> measureClusters(const char32_t *data, int size) const;
+    QVector<ClusterSize> measureClusters(const char16_t *data, int size) const;
+    QVector<ClusterSize> measureClusters(const char *stringUtf8, int utf8CodeUnits) const;
 
     // Wrappers for more modern types:
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0) && defined(TUIWIDGETS_ABI_FORCE_INLINE)
@@ -68,6 +74,10 @@ class TUIWIDGETS_EXPORT ZTextMetrics {
     TUIWIDGETS_ABI_FORCE_INLINE int sizeInClusters(QSTRINGVIEW data) const {
         return sizeInClusters(data.data(), data.size());
     }
+    template <typename QSTRINGVIEW, Private::enable_if_same_remove_cvref<QSTRINGVIEW, QStringView> = 0>
+    TUIWIDGETS_ABI_FORCE_INLINE QVector<ClusterSize> measureClusters(QSTRINGVIEW data) const {
+        return measureClusters(data.data(), data.size());
+    }
 #endif
 #if defined(__cpp_lib_string_view) && defined(TUIWIDGETS_ABI_FORCE_INLINE)
     template <typename U16STRINGVIEW, Private::enable_if_same_remove_cvref<U16STRINGVIEW, std::u16string_view> = 0>
@@ -86,6 +96,10 @@ class TUIWIDGETS_EXPORT ZTextMetrics {
     TUIWIDGETS_ABI_FORCE_INLINE int sizeInClusters(U16STRINGVIEW data) const {
         return sizeInClusters(data.data(), data.size());
     }
+    template <typename U16STRINGVIEW, Private::enable_if_same_remove_cvref<U16STRINGVIEW, std::u16string_view> = 0>
+    TUIWIDGETS_ABI_FORCE_INLINE QVector<ClusterSize> measureClusters(U16STRINGVIEW data) const {
+        return measureClusters(data.data(), data.size());
+    }
 
     // Assumes utf8 in string_view
     template <typename STRINGVIEW, Private::enable_if_same_remove_cvref<STRINGVIEW, std::string_view> = 0>
@@ -104,6 +118,10 @@ class TUIWIDGETS_EXPORT ZTextMetrics {
     TUIWIDGETS_ABI_FORCE_INLINE int sizeInClusters(STRINGVIEW data) const {
         return sizeInClusters(data.data(), data.size());
     }
+    template <typename STRINGVIEW, Private::enable_if_same_remove_cvref<STRINGVIEW, std::string_view> = 0>
+    TUIWIDGETS_ABI_FORCE_INLINE QVector<ClusterSize> measureClusters(STRINGVIEW data) const {
+        return measureClusters(data.data(), data.size());
+    }
 #endif
 
     ZTextMetrics &operator=(const ZTextMetrics&);
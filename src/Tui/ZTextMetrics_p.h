@@ -3,12 +3,32 @@
 #ifndef TUIWIDGETS_ZTEXTMETRICS_P_INCLUDED
 #define TUIWIDGETS_ZTEXTMETRICS_P_INCLUDED
 
+#include <atomic>
+#include <type_traits>
+
 #include <termpaint.h>
 
 #include <Tui/tuiwidgets_internal.h>
 
 TUIWIDGETS_NS_START
 
+// Returns the number of code units at the start of data that are printable ascii (U+0020 to U+007E).
+int printableAsciiPrefix(const char32_t *data, int size);
+int printableAsciiPrefix(const char16_t *data, int size);
+int printableAsciiPrefix(const char *data, int size);
+
+// Returns the number of code units at the start of data that are each a cluster of width 1 on their own. That is the
+// printable ascii prefix, except for its last code unit if that could be combined with a following non ascii code
+// point.
+template <typename T>
+int singleColumnPrefix(const T *data, int size) {
+    const int ascii = printableAsciiPrefix(data, size);
+    if (ascii > 0 && ascii < size && static_cast<std::make_unsigned_t<T>>(data[ascii]) >= 0x80) {
+        return ascii - 1;
+    }
+    return ascii;
+}
+
 class ZTextMetricsPrivate {
 public:
     ZTextMetricsPrivate(termpaint_surface *surface);
@@ -16,6 +36,11 @@ class ZTextMetricsPrivate {
 
     termpaint_surface *surface;
 
+    // Measuring is often done one cluster at a time, so a measurement object is kept for reuse.
+    termpaint_text_measurement *acquireMeasurement() const;
+    void releaseMeasurement(termpaint_text_measurement *tm) const;
+    mutable std::atomic<termpaint_text_measurement*> cachedMeasurement { nullptr };
+
     // back door
     static ZTextMetricsPrivate *get(ZTextMetrics *tm) { return tm->tuiwidgets_impl(); }
     static ZTextMetrics createForTesting(termpaint_surface *surface);
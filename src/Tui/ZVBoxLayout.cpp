@@ -79,8 +79,14 @@ void ZVBoxLayout::setGeometry(QRect toFill) {
     auto place = [&visibleItems, width, toFill] (int y, int h, int idx) {
         placeWidgetInCell(toFill.x(), toFill.y() + y, width, h, visibleItems[idx], Alignment());
     };
-    auto getHint = [&visibleItems] (int idx) {
-        return visibleItems[idx]->sizeHint().height();
+    // boxLayouter asks for the hints multiple times
+    std::vector<int> hints;
+    hints.reserve(visibleItems.size());
+    for (ZLayoutItem *item : visibleItems) {
+        hints.push_back(item->sizeHint().height());
+    }
+    auto getHint = [&hints] (int idx) {
+        return hints[idx];
     };
 
     auto getPolicy = [&visibleItems] (int idx) {
@@ -111,6 +117,11 @@ void ZVBoxLayout::removeWidgetRecursively(ZWidget *widget) {
 QSize ZVBoxLayout::sizeHint() const {
     auto *const p = tuiwidgets_impl();
 
+    QSize cached;
+    if (p->lookupSizeHint(&cached)) {
+        return cached;
+    }
+
     int hintSize = 0;
     int hintOther = 0;
     int numSpacer = 0;
@@ -131,7 +142,7 @@ QSize ZVBoxLayout::sizeHint() const {
 
     hintSize += p->spacing * (visibleItems - 1 - numSpacer);
 
-    return { hintOther, hintSize };
+    return p->storeSizeHint(QSize{ hintOther, hintSize });
 }
 
 SizePolicy ZVBoxLayout::sizePolicyH() const {
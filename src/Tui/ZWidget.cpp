@@ -11,7 +11,9 @@
 
 #include <Tui/ZCommandManager.h>
 #include <Tui/ZLayout.h>
+#include <Tui/ZLayout_p.h>
 #include <Tui/ZPainter.h>
+#include <Tui/ZPainter_p.h>
 #include <Tui/ZPalette.h>
 #include <Tui/ZTerminal_p.h>
 
@@ -83,6 +85,8 @@ ZWidget::~ZWidget() {
 void ZWidget::setParent(ZWidget *newParent) {
     auto *const p = tuiwidgets_impl();
     if (parent() == newParent) return;
+    // the area currently covered by this widget needs to be repainted
+    update();
     auto prevTerminal = terminal();
     QEvent e1{QEvent::ParentAboutToChange};
     QCoreApplication::sendEvent(this, &e1);
@@ -115,6 +119,8 @@ void ZWidget::setParent(ZWidget *newParent) {
     }
     QObject::setParent(newParent);
 
+    p->invalidatePaletteCacheRecursively();
+
     // to apply stacking layer
     if (newParent) {
         QList<QObject*>& list = parentWidget()->d_ptr->children;
@@ -172,9 +178,18 @@ QRect ZWidget::geometry() const {
 
 void ZWidget::setGeometry(const QRect &rect) {
     auto *const p = tuiwidgets_impl();
-    QRect oldGeometry = p->geometry;
     // don't allow negative size
-    p->geometry = QRect{rect.topLeft(), rect.size().expandedTo({0, 0})};
+    const QRect newGeometry = QRect{rect.topLeft(), rect.size().expandedTo({0, 0})};
+    if (newGeometry == p->geometry) {
+        // Layouts place all their items on each layout pass. Unchanged widgets get no resize or move events and thus
+        // are not relayouted, they must not add damage either. This holds even if their size hint changed, as their
+        // layout area stays the same and children whose size hint changed request a relayout via updateGeometry().
+        return;
+    }
+    // the area currently covered by this widget needs to be repainted
+    update();
+    QRect oldGeometry = p->geometry;
+    p->geometry = newGeometry;
     if (oldGeometry.topLeft() != p->geometry.topLeft()) {
         ZMoveEvent e {p->geometry.topLeft(), oldGeometry.topLeft()};
         QCoreApplication::sendEvent(this, &e);
@@ -248,7 +263,25 @@ void ZWidget::setEnabled(bool e) {
     }
     // TODO cache effect in hierarchy
     p->updateEffectivelyEnabledRecursively();
-    update();
+    // enabled state can change how other widgets are painted (e.g. labels with buddies)
+    ZTerminal *term = terminal();
+    if (term) {
+        term->update();
+    }
+}
+
+void ZWidgetPrivate::invalidatePaletteCacheRecursively() {
+    if (!paletteCache.valid) {
+        // children can only have a valid cache if this widget has one
+        return;
+    }
+    paletteCache = {};
+    for (QObject *child : pub()->children()) {
+        ZWidget *childWidget = qobject_cast<ZWidget*>(child);
+        if (childWidget) {
+            ZWidgetPrivate::get(childWidget)->invalidatePaletteCacheRecursively();
+        }
+    }
 }
 
 void ZWidgetPrivate::updateEffectivelyEnabledRecursively() {
@@ -300,7 +333,11 @@ void ZWidget::setVisible(bool v) {
         QCoreApplication::sendEvent(this, &hideToParentEvent);
     }
     updateGeometry();
-    update();
+    // visibility can change how other widgets are painted (e.g. window lists)
+    ZTerminal *term = terminal();
+    if (term) {
+        term->update();
+    }
 }
 
 void ZWidget::setStackingLayer(int layer) {
@@ -418,6 +455,7 @@ QSize ZWidget::minimumSize() const {
 void ZWidget::setMinimumSize(QSize s) {
     auto *const p = tuiwidgets_impl();
     p->minimumSize = s;
+    p->invalidateSizeHintCache();
 
     ZTerminal *term = terminal();
     if (term) {
@@ -437,6 +475,7 @@ QSize ZWidget::maximumSize() const {
 void ZWidget::setMaximumSize(QSize s) {
     auto *const p = tuiwidgets_impl();
     p->maximumSize = s;
+    p->invalidateSizeHintCache();
 
     ZTerminal *term = terminal();
     if (term) {
@@ -508,16 +547,33 @@ QSize ZWidget::minimumSizeHint() const {
 }
 
 QSize ZWidget::effectiveSizeHint() const {
+    auto *const p = tuiwidgets_impl();
+    const uint64_t pass = ZTerminalPrivate::activeLayoutPass;
+    if (pass && p->sizeHintCachePass == pass) {
+        return p->cachedEffectiveSizeHint;
+    }
     QSize s = sizeHint();
-    return s.expandedTo(effectiveMinimumSize()).boundedTo(maximumSize());
+    s = s.expandedTo(effectiveMinimumSize()).boundedTo(maximumSize());
+    p->sizeHintCachePass = pass;
+    p->cachedEffectiveSizeHint = s;
+    return s;
 }
 
 QSize ZWidget::effectiveMinimumSize() const {
+    auto *const p = tuiwidgets_impl();
+    const uint64_t pass = ZTerminalPrivate::activeLayoutPass;
+    if (pass && p->minimumSizeCachePass == pass) {
+        return p->cachedEffectiveMinimumSize;
+    }
+    QSize s;
     if (minimumSize().isValid())  {
-        return minimumSize().boundedTo(maximumSize());
+        s = minimumSize().boundedTo(maximumSize());
     } else {
-        return minimumSizeHint().boundedTo(maximumSize());
+        s = minimumSizeHint().boundedTo(maximumSize());
     }
+    p->minimumSizeCachePass = pass;
+    p->cachedEffectiveMinimumSize = s;
+    return s;
 }
 
 QRect ZWidget::layoutArea() const {
@@ -535,6 +591,7 @@ void ZWidget::setLayout(ZLayout *l) {
     auto *const p = tuiwidgets_impl();
     l->setParent(this);
     p->layout = l;
+    p->invalidateSizeHintCache();
     ZTerminal *term = terminal();
     if (term) {
         term->requestLayout(this);
@@ -577,11 +634,15 @@ ZTerminal *ZWidget::terminal() const {
 }
 
 void ZWidget::update() {
-    auto *terminal = tuiwidgets_impl()->findTerminal();
-    if (terminal) terminal->update();
+    auto *const p = tuiwidgets_impl();
+    auto *terminal = p->findTerminal();
+    if (terminal) {
+        ZTerminalPrivate::get(terminal)->addDamagedRect(p->visibleRectInTerminal());
+    }
 }
 
 void ZWidget::updateGeometry() {
+    tuiwidgets_impl()->invalidateSizeHintCache();
     ZTerminal *term = terminal();
     if (term) {
         ZWidget *par = parentWidget();
@@ -629,6 +690,7 @@ QMargins ZWidget::contentsMargins() const {
 void ZWidget::setContentsMargins(QMargins m) {
     auto *const p = tuiwidgets_impl();
     p->contentsMargins = m;
+    p->invalidateSizeHintCache();
 
     ZTerminal *term = terminal();
     if (term) {
@@ -645,6 +707,7 @@ const ZPalette &ZWidget::palette() const {
 void ZWidget::setPalette(const ZPalette &pal) {
     auto *const p = tuiwidgets_impl();
     p->palette = pal;
+    p->invalidatePaletteCacheRecursively();
     update();
 }
 
@@ -663,6 +726,7 @@ void ZWidget::setPaletteClass(QStringList classes) {
     if (p->paletteClass == classes) return;
     // TODO some event
     p->paletteClass = classes;
+    p->invalidatePaletteCacheRecursively();
     update();
 }
 
@@ -1306,6 +1370,9 @@ bool ZWidget::eventFilter(QObject *watched, QEvent *event) {
 void ZWidgetPrivate::updateRequestEvent(ZPaintEvent *event)
 {
     auto *painter = event->painter();
+    if (int *widgetsPainted = ZPainterPrivate::get(painter)->widgetsPainted) {
+        ++*widgetsPainted;
+    }
     {
         ZPaintEvent nestedEvent(painter);
         QCoreApplication::instance()->sendEvent(pub(), &nestedEvent);
@@ -1319,12 +1386,33 @@ void ZWidgetPrivate::updateRequestEvent(ZPaintEvent *event)
         }
         const QRect &childRect = child->tuiwidgets_impl()->geometry;
         ZPainter transformedPainter = painter->translateAndClip(childRect);
+        if (ZPainterPrivate::get(painter)->damagedAreaOnly) {
+            auto *const transformedPainterPriv = ZPainterPrivate::get(&transformedPainter);
+            if (transformedPainterPriv->width <= 0 || transformedPainterPriv->height <= 0) {
+                // completely outside of the damaged area, skip whole subtree
+                continue;
+            }
+        }
         transformedPainter.setWidget(child);
         ZPaintEvent nestedEvent(ZPaintEvent::update, &transformedPainter);
         QCoreApplication::instance()->sendEvent(child, &nestedEvent);
     }
 }
 
+void ZWidgetPrivate::invalidateSizeHintCache() {
+    // The size hint of a widget with a layout depends on the hints of its children, so parents are invalidated too.
+    ZWidget *w = pub();
+    while (w) {
+        auto *const wp = ZWidgetPrivate::get(w);
+        wp->sizeHintCachePass = 0;
+        wp->minimumSizeCachePass = 0;
+        if (wp->layout) {
+            ZLayoutPrivate::invalidateSizeHintCache(wp->layout);
+        }
+        w = w->parentWidget();
+    }
+}
+
 ZTerminal *ZWidgetPrivate::findTerminal() const {
     ZWidget const *w = pub();
     while (w) {
@@ -1336,6 +1424,17 @@ ZTerminal *ZWidgetPrivate::findTerminal() const {
     return nullptr;
 }
 
+QRect ZWidgetPrivate::visibleRectInTerminal() const {
+    QRect rect = {QPoint{0, 0}, geometry.size()};
+    const ZWidget *w = pub();
+    while (w) {
+        const QRect &wGeometry = ZWidgetPrivate::get(w)->geometry;
+        rect = rect.intersected({QPoint{0, 0}, wGeometry.size()}).translated(wGeometry.topLeft());
+        w = w->parentWidget();
+    }
+    return rect;
+}
+
 void ZWidgetPrivate::unsetTerminal() {
     terminal = nullptr;
 }
@@ -1384,6 +1483,9 @@ void ZWidget::childEvent(QChildEvent *event) {
     if (event->removed() && event->child() == p->layout) {
         p->layout = nullptr;
     }
+    if (event->added() || event->removed()) {
+        p->invalidateSizeHintCache();
+    }
 
     QObject::childEvent(event);
 }
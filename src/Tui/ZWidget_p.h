@@ -7,6 +7,7 @@
 
 #include <Tui/tuiwidgets_internal.h>
 
+#include <QHash>
 #include <QPointer>
 #include <QVector>
 
@@ -47,6 +48,7 @@ class ZWidgetPrivate {
     void updateRequestEvent(ZPaintEvent *event);
 
     ZTerminal *findTerminal() const;
+    QRect visibleRectInTerminal() const;
 
     void unsetTerminal();
     void setManagingTerminal(ZTerminal *terminal);
@@ -58,6 +60,11 @@ class ZWidgetPrivate {
 
     void disperseFocus();
 
+    void invalidatePaletteCacheRecursively();
+
+    // Invalidates the memoized size hints of this widget, its parents and their layouts.
+    void invalidateSizeHintCache();
+
     // variables
     QRect geometry;
     FocusPolicy focusPolicy = NoFocus;
@@ -82,6 +89,17 @@ class ZWidgetPrivate {
     ZPalette palette;
     QStringList paletteClass;
 
+    // cache for ZPalette::getColor, only valid if the cache of the parent is valid too
+    struct PaletteCache {
+        bool valid = false;
+        // rules from this widget and all parents
+        QList<const ZPalette::RuleDef*> rules;
+        // colors as seen by children of this widget
+        QHash<ZSymbol, ZColor> published;
+        // colors as seen by this widget, includes local rules
+        QHash<ZSymbol, ZColor> resolved;
+    } paletteCache;
+
     CursorStyle cursorStyle = CursorStyle::Unset;
     int cursorColorR = -1, cursorColorG = -1, cursorColorB = -1;
 
@@ -95,6 +113,13 @@ class ZWidgetPrivate {
     // scratch storage for ZTerminal::doLayout
     int doLayoutScratchDepth;
 
+    // effectiveSizeHint() and effectiveMinimumSize() memoized for the layout pass with this id, see
+    // ZTerminalPrivate::activeLayoutPass
+    mutable uint64_t sizeHintCachePass = 0;
+    mutable QSize cachedEffectiveSizeHint;
+    mutable uint64_t minimumSizeCachePass = 0;
+    mutable QSize cachedEffectiveMinimumSize;
+
     // back door
     static ZWidgetPrivate *get(ZWidget *widget) { return widget->tuiwidgets_impl(); }
     static const ZWidgetPrivate *get(const ZWidget *widget) { return widget->tuiwidgets_impl(); }
@@ -118,6 +118,9 @@ void ZWindowLayout::removeWidgetRecursively(ZWidget *widget) {
 QSize ZWindowLayout::sizeHint() const {
     auto *const p = tuiwidgets_impl();
     QSize size;
+    if (p->lookupSizeHint(&size)) {
+        return size;
+    }
 
     ZWindow* w = qobject_cast<ZWindow*>(parentWidget());
 
@@ -168,7 +171,7 @@ QSize ZWindowLayout::sizeHint() const {
         tbBorderWidgetsHeight += 1;
     }
     size.setHeight(std::max(size.height(), tbBorderWidgetsHeight));
-    return size - QSize{rlBorder, tbBorder};
+    return p->storeSizeHint(size - QSize{rlBorder, tbBorder});
 }
 
 int ZWindowLayout::topBorderLeftAdjust() const {
@@ -1350,3 +1350,74 @@ TEST_CASE("boxlayout-lifetime", "") {
         tests(layout);
     }
 }
+
+namespace {
+    class CountingStubWidget : public StubWidget {
+    public:
+        using StubWidget::StubWidget;
+
+        QSize sizeHint() const override {
+            ++sizeHintCalls;
+            return StubWidget::sizeHint();
+        }
+
+        QSize minimumSizeHint() const override {
+            ++minimumSizeHintCalls;
+            return StubWidget::minimumSizeHint();
+        }
+
+        mutable int sizeHintCalls = 0;
+        mutable int minimumSizeHintCalls = 0;
+    };
+}
+
+TEST_CASE("boxlayout-sizehint-memoized", "") {
+    Testhelper t("unused", "unused", 40, 20);
+    TestBackground *w = new TestBackground(t.root);
+    w->setGeometry({0, 0, 40, 20});
+    t.terminal->doLayout();
+
+    Tui::ZWidget *outer = new Tui::ZWidget(w);
+    auto *outerLayout = new Tui::ZVBoxLayout();
+    outer->setLayout(outerLayout);
+    QVector<CountingStubWidget*> leaves;
+    for (int i = 0; i < 3; i++) {
+        auto *row = new Tui::ZHBoxLayout();
+        outerLayout->add(row);
+        for (int j = 0; j < 3; j++) {
+            auto *container = new Tui::ZWidget(outer);
+            auto *containerLayout = new Tui::ZVBoxLayout();
+            container->setLayout(containerLayout);
+            row->addWidget(container);
+            auto *leaf = new CountingStubWidget(container);
+            leaf->stubSizeHint = {3, 1};
+            leaf->setSizePolicyH(Tui::SizePolicy::Fixed);
+            containerLayout->addWidget(leaf);
+            leaves.append(leaf);
+        }
+    }
+    outer->setGeometry({1, 1, 9, 3});
+    t.terminal->doLayout();
+
+    for (CountingStubWidget *leaf : leaves) {
+        CHECK(leaf->sizeHintCalls == 1);
+        CHECK(leaf->minimumSizeHintCalls == 1);
+        CHECK(leaf->geometry().size() == QSize{3, 1});
+        leaf->sizeHintCalls = 0;
+        leaf->minimumSizeHintCalls = 0;
+    }
+
+    // outside of a layout pass hints are not memoized
+    leaves[0]->stubSizeHint = {2, 1};
+    CHECK(leaves[0]->effectiveSizeHint() == QSize{2, 1});
+    CHECK(outer->sizeHint() == QSize{8, 3});
+
+    // updateGeometry invalidates the memoized hints in the next layout pass
+    leaves[0]->updateGeometry();
+    leaves[0]->sizeHintCalls = 0;
+    leaves[0]->minimumSizeHintCalls = 0;
+    t.terminal->doLayout();
+    CHECK(leaves[0]->geometry().size() == QSize{2, 1});
+    CHECK(leaves[0]->sizeHintCalls == 1);
+    CHECK(leaves[0]->minimumSizeHintCalls == 1);
+}
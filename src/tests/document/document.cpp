@@ -7,10 +7,13 @@
 
 #include <random>
 #include <array>
+#include <memory>
 
 #include <QBuffer>
 #include <QCoreApplication>
+#include <QTemporaryFile>
 
+#include <Tui/Misc/SurrogateEscape.h>
 #include <Tui/ZTerminal.h>
 #include <Tui/ZTextMetrics.h>
 #include <Tui/ZTextOption.h>
@@ -833,6 +836,118 @@ TEST_CASE("ZDocument") {
         }
     }
 
+    SECTION("readFrom - mapped file") {
+        QTemporaryFile tfile;
+        REQUIRE(tfile.open());
+
+        auto load = [&](const QByteArray &contents) {
+            REQUIRE(tfile.resize(0));
+            REQUIRE(tfile.write(contents) == contents.size());
+            REQUIRE(tfile.seek(0));
+            REQUIRE(doc.readFrom(&tfile));
+            CHECK(tfile.atEnd());
+        };
+
+        SECTION("empty") {
+            load(QByteArray());
+            CHECK(docToVec(doc) == QVector<QString>{ "" });
+            CHECK(doc.newlineAfterLastLineMissing() == true);
+            CHECK(doc.crLfMode() == false);
+        }
+
+        SECTION("simple") {
+            load("line1\n\nline3\n");
+            CHECK(docToVec(doc) == QVector<QString>{ "line1", "", "line3" });
+            CHECK(doc.newlineAfterLastLineMissing() == false);
+            CHECK(doc.crLfMode() == false);
+        }
+
+        SECTION("missing newline") {
+            load("line1\nline2");
+            CHECK(docToVec(doc) == QVector<QString>{ "line1", "line2" });
+            CHECK(doc.newlineAfterLastLineMissing() == true);
+        }
+
+        SECTION("crlf") {
+            load("line1\r\nline2\r\n");
+            CHECK(docToVec(doc) == QVector<QString>{ "line1", "line2" });
+            CHECK(doc.newlineAfterLastLineMissing() == false);
+            CHECK(doc.crLfMode() == true);
+        }
+
+        SECTION("invalid utf8") {
+            load("a\xff" "b\n");
+            CHECK(docToVec(doc) == QVector<QString>{ QString(QChar('a')) + QChar(0xdcff) + QChar('b') });
+        }
+
+        SECTION("large") {
+            // Large enough to be split into several chunks that are decoded in parallel.
+            QByteArray contents;
+            QVector<QString> expected;
+            for (int i = 0; contents.size() < 10 * 1024 * 1024; i++) {
+                const QByteArray line = QByteArray::number(i) + QByteArray(i % 200, 'x');
+                contents += line + "\n";
+                expected.append(QString::fromLatin1(line));
+            }
+            contents += "last";
+            expected.append("last");
+            load(contents);
+            CHECK(doc.lineCount() == expected.size());
+            CHECK(docToVec(doc) == expected);
+            CHECK(doc.newlineAfterLastLineMissing() == true);
+
+            QByteArray outData;
+            QBuffer outFile(&outData);
+            REQUIRE(outFile.open(QIODevice::WriteOnly));
+            doc.writeTo(&outFile, doc.crLfMode());
+            CHECK(outData == contents);
+        }
+    }
+
+    SECTION("writeTo - large") {
+        // Larger than the internal write buffer, with a mix of ASCII and non ASCII lines.
+        QString text;
+        for (int i = 0; text.size() < 3 * 1024 * 1024; i++) {
+            text += QString::number(i) + QString(i % 100, QChar('x'));
+            if (i % 7 == 0) {
+                text += QString(QChar(0xe4)) + QChar(0xdcff);
+            }
+            text += QStringLiteral("\n");
+        }
+        doc.setText(text);
+        QByteArray expected = Tui::Misc::SurrogateEscape::encode(text);
+
+        SECTION("sync") {
+            QByteArray outData;
+            QBuffer outFile(&outData);
+            REQUIRE(outFile.open(QIODevice::WriteOnly));
+            CHECK(doc.writeTo(&outFile, doc.crLfMode()));
+            CHECK(outData == expected);
+        }
+
+        SECTION("async") {
+            QTemporaryFile tfile;
+            REQUIRE(tfile.open());
+            QFuture<bool> future = doc.writeToAsync(&tfile, doc.crLfMode());
+            // The document can be modified while the save is running.
+            cursor.insertText("changed");
+            future.waitForFinished();
+            CHECK(future.result() == true);
+            REQUIRE(tfile.seek(0));
+            CHECK(tfile.readAll() == expected);
+        }
+
+        SECTION("async crlf") {
+            QByteArray outData;
+            QBuffer outFile(&outData);
+            REQUIRE(outFile.open(QIODevice::WriteOnly));
+            QFuture<bool> future = doc.writeToAsync(&outFile, true);
+            future.waitForFinished();
+            CHECK(future.result() == true);
+            CHECK(outData == expected.replace("\n", "\r\n"));
+        }
+    }
+
     SECTION("text - setText") {
         SECTION("empty") {
             doc.setText(QString());
@@ -2426,3 +2541,207 @@ TEST_CASE("document cross doc") {
         CHECK(recorder1.noMoreEvents());
     }
 }
+
+TEST_CASE("document many line markers") {
+    Testhelper t("unused", "unused", 2, 4);
+    auto textMetrics = t.terminal->textMetrics();
+
+    Tui::ZDocument doc;
+
+    Tui::ZDocumentCursor cursor{&doc, [&textMetrics, &doc](int line, bool /* wrappingAllowed */) {
+            Tui::ZTextLayout lay(textMetrics, doc.line(line));
+            lay.doLayout(65000);
+            return lay;
+        }
+    };
+
+    QStringList text;
+    for (int i = 0; i < 400; i++) {
+        text.append(QString::number(i));
+    }
+    doc.setText(text.join(QStringLiteral("\n")));
+
+    std::mt19937 rng(42);
+
+    std::vector<std::unique_ptr<Tui::ZDocumentLineMarker>> markers;
+    QVector<int> reference;
+    for (int i = 0; i < 1000; i++) {
+        const int line = rng() % doc.lineCount();
+        markers.push_back(std::make_unique<Tui::ZDocumentLineMarker>(&doc, line));
+        reference.append(line);
+    }
+
+    for (int op = 0; op < 500; op++) {
+        const int kind = rng() % 4;
+        if (kind < 2) {
+            const int line = rng() % doc.lineCount();
+            const int codeUnit = rng() % (doc.lineCodeUnits(line) + 1);
+            const QString insert = (kind == 0) ? QStringLiteral("\n") : QStringLiteral("a\n\nb");
+            cursor.setPosition({codeUnit, line});
+            cursor.insertText(insert);
+
+            // replicate the line splits done by insertText
+            const QStringList parts = insert.split(QStringLiteral("\n"));
+            int splitLine = line;
+            int splitCodeUnit = codeUnit + parts.front().size();
+            for (int i = 1; i < parts.size(); i++) {
+                for (int &markerLine: reference) {
+                    if (markerLine > splitLine || (markerLine == splitLine && splitCodeUnit == 0)) {
+                        markerLine++;
+                    }
+                }
+                splitLine++;
+                splitCodeUnit = parts.at(i).size();
+            }
+        } else if (kind == 2 && doc.lineCount() > 1) {
+            const int startLine = rng() % (doc.lineCount() - 1);
+            const int endLine = startLine + 1 + rng() % std::min(doc.lineCount() - startLine - 1, 5);
+            cursor.setPosition({0, startLine});
+            cursor.setPosition({0, endLine}, true);
+            cursor.removeSelectedText();
+
+            for (int &markerLine: reference) {
+                if (markerLine > endLine) {
+                    markerLine -= endLine - startLine;
+                } else if (markerLine > startLine) {
+                    markerLine = startLine;
+                }
+            }
+        } else {
+            const int index = rng() % markers.size();
+            const int line = rng() % doc.lineCount();
+            markers[index]->setLine(line);
+            reference[index] = line;
+        }
+
+        doc.debugConsistencyCheck();
+        for (int i = 0; i < static_cast<int>(markers.size()); i++) {
+            CAPTURE(op);
+            CAPTURE(i);
+            REQUIRE(markers[i]->line() == reference[i]);
+        }
+
+        if (op % 50 == 0) {
+            markers.erase(markers.begin() + op % markers.size());
+            reference.remove(op % reference.size());
+        }
+    }
+
+    // all shifted markers get their change signal
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    EventRecorder recorder;
+    auto lineMarkerChangedSignal = recorder.watchSignal(&doc, RECORDER_SIGNAL(&Tui::ZDocument::lineMarkerChanged));
+
+    cursor.setPosition({0, 0});
+    cursor.insertText("\n");
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+
+    for (const auto &marker: markers) {
+        CHECK(recorder.consumeFirst(lineMarkerChangedSignal, (const Tui::ZDocumentLineMarker*)marker.get()));
+    }
+    CHECK(recorder.noMoreEvents());
+}
+
+TEST_CASE("document many line markers undo") {
+    Testhelper t("unused", "unused", 2, 4);
+    auto textMetrics = t.terminal->textMetrics();
+
+    Tui::ZDocument doc;
+
+    Tui::ZDocumentCursor cursor{&doc, [&textMetrics, &doc](int line, bool /* wrappingAllowed */) {
+            Tui::ZTextLayout lay(textMetrics, doc.line(line));
+            lay.doLayout(65000);
+            return lay;
+        }
+    };
+
+    QStringList text;
+    for (int i = 0; i < 400; i++) {
+        text.append(QString::number(i));
+    }
+    doc.setText(text.join(QStringLiteral("\n")));
+
+    std::mt19937 rng(42);
+
+    std::vector<std::unique_ptr<Tui::ZDocumentLineMarker>> markers;
+    for (int i = 0; i < 1000; i++) {
+        markers.push_back(std::make_unique<Tui::ZDocumentLineMarker>(&doc, rng() % doc.lineCount()));
+    }
+
+    auto markerLines = [&] {
+        QVector<int> lines;
+        for (const auto &marker: markers) {
+            lines.append(marker->line());
+        }
+        return lines;
+    };
+
+    QVector<QVector<int>> history;
+    history.append(markerLines());
+
+    for (int op = 0; op < 100; op++) {
+        const int kind = rng() % 5;
+        if (kind == 0) {
+            const int line = rng() % doc.lineCount();
+            const int codeUnit = rng() % (doc.lineCodeUnits(line) + 1);
+            cursor.setPosition({codeUnit, line});
+            cursor.insertText(QStringLiteral("a\n\nb"));
+        } else if (kind == 1) {
+            const int line = rng() % doc.lineCount();
+            const int codeUnit = rng() % (doc.lineCodeUnits(line) + 1);
+            cursor.setPosition({codeUnit, line});
+            cursor.insertText(QStringLiteral("\n"));
+        } else if (kind == 2 && doc.lineCount() > 1) {
+            const int startLine = rng() % (doc.lineCount() - 1);
+            const int endLine = startLine + 1 + rng() % std::min(doc.lineCount() - startLine - 1, 5);
+            cursor.setPosition({0, startLine});
+            cursor.setPosition({0, endLine}, true);
+            cursor.removeSelectedText();
+        } else if (kind == 3 && doc.lineCount() > 1) {
+            const int line = rng() % (doc.lineCount() - 1);
+            cursor.setPosition({doc.lineCodeUnits(line), line});
+            cursor.deleteCharacter();
+        } else {
+            const int from = rng() % doc.lineCount();
+            const int to = rng() % doc.lineCount();
+            if (from == to) {
+                continue;
+            }
+            doc.moveLine(from, to, &cursor);
+        }
+        doc.clearCollapseUndoStep();
+        doc.debugConsistencyCheck();
+        history.append(markerLines());
+    }
+
+    for (int op = history.size() - 2; op >= 0; op--) {
+        CAPTURE(op);
+        doc.undo(&cursor);
+        doc.debugConsistencyCheck();
+        REQUIRE(markerLines() == history[op]);
+    }
+
+    for (int op = 1; op < history.size(); op++) {
+        CAPTURE(op);
+        doc.redo(&cursor);
+        doc.debugConsistencyCheck();
+        REQUIRE(markerLines() == history[op]);
+    }
+
+    // only markers whose line changed get a change signal
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    EventRecorder recorder;
+    auto lineMarkerChangedSignal = recorder.watchSignal(&doc, RECORDER_SIGNAL(&Tui::ZDocument::lineMarkerChanged));
+
+    const int editLine = doc.lineCount() / 2;
+    cursor.setPosition({0, editLine});
+    cursor.insertText("\n");
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+
+    for (int i = 0; i < static_cast<int>(markers.size()); i++) {
+        if (history.back()[i] >= editLine) {
+            CHECK(recorder.consumeFirst(lineMarkerChangedSignal, (const Tui::ZDocumentLineMarker*)markers[i].get()));
+        }
+    }
+    CHECK(recorder.noMoreEvents());
+}
@@ -2095,3 +2095,200 @@ TEST_CASE("async search") {
     }
 }
 
+
+TEST_CASE("async search parallel") {
+    // Large documents are searched in parallel for needles that can only match within one line.
+    // The results need to be the same as from the sequential search.
+
+    Testhelper t("unused", "unused", 2, 4);
+    auto textMetrics = t.terminal->textMetrics();
+
+    Tui::ZDocument doc;
+
+    Tui::ZDocumentCursor cursor1{&doc, [&textMetrics, &doc](int line, bool /* wrappingAllowed */) {
+            Tui::ZTextLayout lay(textMetrics, doc.line(line));
+            lay.doLayout(65000);
+            return lay;
+        }
+    };
+
+    QString text;
+    for (int i = 0; i < 100000; i++) {
+        if (i % 9973 == 17) {
+            text += QStringLiteral("some Needle and needle here\n");
+        } else {
+            text += QStringLiteral("line ") + QString::number(i) + QStringLiteral("\n");
+        }
+    }
+    doc.setText(text);
+
+    auto check = [&](auto needle, Tui::ZDocument::FindFlags options) {
+        for (int line: {0, 17, 18, 50000, 99990}) {
+            for (int codeUnit: {0, 6}) {
+                CAPTURE(line);
+                CAPTURE(codeUnit);
+                cursor1.setPosition({codeUnit, line});
+                const Tui::ZDocumentCursor expected = doc.findSync(needle, cursor1, options);
+                QFuture<Tui::ZDocumentFindAsyncResult> future = doc.findAsync(needle, cursor1, options);
+                future.waitForFinished();
+                REQUIRE(future.isResultReadyAt(0) == true);
+                Tui::ZDocumentFindAsyncResult result = future.result();
+                if (expected.hasSelection()) {
+                    CHECK(result.anchor() == expected.anchor());
+                    CHECK(result.cursor() == expected.position());
+                } else {
+                    CHECK(result.anchor() == result.cursor());
+                }
+            }
+        }
+    };
+
+    SECTION("literal") {
+        check(QStringLiteral("needle"), Tui::ZDocument::FindFlags{});
+    }
+
+    SECTION("literal case sensitive wrap") {
+        check(QStringLiteral("needle"), Tui::ZDocument::FindFlag::FindCaseSensitively | Tui::ZDocument::FindFlag::FindWrap);
+    }
+
+    SECTION("literal no match") {
+        check(QStringLiteral("not in document"), Tui::ZDocument::FindFlag::FindWrap);
+    }
+
+    SECTION("regex") {
+        check(QRegularExpression(QStringLiteral("n[e]+dle")), Tui::ZDocument::FindFlag::FindWrap);
+    }
+
+    SECTION("regex with line end") {
+        check(QRegularExpression(QStringLiteral("\\w+ here$")), Tui::ZDocument::FindFlags{});
+    }
+}
+
+TEST_CASE("find all") {
+    Testhelper t("unused", "unused", 2, 4);
+    auto textMetrics = t.terminal->textMetrics();
+
+    Tui::ZDocument doc;
+
+    Tui::ZDocumentCursor cursor1{&doc, [&textMetrics, &doc](int line, bool /* wrappingAllowed */) {
+            Tui::ZTextLayout lay(textMetrics, doc.line(line));
+            lay.doLayout(65000);
+            return lay;
+        }
+    };
+
+    auto findAll = [&](auto needle, Tui::ZDocument::FindFlags options, const Tui::ZDocumentMatchIndex &previous) {
+        QFuture<Tui::ZDocumentMatchIndex> future = doc.findAllAsync(needle, options, previous);
+        future.waitForFinished();
+        REQUIRE(future.isResultReadyAt(0) == true);
+        return future.result();
+    };
+
+    auto matchesToVec = [](const QVector<Tui::ZDocumentMatchIndex::Match> &matches) {
+        QVector<QPair<int, int>> ret;
+        for (const auto &match: matches) {
+            ret.append({match.codeUnit, match.length});
+        }
+        return ret;
+    };
+
+    SECTION("literal") {
+        doc.setText("aaa bAb\nnothing\naa");
+        Tui::ZDocumentMatchIndex index = findAll(QStringLiteral("a"), Tui::ZDocument::FindFlags{}, {});
+        CHECK(index.revision() == doc.revision());
+        CHECK(index.lineCount() == 3);
+        CHECK(index.matchCount() == 6);
+        CHECK(index.searchedLineCount() == 3);
+        CHECK(matchesToVec(index.matchesInLine(0)) == QVector<QPair<int, int>>{{0, 1}, {1, 1}, {2, 1}, {5, 1}});
+        CHECK(index.matchesInLine(1).isEmpty());
+        CHECK(matchesToVec(index.matchesInLine(2)) == QVector<QPair<int, int>>{{0, 1}, {1, 1}});
+
+        index = findAll(QStringLiteral("aa"), Tui::ZDocument::FindFlag::FindCaseSensitively, {});
+        CHECK(index.matchCount() == 2);
+        CHECK(matchesToVec(index.matchesInLine(0)) == QVector<QPair<int, int>>{{0, 2}});
+    }
+
+    SECTION("regex") {
+        doc.setText("foo1 foo22\nbar\nfoo");
+        Tui::ZDocumentMatchIndex index = findAll(QRegularExpression("foo\\d*"), Tui::ZDocument::FindFlags{}, {});
+        CHECK(index.matchCount() == 3);
+        CHECK(matchesToVec(index.matchesInLine(0)) == QVector<QPair<int, int>>{{0, 4}, {5, 5}});
+        CHECK(matchesToVec(index.matchesInLine(2)) == QVector<QPair<int, int>>{{0, 3}});
+    }
+
+    SECTION("invalid regex") {
+        doc.setText("foo");
+        Tui::ZDocumentMatchIndex index = findAll(QRegularExpression("("), Tui::ZDocument::FindFlags{}, {});
+        CHECK(index.matchCount() == 0);
+        CHECK(index.lineCount() == 1);
+    }
+
+    SECTION("incremental update") {
+        QString text;
+        for (int i = 0; i < 1000; i++) {
+            text += QStringLiteral("line %1 with match\n").arg(i);
+        }
+        doc.setText(text);
+
+        Tui::ZDocumentMatchIndex index = findAll(QStringLiteral("match"), Tui::ZDocument::FindFlags{}, {});
+        CHECK(index.matchCount() == 1000);
+        CHECK(index.searchedLineCount() == 1000);
+
+        // Unchanged document: nothing needs to be searched.
+        index = findAll(QStringLiteral("match"), Tui::ZDocument::FindFlags{}, index);
+        CHECK(index.matchCount() == 1000);
+        CHECK(index.searchedLineCount() == 0);
+
+        // Edit in one line
+        cursor1.setPosition({0, 500});
+        cursor1.insertText("match ");
+        index = findAll(QStringLiteral("match"), Tui::ZDocument::FindFlags{}, index);
+        CHECK(index.matchCount() == 1001);
+        CHECK(index.searchedLineCount() == 1);
+        CHECK(matchesToVec(index.matchesInLine(500)) == QVector<QPair<int, int>>{{0, 5}, {20, 5}});
+
+        // Inserting lines shifts the following lines
+        cursor1.setPosition({0, 10});
+        cursor1.insertText("new\nlines\n");
+        index = findAll(QStringLiteral("match"), Tui::ZDocument::FindFlags{}, index);
+        CHECK(index.lineCount() == 1002);
+        CHECK(index.matchCount() == 1001);
+        CHECK(index.searchedLineCount() <= 3);
+        CHECK(matchesToVec(index.matchesInLine(502)) == QVector<QPair<int, int>>{{0, 5}, {20, 5}});
+
+        // Edits in distant places only search the edited lines
+        cursor1.setPosition({0, 100});
+        cursor1.insertText("match ");
+        cursor1.setPosition({0, 900});
+        cursor1.insertText("match ");
+        index = findAll(QStringLiteral("match"), Tui::ZDocument::FindFlags{}, index);
+        CHECK(index.lineCount() == 1002);
+        CHECK(index.matchCount() == 1003);
+        CHECK(index.searchedLineCount() == 2);
+        CHECK(matchesToVec(index.matchesInLine(100)) == QVector<QPair<int, int>>{{0, 5}, {19, 5}});
+        CHECK(matchesToVec(index.matchesInLine(900)) == QVector<QPair<int, int>>{{0, 5}, {20, 5}});
+
+        // Removing lines and inserting lines in different places
+        cursor1.setPosition({0, 200});
+        cursor1.setPosition({0, 210}, true);
+        cursor1.removeSelectedText();
+        cursor1.setPosition({0, 800});
+        cursor1.insertText("match\nmatch\n");
+        index = findAll(QStringLiteral("match"), Tui::ZDocument::FindFlags{}, index);
+        CHECK(index.lineCount() == 994);
+        CHECK(index.matchCount() == 995);
+        CHECK(index.searchedLineCount() <= 4);
+
+        Tui::ZDocumentMatchIndex fresh = findAll(QStringLiteral("match"), Tui::ZDocument::FindFlags{}, {});
+        CHECK(fresh.matchCount() == index.matchCount());
+        for (int line = 0; line < fresh.lineCount(); line++) {
+            CAPTURE(line);
+            CHECK(matchesToVec(index.matchesInLine(line)) == matchesToVec(fresh.matchesInLine(line)));
+        }
+
+        // A different needle can not reuse anything
+        index = findAll(QStringLiteral("line"), Tui::ZDocument::FindFlags{}, index);
+        CHECK(index.searchedLineCount() == 994);
+        CHECK(index.matchCount() == 991);
+    }
+}
@@ -365,6 +365,102 @@ TEST_CASE("Document Undo Redo") {
     }
 }
 
+TEST_CASE("Document undo memory budget") {
+    Testhelper t("unused", "unused", 2, 4);
+    auto textMetrics = t.terminal->textMetrics();
+
+    Tui::ZDocument doc;
+
+    Tui::ZDocumentCursor cursor1{&doc, [&textMetrics, &doc](int line, bool /* wrappingAllowed */) {
+            Tui::ZTextLayout lay(textMetrics, doc.line(line));
+            lay.doLayout(65000);
+            return lay;
+        }
+    };
+
+    CHECK(doc.undoMemoryBudget() == 0);
+
+    QString initial;
+    for (int i = 0; i < 10000; i++) {
+        initial += QStringLiteral("line %0\n").arg(i);
+    }
+    loadText(&doc, initial);
+    CHECK(doc.isModified() == false);
+
+    auto edit = [&](int i) {
+        cursor1.setPosition({0, i * 100});
+        cursor1.insertText(QStringLiteral("edit "));
+        doc.clearCollapseUndoStep();
+    };
+
+    SECTION("unlimited") {
+        for (int i = 0; i < 50; i++) {
+            edit(i);
+        }
+        int undoCount = 0;
+        while (doc.isUndoAvailable()) {
+            doc.undo(&cursor1);
+            undoCount++;
+        }
+        CHECK(undoCount == 50);
+        CHECK(doc.text() == initial);
+        CHECK(doc.isModified() == false);
+    }
+
+    SECTION("limited") {
+        doc.setUndoMemoryBudget(20000);
+        CHECK(doc.undoMemoryBudget() == 20000);
+        for (int i = 0; i < 50; i++) {
+            edit(i);
+        }
+        const QString edited = doc.text();
+        CHECK(doc.isModified() == true);
+        int undoCount = 0;
+        while (doc.isUndoAvailable()) {
+            doc.undo(&cursor1);
+            undoCount++;
+        }
+        CHECK(undoCount > 0);
+        CHECK(undoCount < 50);
+        CHECK(doc.text() != initial);
+        // The saved state was discarded, so the document stays modified.
+        CHECK(doc.isModified() == true);
+        for (int i = 0; i < undoCount; i++) {
+            doc.redo(&cursor1);
+        }
+        CHECK(doc.text() == edited);
+    }
+
+    SECTION("typing-in-one-step") {
+        // All keystrokes are collapsed into one step, which replaces the lines of the step every time. Its cost must
+        // not add up the memory of all the replaced versions.
+        doc.setUndoMemoryBudget(200000);
+        edit(0);
+        cursor1.setPosition({0, 5000});
+        for (int i = 0; i < 1000; i++) {
+            cursor1.insertText(QStringLiteral("x"));
+        }
+        int undoCount = 0;
+        while (doc.isUndoAvailable()) {
+            doc.undo(&cursor1);
+            undoCount++;
+        }
+        CHECK(undoCount == 2);
+        CHECK(doc.text() == initial);
+        CHECK(doc.isModified() == false);
+    }
+
+    SECTION("limit-set-later") {
+        for (int i = 0; i < 50; i++) {
+            edit(i);
+        }
+        doc.setUndoMemoryBudget(1);
+        CHECK(doc.isUndoAvailable() == false);
+        edit(0);
+        CHECK(doc.isUndoAvailable() == false);
+    }
+}
+
 TEST_CASE("Document additional cursor adjustments") {
     Testhelper t("unused", "unused", 2, 4);
     auto textMetrics = t.terminal->textMetrics();
@@ -3122,3 +3218,61 @@ TEST_CASE("Document line marker adjustments") {
     }
 }
 
+
+TEST_CASE("Document insert many lines") {
+    Testhelper t("unused", "unused", 2, 4);
+    auto textMetrics = t.terminal->textMetrics();
+
+    Tui::ZDocument doc;
+
+    auto layoutFn = [&textMetrics, &doc](int line, bool /* wrappingAllowed */) {
+        Tui::ZTextLayout lay(textMetrics, doc.line(line));
+        lay.doLayout(65000);
+        return lay;
+    };
+
+    Tui::ZDocumentCursor cursor1{&doc, layoutFn};
+    Tui::ZDocumentCursor cursor2{&doc, layoutFn};
+
+    loadText(&doc, "first line\nsecond line\nthird line\n");
+
+    Tui::ZDocumentLineMarker marker1{&doc, 1};
+    Tui::ZDocumentLineMarker marker2{&doc, 2};
+    cursor2.setPosition({7, 1});
+
+    QStringList pasted;
+    for (int i = 0; i < 100000; i++) {
+        pasted.append(QStringLiteral("pasted %1").arg(i));
+    }
+
+    cursor1.setPosition({3, 1});
+    cursor1.insertText(pasted.join(QStringLiteral("\n")));
+
+    CHECK(doc.lineCount() == 3 + 99999);
+    CHECK(doc.line(0) == "first line");
+    CHECK(doc.line(1) == "secpasted 0");
+    CHECK(doc.line(2) == "pasted 1");
+    CHECK(doc.line(100000) == "pasted 99999ond line");
+    CHECK(doc.line(100001) == "third line");
+    CHECK(cursor1.position() == Tui::ZDocumentCursor::Position{12, 100000});
+    CHECK(cursor2.position() == Tui::ZDocumentCursor::Position{16, 100000});
+    CHECK(marker1.line() == 1);
+    CHECK(marker2.line() == 100001);
+
+    doc.undo(&cursor1);
+
+    CHECK(docToVec(doc) == QVector<QString>{"first line", "second line", "third line"});
+    CHECK(cursor1.position() == Tui::ZDocumentCursor::Position{3, 1});
+    CHECK(cursor2.position() == Tui::ZDocumentCursor::Position{7, 1});
+    CHECK(marker1.line() == 1);
+    CHECK(marker2.line() == 2);
+
+    doc.redo(&cursor1);
+
+    CHECK(doc.lineCount() == 3 + 99999);
+    CHECK(doc.line(100000) == "pasted 99999ond line");
+    CHECK(cursor1.position() == Tui::ZDocumentCursor::Position{12, 100000});
+    CHECK(cursor2.position() == Tui::ZDocumentCursor::Position{16, 100000});
+    CHECK(marker1.line() == 1);
+    CHECK(marker2.line() == 100001);
+}
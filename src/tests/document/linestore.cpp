@@ -0,0 +1,386 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "../catchwrapper.h"
+
+#include <random>
+
+#include "Tui/ZDocumentLineStore_p.h"
+
+static QVector<QString> storeToVec(const Tui::LineStore &store) {
+    QVector<QString> ret;
+    for (int i = 0; i < store.size(); i++) {
+        ret.append(store[i].chars);
+    }
+    return ret;
+}
+
+TEST_CASE("linestore-basic") {
+    Tui::LineStore store;
+    CHECK(store.size() == 0);
+    CHECK(store.isEmpty());
+
+    store.append({QStringLiteral("a"), 0, nullptr});
+    store.append({QStringLiteral("c"), 0, nullptr});
+    store.insert(1, {QStringLiteral("b"), 0, nullptr});
+    CHECK(storeToVec(store) == QVector<QString>{"a", "b", "c"});
+    CHECK(store.last().chars == "c");
+
+    store.modify(1).chars = QStringLiteral("B");
+    CHECK(storeToVec(store) == QVector<QString>{"a", "B", "c"});
+
+    store.remove(0);
+    CHECK(storeToVec(store) == QVector<QString>{"B", "c"});
+    store.removeLast();
+    CHECK(storeToVec(store) == QVector<QString>{"B"});
+    store.clear();
+    CHECK(store.isEmpty());
+}
+
+TEST_CASE("linestore-copies-are-independent") {
+    Tui::LineStore store;
+    for (int i = 0; i < 10000; i++) {
+        store.append({QString::number(i), 0, nullptr});
+    }
+
+    Tui::LineStore copy = store;
+
+    store.modify(5000).chars = QStringLiteral("changed");
+    store.insert(10, {QStringLiteral("new"), 0, nullptr});
+    store.remove(100, 5000);
+
+    store.debugConsistencyCheck();
+    copy.debugConsistencyCheck();
+
+    CHECK(copy.size() == 10000);
+    for (int i = 0; i < copy.size(); i++) {
+        REQUIRE(copy[i].chars == QString::number(i));
+    }
+    CHECK(store.size() == 5001);
+    CHECK(store[10].chars == "new");
+}
+
+TEST_CASE("linestore-random") {
+    std::mt19937 rng(42);
+    Tui::LineStore store;
+    QVector<QString> reference;
+
+    for (int op = 0; op < 20000; op++) {
+        const int kind = rng() % 8;
+        if (kind < 4 || reference.isEmpty()) {
+            const int index = rng() % (reference.size() + 1);
+            const QString text = QString::number(op);
+            store.insert(index, {text, 0, nullptr});
+            reference.insert(index, text);
+        } else if (kind < 6) {
+            const int index = rng() % reference.size();
+            const int maxCount = std::min(reference.size() - index, (rng() % 8 == 0) ? 3000 : 4);
+            const int count = 1 + rng() % maxCount;
+            store.remove(index, count);
+            reference.remove(index, count);
+        } else {
+            const int index = rng() % reference.size();
+            store.modify(index).chars += QStringLiteral("x");
+            reference[index] += QStringLiteral("x");
+        }
+        store.debugConsistencyCheck();
+        REQUIRE(store.size() == reference.size());
+    }
+
+    CHECK(storeToVec(store) == reference);
+}
+
+TEST_CASE("linestore-insert-range") {
+    std::mt19937 rng(42);
+    Tui::LineStore store;
+    QVector<QString> reference;
+
+    int counter = 0;
+    for (int op = 0; op < 300; op++) {
+        CAPTURE(op);
+        const int sizes[] = {0, 1, 2, 63, 64, 65, 1000, 5000};
+        const int count = (op % 3 == 0) ? sizes[rng() % 8] : static_cast<int>(rng() % 10);
+        const int index = rng() % (reference.size() + 1);
+
+        QVector<Tui::LineData> lines;
+        QVector<QString> referenceLines;
+        for (int i = 0; i < count; i++) {
+            const QString text = QString::number(counter++);
+            lines.append({text, 0, nullptr});
+            referenceLines.append(text);
+        }
+
+        Tui::LineStore copy = store;
+        store.insert(index, lines);
+        reference = reference.mid(0, index) + referenceLines + reference.mid(index);
+
+        store.debugConsistencyCheck();
+        copy.debugConsistencyCheck();
+        REQUIRE(store.size() == reference.size());
+        REQUIRE(copy.size() == reference.size() - count);
+
+        if (op % 4 == 0 && reference.size() > 1000) {
+            const int removeIndex = rng() % (reference.size() - 500);
+            store.remove(removeIndex, 500);
+            reference.remove(removeIndex, 500);
+            store.debugConsistencyCheck();
+        }
+    }
+
+    CHECK(storeToVec(store) == reference);
+
+    Tui::LineStore empty;
+    QVector<Tui::LineData> lines;
+    for (int i = 0; i < 100000; i++) {
+        lines.append({QString::number(i), 0, nullptr});
+    }
+    empty.insert(0, lines);
+    empty.debugConsistencyCheck();
+    CHECK(empty.size() == 100000);
+    CHECK(empty[99999].chars == "99999");
+}
+
+TEST_CASE("linestore-build") {
+    for (int size: {0, 1, 63, 64, 65, 80, 64 * 32, 64 * 32 + 1, 100000}) {
+        CAPTURE(size);
+        QVector<QVector<Tui::LineData>> chunks;
+        QVector<QString> reference;
+        for (int i = 0; i < size; i++) {
+            if (chunks.isEmpty() || i % 777 == 0) {
+                chunks.append(QVector<Tui::LineData>());
+            }
+            chunks.last().append({QString::number(i), 0, nullptr});
+            reference.append(QString::number(i));
+        }
+
+        Tui::LineStore store = Tui::LineStore::build(chunks);
+        store.debugConsistencyCheck();
+        CHECK(store.size() == size);
+        CHECK(storeToVec(store) == reference);
+
+        store.insert(0, {QStringLiteral("new"), 0, nullptr});
+        store.debugConsistencyCheck();
+        CHECK(store.size() == size + 1);
+    }
+}
+
+TEST_CASE("linestore-common-prefix-and-suffix") {
+    auto sameLine = [](const Tui::LineData &a, const Tui::LineData &b) {
+        return a.revision == b.revision && a.chars.isSharedWith(b.chars);
+    };
+
+    auto check = [&](const Tui::LineStore &a, const Tui::LineStore &b) {
+        const int limit = std::min(a.size(), b.size());
+        int expectedPrefix = 0;
+        while (expectedPrefix < limit && sameLine(a[expectedPrefix], b[expectedPrefix])) {
+            expectedPrefix++;
+        }
+        int expectedSuffix = 0;
+        while (expectedSuffix < limit - expectedPrefix
+               && sameLine(a[a.size() - 1 - expectedSuffix], b[b.size() - 1 - expectedSuffix])) {
+            expectedSuffix++;
+        }
+
+        int prefix = -1;
+        int suffix = -1;
+        Tui::LineStore::commonPrefixAndSuffix(a, b, &prefix, &suffix);
+        CHECK(prefix == expectedPrefix);
+        CHECK(suffix == expectedSuffix);
+    };
+
+    QVector<QVector<Tui::LineData>> chunks = {{}};
+    for (int i = 0; i < 100000; i++) {
+        chunks.last().append({QString::number(i), 0, nullptr});
+    }
+    const Tui::LineStore original = Tui::LineStore::build(chunks);
+
+    SECTION("empty") {
+        check(Tui::LineStore(), Tui::LineStore());
+        check(Tui::LineStore(), original);
+        check(original, Tui::LineStore());
+    }
+
+    SECTION("identical") {
+        check(original, original);
+    }
+
+    SECTION("modify") {
+        Tui::LineStore store = original;
+        store.modify(5000).chars = QStringLiteral("changed");
+        check(original, store);
+        int prefix = -1;
+        int suffix = -1;
+        Tui::LineStore::commonPrefixAndSuffix(original, store, &prefix, &suffix);
+        CHECK(prefix == 5000);
+        CHECK(suffix == 100000 - 5001);
+    }
+
+    SECTION("insert") {
+        Tui::LineStore store = original;
+        store.insert(5000, {QStringLiteral("new"), 1, nullptr});
+        check(original, store);
+        check(store, original);
+    }
+
+    SECTION("independent stores") {
+        check(original, Tui::LineStore::build(chunks));
+    }
+
+    SECTION("random") {
+        std::mt19937 rng(42);
+        Tui::LineStore previous = original;
+        for (int step = 0; step < 300; step++) {
+            CAPTURE(step);
+            Tui::LineStore store = previous;
+            const int edits = 1 + rng() % 3;
+            for (int i = 0; i < edits; i++) {
+                const int kind = rng() % 3;
+                if (kind == 0 || store.isEmpty()) {
+                    const int index = rng() % (store.size() + 1);
+                    store.insert(index, {QStringLiteral("new"), static_cast<unsigned>(step + 1), nullptr});
+                } else if (kind == 1) {
+                    const int index = rng() % store.size();
+                    const int count = 1 + rng() % std::min(store.size() - index, (rng() % 8 == 0) ? 3000 : 4);
+                    store.remove(index, count);
+                } else {
+                    const int index = rng() % store.size();
+                    Tui::LineData &line = store.modify(index);
+                    line.chars += QStringLiteral("x");
+                    line.revision = step + 1;
+                }
+            }
+            check(previous, store);
+            previous = store;
+        }
+    }
+}
+
+TEST_CASE("linestore-differences") {
+    auto sameLine = [](const Tui::LineData &a, const Tui::LineData &b) {
+        return a.revision == b.revision && a.chars.isSharedWith(b.chars);
+    };
+
+    // The differences have to be ordered, and all lines outside of them have to be identical.
+    auto check = [&](const Tui::LineStore &a, const Tui::LineStore &b) {
+        const QVector<Tui::LineStore::Difference> differences = Tui::LineStore::differences(a, b);
+        int posA = 0;
+        int posB = 0;
+        int changedLines = 0;
+        for (const Tui::LineStore::Difference &difference: differences) {
+            REQUIRE(difference.startA >= posA);
+            REQUIRE(difference.startB >= posB);
+            REQUIRE(difference.startA - posA == difference.startB - posB);
+            for (int i = 0; i < difference.startA - posA; i++) {
+                REQUIRE(sameLine(a[posA + i], b[posB + i]));
+            }
+            posA = difference.startA + difference.countA;
+            posB = difference.startB + difference.countB;
+            changedLines += difference.countA + difference.countB;
+        }
+        REQUIRE(posA <= a.size());
+        REQUIRE(a.size() - posA == b.size() - posB);
+        for (int i = 0; i < a.size() - posA; i++) {
+            REQUIRE(sameLine(a[posA + i], b[posB + i]));
+        }
+        return changedLines;
+    };
+
+    QVector<QVector<Tui::LineData>> chunks = {{}};
+    for (int i = 0; i < 100000; i++) {
+        chunks.last().append({QString::number(i), 0, nullptr});
+    }
+    const Tui::LineStore original = Tui::LineStore::build(chunks);
+
+    SECTION("empty") {
+        CHECK(Tui::LineStore::differences(Tui::LineStore(), Tui::LineStore()).isEmpty());
+        check(Tui::LineStore(), original);
+        check(original, Tui::LineStore());
+    }
+
+    SECTION("identical") {
+        CHECK(Tui::LineStore::differences(original, original).isEmpty());
+    }
+
+    SECTION("distant modifications") {
+        Tui::LineStore store = original;
+        store.modify(100).chars = QStringLiteral("changed");
+        store.insert(50000, {QStringLiteral("new"), 1, nullptr});
+        store.remove(90000, 3);
+        const int changedLines = check(original, store);
+        // Only the modified leaves are reported, not the lines between the modifications.
+        CHECK(Tui::LineStore::differences(original, store).size() == 3);
+        CHECK(changedLines < 1000);
+    }
+
+    SECTION("independent stores") {
+        check(original, Tui::LineStore::build(chunks));
+    }
+
+    SECTION("random") {
+        std::mt19937 rng(42);
+        Tui::LineStore previous = original;
+        for (int step = 0; step < 300; step++) {
+            CAPTURE(step);
+            Tui::LineStore store = previous;
+            const int edits = 1 + rng() % 5;
+            for (int i = 0; i < edits; i++) {
+                const int kind = rng() % 4;
+                if (kind == 0 || store.isEmpty()) {
+                    const int index = rng() % (store.size() + 1);
+                    store.insert(index, {QStringLiteral("new"), static_cast<unsigned>(step + 1), nullptr});
+                } else if (kind == 1) {
+                    const int index = rng() % (store.size() + 1);
+                    QVector<Tui::LineData> lines;
+                    for (int j = 0; j < static_cast<int>(rng() % 200); j++) {
+                        lines.append({QStringLiteral("range"), static_cast<unsigned>(step + 1), nullptr});
+                    }
+                    store.insert(index, lines);
+                } else if (kind == 2) {
+                    const int index = rng() % store.size();
+                    const int count = 1 + rng() % std::min(store.size() - index, (rng() % 8 == 0) ? 3000 : 4);
+                    store.remove(index, count);
+                } else {
+                    const int index = rng() % store.size();
+                    Tui::LineData &line = store.modify(index);
+                    line.chars += QStringLiteral("x");
+                    line.revision = step + 1;
+                }
+            }
+            check(previous, store);
+            previous = store;
+        }
+    }
+}
+
+TEST_CASE("linestore-unshared-bytes") {
+    QVector<QVector<Tui::LineData>> chunks = {{}};
+    for (int i = 0; i < 100000; i++) {
+        chunks.last().append({QString::number(i), 0, nullptr});
+    }
+    const Tui::LineStore original = Tui::LineStore::build(chunks);
+
+    CHECK(Tui::LineStore::unsharedBytes(original, original) == 0);
+    CHECK(Tui::LineStore::unsharedBytes(Tui::LineStore(), original) == 0);
+    CHECK(Tui::LineStore::unsharedBytes(Tui::LineStore::build(chunks), original)
+          > 100000 * static_cast<qint64>(sizeof(Tui::LineData)));
+
+    SECTION("repeated modification of one line") {
+        // Like typing into a line, the cost must only grow with the text and not with the number of modifications.
+        Tui::LineStore store = original;
+        for (int i = 0; i < 2000; i++) {
+            // Kept like the undo step of the previous keystroke, so each modification copies the path to the line.
+            const Tui::LineStore previous = store;
+            store.modify(5000).chars += QStringLiteral("x");
+            CAPTURE(i);
+            REQUIRE(Tui::LineStore::unsharedBytes(store, original) < 20000);
+        }
+        CHECK(Tui::LineStore::unsharedBytes(store, original) > 2000 * static_cast<qint64>(sizeof(QChar)));
+    }
+
+    SECTION("insert") {
+        Tui::LineStore store = original;
+        store.insert(5000, {QStringLiteral("new line"), 1, nullptr});
+        const qint64 cost = Tui::LineStore::unsharedBytes(store, original);
+        CHECK(cost > 0);
+        CHECK(cost < 20000);
+    }
+}
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: BSL-1.0
 
+#include <Tui/ZTest.h>
 #include <Tui/ZVBoxLayout.h>
 
 #include "catchwrapper.h"
@@ -400,3 +401,45 @@ TEST_CASE("layout generation wraparound brute force no layout", "[.layoutgenwrap
     }
     CHECK(nextGen > 0);
 }
+
+TEST_CASE("layoutinvalidation-unchanged-subtrees", "") {
+    Testhelper t("unused", "unused", 80, 50);
+    TestBackground *w = new TestBackground(t.root);
+    w->setGeometry({0, 0, 80, 50});
+
+    t.terminal->doLayout(); // reset pending
+
+    Tui::ZWidget outer(w);
+    auto *layout = new Tui::ZVBoxLayout();
+    for (int i = 0; i < 3; i++) {
+        auto *container = new Tui::ZWidget(&outer);
+        container->setSizePolicyV(Tui::SizePolicy::Fixed);
+        SimpleLayout sl(container);
+        container->setLayout(sl.layout);
+        layout->addWidget(container);
+    }
+    outer.setLayout(layout);
+    outer.setGeometry({1, 1, 78, 20});
+    t.terminal->doLayout();
+
+    Tui::ZTest::withLayoutRequestTracking(t.terminal.get(), [&](QSet<Tui::ZWidget*> *layoutRequested,
+                                                                 const Tui::ZTest::LayoutPassCounters *counters) {
+        // the containers keep their geometry, so only outer needs to be layouted
+        outer.setGeometry({1, 1, 78, 30});
+        CHECK(layoutRequested->contains(&outer));
+        t.terminal->doLayout();
+        CHECK(counters->widgetsVisited == 1);
+        CHECK(counters->widgetsRelayouted == 1);
+
+        // all containers change width
+        outer.setGeometry({1, 1, 60, 30});
+        t.terminal->doLayout();
+        CHECK(counters->widgetsVisited == 4);
+        CHECK(counters->widgetsRelayouted == 4);
+
+        // nothing pending
+        t.terminal->doLayout();
+        CHECK(counters->widgetsVisited == 0);
+        CHECK(counters->widgetsRelayouted == 0);
+    });
+}
@@ -392,3 +392,126 @@ TEST_CASE("metrics - sizeInXXX") {
     CHECK(sizeInClustersWrapper(kind, tm3, testCase.text) == testCase.clusters);
 }
 
+
+TEST_CASE("metrics - measureClusters") {
+    struct TestCase { QString text; QVector<int> columns; QVector<QString> clusters; };
+    const auto testCase = GENERATE(
+                TestCase{ "test", {1, 1, 1, 1}, {"t", "e", "s", "t"} },
+                TestCase{ "はい", {2, 2}, {"は", "い"} },
+                TestCase{ "😇bc", {2, 1, 1}, {"😇", "b", "c"} },
+                TestCase{ "a\xcc\x88\xcc\xa4\x62\x63", {1, 1, 1}, {"a\xcc\x88\xcc\xa4", "b", "c"} },
+                TestCase{ "\n😇", {1, 2}, {"\n", "😇"} },
+                TestCase{ "", {}, {} }
+    );
+
+    CAPTURE(testCase.text.toStdString());
+
+    TermpaintFixture f;
+
+    Tui::ZTextMetrics tm = Tui::ZTextMetricsPrivate::createForTesting(f.surface);
+
+    auto check = [&](const QVector<Tui::ZTextMetrics::ClusterSize> &result, Kind kind) {
+        CAPTURE(kind);
+        REQUIRE(result.size() == testCase.clusters.size());
+        for (int i = 0; i < result.size(); i++) {
+            CAPTURE(i);
+            CHECK(result[i].columns == testCase.columns[i]);
+            CHECK(result[i].codeUnits == nCodeUnits(kind, testCase.clusters[i]));
+            CHECK(result[i].codePoints == nCodePoints(testCase.clusters[i]));
+        }
+    };
+
+    check(tm.measureClusters(testCase.text), KindQString);
+    check(tm.measureClusters(testCase.text.data(), testCase.text.size()), KindQChar);
+    check(tm.measureClusters(reinterpret_cast<const char16_t*>(testCase.text.data()), testCase.text.size()), KindChar16);
+    auto utf32 = testCase.text.toUcs4();
+    check(tm.measureClusters(reinterpret_cast<const char32_t*>(utf32.data()), utf32.size()), KindChar32);
+    QByteArray utf8 = testCase.text.toUtf8();
+    check(tm.measureClusters(utf8.data(), utf8.size()), KindUtf);
+}
+
+TEST_CASE("metrics - reuse of measurement") {
+    // Limits set for one kind of measurement must not leak into the next one.
+    TermpaintFixture f;
+
+    Tui::ZTextMetrics tm = Tui::ZTextMetricsPrivate::createForTesting(f.surface);
+
+    for (int i = 0; i < 3; i++) {
+        CHECK(tm.nextCluster(QString("はい"), 0).columns == 2);
+        CHECK(tm.sizeInColumns(QString("はいはい")) == 8);
+        CHECK(tm.splitByColumns(QString("はいはい"), 5).columns == 4);
+        CHECK(tm.sizeInClusters(QString("はいはい")) == 4);
+        CHECK(tm.measureClusters(QString("abc")).size() == 3);
+        CHECK(tm.sizeInColumns(QString("abcdef")) == 6);
+    }
+}
+
+TEST_CASE("metrics - printableAsciiPrefix") {
+    struct TestCase { QString text; int prefix; int singleColumn; };
+    const auto testCase = GENERATE(
+                TestCase{ "", 0, 0 },
+                TestCase{ "test", 4, 4 },
+                TestCase{ "test\n", 4, 4 },
+                TestCase{ "a\xcc\x88", 1, 0 },
+                TestCase{ "\tTab", 0, 0 },
+                TestCase{ "abcdefghijklmnopqrstuvwxyz0123456789", 36, 36 },
+                TestCase{ "abcdefghijklmnopqrstuvwxyz012345678\x7f", 35, 35 },
+                TestCase{ "abcdefghijklmnopqrstuvwxyz0123456789\xcc\x88", 36, 35 },
+                TestCase{ "abcdefghijklmnopqrstuvwxyz0123456789はい", 36, 35 },
+                TestCase{ "abcdefghijklmnop~ ", 18, 18 }
+    );
+
+    CAPTURE(testCase.text.toStdString());
+
+    const char16_t *utf16 = reinterpret_cast<const char16_t*>(testCase.text.constData());
+    CHECK(Tui::printableAsciiPrefix(utf16, testCase.text.size()) == testCase.prefix);
+    CHECK(Tui::singleColumnPrefix(utf16, testCase.text.size()) == testCase.singleColumn);
+    auto utf32 = testCase.text.toUcs4();
+    const char32_t *utf32Data = reinterpret_cast<const char32_t*>(utf32.constData());
+    CHECK(Tui::printableAsciiPrefix(utf32Data, utf32.size()) == testCase.prefix);
+    CHECK(Tui::singleColumnPrefix(utf32Data, utf32.size()) == testCase.singleColumn);
+    QByteArray utf8 = testCase.text.toUtf8();
+    CHECK(Tui::printableAsciiPrefix(utf8.constData(), utf8.size()) == testCase.prefix);
+    CHECK(Tui::singleColumnPrefix(utf8.constData(), utf8.size()) == testCase.singleColumn);
+}
+
+TEST_CASE("metrics - ascii followed by other text") {
+    // Long runs of ascii are measured without termpaint, the result has to match for what follows them.
+    auto kind = GENERATE(ALLKINDS);
+    const QString ascii = QStringLiteral("abcdefghijklmnopqrstuvwxyz0123456789");
+
+    CAPTURE(kind);
+
+    TermpaintFixture f;
+
+    Tui::ZTextMetrics tm = Tui::ZTextMetricsPrivate::createForTesting(f.surface);
+
+    const QString combining = ascii + "\xcc\x88\xcc\xa4" + ascii;
+    CHECK(sizeInColumnsWrapper(kind, tm, combining) == 72);
+    CHECK(sizeInClustersWrapper(kind, tm, combining) == 72);
+    Tui::ZTextMetrics::ClusterSize result = splitByColumnsWrapper(kind, tm, combining, 36);
+    CHECK(result.columns == 36);
+    CHECK(result.codeUnits == nCodeUnits(kind, ascii + "\xcc\x88\xcc\xa4"));
+    CHECK(result.codePoints == 38);
+    result = splitByColumnsWrapper(kind, tm, combining, 35);
+    CHECK(result.columns == 35);
+    CHECK(result.codeUnits == 35);
+    CHECK(result.codePoints == 35);
+
+    const QString wide = ascii + "はい" + ascii;
+    CHECK(sizeInColumnsWrapper(kind, tm, wide) == 76);
+    CHECK(sizeInClustersWrapper(kind, tm, wide) == 74);
+    result = splitByColumnsWrapper(kind, tm, wide, 37);
+    CHECK(result.columns == 36);
+    CHECK(result.codePoints == 36);
+    result = splitByColumnsWrapper(kind, tm, wide, 40);
+    CHECK(result.columns == 40);
+    CHECK(result.codePoints == 38);
+    CHECK(result.codeUnits == nCodeUnits(kind, ascii + "はい"));
+
+    const QString control = ascii + "\t" + ascii;
+    CHECK(sizeInColumnsWrapper(kind, tm, control) == 73);
+    result = splitByColumnsWrapper(kind, tm, control, 37);
+    CHECK(result.columns == 37);
+    CHECK(result.codeUnits == 37);
+}
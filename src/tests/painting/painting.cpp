@@ -390,6 +390,83 @@ TEST_CASE("ZPainter: text with attributes") {
 
 }
 
+TEST_CASE("ZPainter: text encoding") {
+    auto kind = GENERATE(ALLKINDS);
+    CAPTURE(kind);
+
+    TermpaintFixtureImg f{80, 6, false};
+    termpaint_surface_clear(f.surface, TERMPAINT_DEFAULT_COLOR, TERMPAINT_DEFAULT_COLOR);
+
+    Tui::ZPainter painter = f.testPainter();
+
+    writeWithColorsWrapper(kind, painter, 10, 1, "a\u00e9\u20ac\U0001F95Ab",
+                           Tui::ZColor::defaultColor(), Tui::ZColor::defaultColor());
+    // unpaired surrogates are replaced like in QString::toUtf8
+    writeWithColorsWrapper(kind, painter, 10, 2, QStringLiteral("x") + QChar(0xd800) + QStringLiteral("y") + QChar(0xdc00),
+                           Tui::ZColor::defaultColor(), Tui::ZColor::defaultColor());
+    // longer than the preallocated conversion buffer
+    writeWithColorsWrapper(kind, painter, 0, 3, QString(300, QChar(0x20ac)),
+                           Tui::ZColor::defaultColor(), Tui::ZColor::defaultColor());
+
+    std::map<std::tuple<int, int>, Cell> expected = {
+        {{ 10, 1 }, singleWideChar("a")},
+        {{ 11, 1 }, singleWideChar("\u00e9")},
+        {{ 12, 1 }, singleWideChar("\u20ac")},
+        {{ 13, 1 }, doubleWideChar("\U0001F95A")},
+        {{ 15, 1 }, singleWideChar("b")},
+        {{ 10, 2 }, singleWideChar("x")},
+        {{ 11, 2 }, singleWideChar("?")},
+        {{ 12, 2 }, singleWideChar("y")},
+        {{ 13, 2 }, singleWideChar("?")},
+    };
+    for (int x = 0; x < 80; x++) {
+        expected[{x, 3}] = singleWideChar("\u20ac");
+    }
+    checkEmptyPlusSome(f.surface, expected);
+}
+
+TEST_CASE("ZPainter: attribute cache") {
+    TermpaintFixtureImg f{80, 6, false};
+
+    Tui::ZPainter painter = f.testPainter();
+
+    Tui::ZPainterPrivate *const p = Tui::ZPainterPrivate::get(&painter);
+    termpaint_attr *attr = p->termpaintAttr(Tui::TerminalColor::red, Tui::TerminalColor::black,
+                                            Tui::ZTextAttribute::Bold);
+    CHECK(p->termpaintAttr(Tui::TerminalColor::red, Tui::TerminalColor::black, Tui::ZTextAttribute::Bold) == attr);
+    CHECK(p->attributeCache->size() == 1);
+    p->termpaintAttr(Tui::TerminalColor::red, Tui::TerminalColor::black, Tui::ZTextAttribute::Italic);
+    p->termpaintAttr(Tui::TerminalColor::red, Tui::TerminalColor::blue, Tui::ZTextAttribute::Bold);
+    CHECK(p->attributeCache->size() == 3);
+
+    // copies made after first use share the cache
+    Tui::ZPainter clipped = painter.translateAndClip(1, 1, 10, 3);
+    CHECK(Tui::ZPainterPrivate::get(&clipped)->attributeCache == p->attributeCache);
+
+    clipped.writeWithAttributes(0, 0, QStringLiteral("Sample"), Tui::TerminalColor::red, Tui::TerminalColor::black,
+                                 Tui::ZTextAttribute::Bold);
+    clipped.clearRect(0, 1, 3, 1, Tui::TerminalColor::red, Tui::TerminalColor::black, Tui::ZTextAttribute::Italic);
+    CHECK(p->attributeCache->size() == 3);
+
+    checkEmptyPlusSome(f.surface, {
+        {{ 1, 1 }, singleWideChar("S").withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_BOLD)},
+        {{ 2, 1 }, singleWideChar("a").withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_BOLD)},
+        {{ 3, 1 }, singleWideChar("m").withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_BOLD)},
+        {{ 4, 1 }, singleWideChar("p").withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_BOLD)},
+        {{ 5, 1 }, singleWideChar("l").withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_BOLD)},
+        {{ 6, 1 }, singleWideChar("e").withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_BOLD)},
+        {{ 1, 2 }, singleWideChar(TERMPAINT_ERASED).withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_ITALIC)},
+        {{ 2, 2 }, singleWideChar(TERMPAINT_ERASED).withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_ITALIC)},
+        {{ 3, 2 }, singleWideChar(TERMPAINT_ERASED).withFg(TERMPAINT_COLOR_RED).withBg(TERMPAINT_COLOR_BLACK).withStyle(TERMPAINT_STYLE_ITALIC)},
+    });
+
+    // the cache is bounded
+    for (int i = 0; i < 2000; i++) {
+        p->termpaintAttr(Tui::ZColor(i % 256, i / 256, 0), Tui::TerminalColor::black, {});
+    }
+    CHECK(p->attributeCache->size() <= 1024);
+}
+
 TEST_CASE("ZPainter: clear") {
     bool useImage = GENERATE(false, true);
     CAPTURE(useImage);
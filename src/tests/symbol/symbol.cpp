@@ -2,6 +2,8 @@
 
 #include <Tui/ZSymbol.h>
 
+#include <QVector>
+
 #include "../catchwrapper.h"
 #include "../Testhelper.h"
 
@@ -76,6 +78,21 @@ TEST_CASE("symbol-base") {
         CHECK(c1 == c2);
         CHECK(c1.toString() == c2.toString());
     }
+
+    SECTION("many") {
+        // enough symbols to need multiple table resizes
+        QVector<Tui::ZSymbol> symbols;
+        for (int i = 0; i < 5000; i++) {
+            symbols.append(Tui::ZSymbol(QStringLiteral("symbol-test-many-%0").arg(i)));
+        }
+        for (int i = 0; i < 5000; i++) {
+            CAPTURE(i);
+            CHECK(symbols[i].toString() == QStringLiteral("symbol-test-many-%0").arg(i));
+            CHECK(symbols[i] == Tui::ZSymbol(QStringLiteral("symbol-test-many-%0").arg(i)));
+        }
+        CHECK(symbols[1234] == TUISYM_LITERAL("symbol-test-many-1234"));
+        CHECK(symbols[1234] == Tui::ZImplicitSymbol("symbol-test-many-1234"));
+    }
 }
 
 void implicitTest(Tui::ZImplicitSymbol s) {
@@ -171,4 +188,11 @@ TEST_CASE("implicit-symbol-base") {
         implicitTest("text");
         implicitTest(QString("text"));
     }
+
+    SECTION("literal-and-string") {
+        const char buffer[16] = "literal-test";
+        CHECK(Tui::ZImplicitSymbol(buffer) == Tui::ZSymbol(QStringLiteral("literal-test")));
+        CHECK(Tui::ZImplicitSymbol(buffer).toString() == "literal-test");
+        CHECK(Tui::ZImplicitSymbol("literal-test-ä") == Tui::ZSymbol(QStringLiteral("literal-test-ä")));
+    }
 }
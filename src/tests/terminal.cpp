@@ -2,6 +2,8 @@
 
 #include <Tui/ZTerminal.h>
 
+#include <numeric>
+
 #include <QCoreApplication>
 #include <QTimer>
 #include <QSet>
@@ -141,6 +143,29 @@ class PasteEventAcceptingWidget : public Tui::ZWidget {
     }
 };
 
+class PasteChunkAcceptingWidget : public Tui::ZWidget {
+public:
+    using Tui::ZWidget::ZWidget;
+
+    struct Chunk {
+        QString text;
+        bool initial;
+        bool final;
+    };
+
+    bool event(QEvent *event) override {
+        if (event->type() == Tui::ZEventType::pasteChunk()) {
+            auto *pasteEvent = static_cast<Tui::ZPasteEvent*>(event);
+            chunks.append({pasteEvent->text(), pasteEvent->isInitialChunk(), pasteEvent->isFinalChunk()});
+            event->accept();
+            return true;
+        }
+        return Tui::ZWidget::event(event);
+    }
+
+    QVector<Chunk> chunks;
+};
+
 bool waitForRenderingCycle(Tui::ZTerminal *terminal, int timeout) {
     QDeadlineTimer timer{timeout};
 
@@ -261,6 +286,115 @@ TEST_CASE("terminal-paint-cycle", "") {
     CHECK(recorder.noMoreEvents());
 }
 
+TEST_CASE("terminal-render-statistics", "") {
+
+    static char prgname[] = "test";
+    static char *argv[] = {prgname, nullptr};
+    int argc = 1;
+    QCoreApplication app(argc, argv);
+
+    Tui::ZTerminal terminal{Tui::ZTerminal::OffScreen(20, 10)};
+
+    {
+        const Tui::ZTerminal::RenderStatistics stats = terminal.renderStatistics();
+        CHECK(stats.frameCount() == 0);
+        CHECK(stats.frameTimeHistogram() == QVector<int>(11, 0));
+    }
+
+    CHECK(Tui::ZTerminal::RenderStatistics::frameTimeHistogramBucketLimit(0) == 250000);
+    CHECK(Tui::ZTerminal::RenderStatistics::frameTimeHistogramBucketLimit(1) == 500000);
+    CHECK(Tui::ZTerminal::RenderStatistics::frameTimeHistogramBucketLimit(9) == 128000000);
+    CHECK(Tui::ZTerminal::RenderStatistics::frameTimeHistogramBucketLimit(10) == -1);
+
+    PaintWidget widget;
+    PaintWidget child(&widget);
+    child.setGeometry({0, 0, 5, 5});
+    terminal.setMainWidget(&widget);
+    REQUIRE(waitForRenderingCycle(&terminal, 1000));
+
+    terminal.forceRepaint();
+
+    {
+        const Tui::ZTerminal::RenderStatistics stats = terminal.renderStatistics();
+        CHECK(stats.frameCount() >= 2);
+        CHECK(stats.widgetsPainted() == 2);
+        CHECK(stats.cellsRepainted() == 200);
+        CHECK(stats.layoutNanoseconds() >= 0);
+        CHECK(stats.paintNanoseconds() >= 0);
+        CHECK(stats.flushNanoseconds() >= 0);
+        CHECK(stats.frameNanoseconds()
+              == stats.layoutNanoseconds() + stats.paintNanoseconds() + stats.flushNanoseconds());
+        const QVector<int> histogram = stats.frameTimeHistogram();
+        CHECK(std::accumulate(histogram.begin(), histogram.end(), 0) == stats.frameCount());
+    }
+
+    terminal.resetRenderStatistics();
+
+    {
+        const Tui::ZTerminal::RenderStatistics stats = terminal.renderStatistics();
+        CHECK(stats.frameCount() == 0);
+        CHECK(stats.frameTimeHistogram() == QVector<int>(11, 0));
+    }
+
+    terminal.forceRepaint();
+    CHECK(terminal.renderStatistics().frameCount() == 1);
+}
+
+TEST_CASE("terminal-frame-interval", "") {
+
+    static char prgname[] = "test";
+    static char *argv[] = {prgname, nullptr};
+    int argc = 1;
+    QCoreApplication app(argc, argv);
+
+    Tui::ZTerminal terminal{Tui::ZTerminal::OffScreen(20, 10)};
+
+    CHECK(terminal.minimumFrameInterval() == 0);
+    CHECK(terminal.adaptiveFrameInterval() == false);
+
+    terminal.setAdaptiveFrameInterval(true);
+    CHECK(terminal.adaptiveFrameInterval() == true);
+    terminal.setAdaptiveFrameInterval(false);
+
+    terminal.setMinimumFrameInterval(-5);
+    CHECK(terminal.minimumFrameInterval() == 0);
+
+    PaintWidget widget;
+    terminal.setMainWidget(&widget);
+    REQUIRE(waitForRenderingCycle(&terminal, 1000));
+
+    terminal.setMinimumFrameInterval(500);
+    CHECK(terminal.minimumFrameInterval() == 500);
+
+    terminal.update();
+    terminal.update();
+    CHECK(!waitForRenderingCycle(&terminal, 100));
+    CHECK(waitForRenderingCycle(&terminal, 2000));
+    CHECK(terminal.renderStatistics().frameCount() == 2);
+
+    // updates caused by input are not delayed
+    terminal.update();
+    CHECK(!waitForRenderingCycle(&terminal, 50));
+    Tui::ZKeyEvent event(Tui::Key_unknown, Tui::NoModifier, QStringLiteral("a"));
+    terminal.dispatchKeyboardEvent(event);
+    widget.update();
+    CHECK(waitForRenderingCycle(&terminal, 100));
+    CHECK(terminal.renderStatistics().frameCount() == 3);
+
+    CHECK(!waitForRenderingCycle(&terminal, 600));
+    CHECK(terminal.renderStatistics().frameCount() == 3);
+}
+
+TEST_CASE("terminal-output-buffer-limit", "") {
+    Tui::ZTerminal terminal{Tui::ZTerminal::OffScreen(20, 10)};
+
+    CHECK(terminal.outputBufferLimit() == 64 * 1024);
+    terminal.setOutputBufferLimit(1024 * 1024);
+    CHECK(terminal.outputBufferLimit() == 1024 * 1024);
+    terminal.setOutputBufferLimit(-1);
+    CHECK(terminal.outputBufferLimit() == 0);
+}
+
 TEST_CASE("terminal-usage-without-widget", "") {
     static char prgname[] = "test";
     static char *argv[] = {prgname, nullptr};
@@ -1222,6 +1356,93 @@ TEST_CASE("terminal-paste-events", "") {
 
 }
 
+TEST_CASE("terminal-paste-chunks", "") {
+    static char prgname[] = "test";
+    static char *argv[] = {prgname, nullptr};
+    int argc = 1;
+    QCoreApplication app(argc, argv);
+
+    EventRecorder recorder;
+
+    Tui::ZTerminal terminal{Tui::ZTerminal::OffScreen(20, 10)};
+
+    SECTION("no widget accepts chunks") {
+        Tui::ZWidget root;
+        terminal.setMainWidget(&root);
+
+        PasteEventAcceptingWidget widget{&root};
+        widget.setFocus();
+
+        auto rootPasteEvent = recorder.watchPasteEvent(&root, "paste event on root");
+        auto widgetPasteEvent = recorder.watchPasteEvent(&widget, "paste event on widget");
+
+        Tui::ZTest::sendPasteChunks(&terminal, {"paste ", "te", "xt"});
+
+        CHECK(recorder.consumeFirst(widgetPasteEvent, QString("paste text")));
+        CHECK(recorder.noMoreEvents());
+    }
+
+    SECTION("parent accepts chunks") {
+        Tui::ZWidget root;
+        terminal.setMainWidget(&root);
+
+        PasteChunkAcceptingWidget parent{&root};
+        Tui::ZWidget child{&parent};
+        child.setFocus();
+
+        auto rootPasteEvent = recorder.watchPasteEvent(&root, "paste event on root");
+        auto parentPasteEvent = recorder.watchPasteEvent(&parent, "paste event on parent");
+        auto childPasteEvent = recorder.watchPasteEvent(&child, "paste event on child");
+
+        Tui::ZTest::sendPasteChunks(&terminal, {"paste ", "te", "xt"});
+
+        REQUIRE(parent.chunks.size() == 3);
+        CHECK(parent.chunks[0].text == "paste ");
+        CHECK(parent.chunks[0].initial == true);
+        CHECK(parent.chunks[0].final == false);
+        CHECK(parent.chunks[1].text == "te");
+        CHECK(parent.chunks[1].initial == false);
+        CHECK(parent.chunks[1].final == false);
+        CHECK(parent.chunks[2].text == "xt");
+        CHECK(parent.chunks[2].initial == false);
+        CHECK(parent.chunks[2].final == true);
+        CHECK(recorder.noMoreEvents());
+
+        parent.chunks.clear();
+        Tui::ZTest::sendPasteChunks(&terminal, {"single"});
+
+        REQUIRE(parent.chunks.size() == 1);
+        CHECK(parent.chunks[0].text == "single");
+        CHECK(parent.chunks[0].initial == true);
+        CHECK(parent.chunks[0].final == true);
+        CHECK(recorder.noMoreEvents());
+    }
+
+    SECTION("grab handler gets complete paste") {
+        Tui::ZWidget root;
+        terminal.setMainWidget(&root);
+
+        PasteChunkAcceptingWidget widget{&root};
+        widget.setFocus();
+
+        auto grabHandlerEvent = recorder.createEvent("grab handler");
+        widget.grabKeyboard([&] (QEvent *ev) {
+            if (ev->type() == Tui::ZEventType::paste()) {
+                auto &event = dynamic_cast<const Tui::ZPasteEvent&>(*ev);
+                recorder.recordEvent(grabHandlerEvent, event.text());
+            } else {
+                FAIL_CHECK("unexpected event");
+            }
+        });
+
+        Tui::ZTest::sendPasteChunks(&terminal, {"paste ", "text"});
+
+        CHECK(recorder.consumeFirst(grabHandlerEvent, QString("paste text")));
+        CHECK(recorder.noMoreEvents());
+        CHECK(widget.chunks.size() == 0);
+    }
+}
+
 TEST_CASE("termial-FileDescriptor", "") {
     Tui::ZTerminal::FileDescriptor fd{23};
     CHECK(fd.fd() == 23);
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Tui/ZTerminal.h>
+#include <Tui/ZTerminal_p.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include <QByteArray>
+#include <QVector>
+#include <QCoreApplication>
+#include <QSocketNotifier>
+
+#include <Tui/ZWidget.h>
+
+#include "../catchwrapper.h"
+
+namespace {
+    // The terminal side is non blocking with a small send buffer, so writes of a few kilobytes already block.
+    struct SocketPair {
+        SocketPair() {
+            REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+            const int size = 4096;
+            setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+            fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        }
+
+        ~SocketPair() {
+            close(fds[0]);
+            close(fds[1]);
+        }
+
+        // Reads everything the terminal side wrote so far without blocking.
+        QByteArray readAvailable() {
+            QByteArray result;
+            char buffer[4096];
+            while (true) {
+                const ssize_t ret = recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (ret > 0) {
+                    result.append(buffer, static_cast<int>(ret));
+                } else if (ret < 0 && errno == EINTR) {
+                    continue;
+                } else {
+                    return result;
+                }
+            }
+        }
+
+        int terminalFd() const {
+            return fds[0];
+        }
+
+        int fds[2];
+    };
+
+    QByteArray testData(int size) {
+        QByteArray data;
+        data.reserve(size);
+        for (int i = 0; i < size; i++) {
+            data.append(static_cast<char>('a' + i % 26));
+        }
+        return data;
+    }
+}
+
+TEST_CASE("terminal-pendingoutput") {
+    static char prgname[] = "test";
+    static char *argv[] = {prgname, nullptr};
+    int argc = 1;
+    QCoreApplication app(argc, argv);
+
+    Tui::ZTerminal terminal(Tui::ZTerminal::OffScreen{80, 24});
+    Tui::ZWidget *root = new Tui::ZWidget();
+    terminal.setMainWidget(root);
+    terminal.forceRepaint();
+
+    auto *const p = Tui::ZTerminalPrivate::get(&terminal);
+
+    SocketPair pair;
+    p->fd_write = pair.terminalFd();
+
+    QByteArray data = testData(1024 * 1024);
+
+    SECTION("partial writes are queued") {
+        p->internalConnection_integration_write_unbuffered(data.data(), data.size());
+        REQUIRE(!p->pendingOutput.isEmpty());
+        REQUIRE(p->outputNotifier);
+        CHECK(p->outputNotifier->isEnabled());
+
+        // Output while the queue is not empty is appended to keep the order.
+        QByteArray tail = QByteArrayLiteral("tail");
+        p->internalConnection_integration_write_unbuffered(tail.data(), tail.size());
+        const QByteArray expected = data + tail;
+
+        QByteArray received = pair.readAvailable();
+        CHECK(received.size() + p->pendingOutput.size() - p->pendingOutputOffset == expected.size());
+
+        int rounds = 0;
+        while (!p->pendingOutput.isEmpty()) {
+            REQUIRE(rounds++ < 100000);
+            p->internalConnection_writePendingOutput();
+            received += pair.readAvailable();
+            CHECK(p->pendingOutputOffset <= p->pendingOutput.size() / 2);
+        }
+        received += pair.readAvailable();
+
+        CHECK(p->pendingOutputOffset == 0);
+        CHECK(!p->outputNotifier->isEnabled());
+        CHECK(received.size() == expected.size());
+        CHECK(received == expected);
+    }
+
+    SECTION("frames are deferred while output is pending") {
+        p->internalConnection_integration_write_unbuffered(data.data(), data.size());
+        REQUIRE(!p->pendingOutput.isEmpty());
+
+        const int framesBefore = terminal.renderStatistics().frameCount();
+        root->update();
+        QCoreApplication::processEvents();
+        CHECK(terminal.renderStatistics().frameCount() == framesBefore);
+        CHECK(p->frameDeferredByOutput);
+        CHECK(p->updateRequested);
+
+        // The deferred frame is painted once the queue is written completely.
+        int rounds = 0;
+        while (!p->pendingOutput.isEmpty()) {
+            REQUIRE(rounds++ < 100000);
+            pair.readAvailable();
+            p->internalConnectionTerminalFdWritable();
+            if (!p->pendingOutput.isEmpty()) {
+                CHECK(terminal.renderStatistics().frameCount() == framesBefore);
+            }
+        }
+        CHECK(terminal.renderStatistics().frameCount() == framesBefore + 1);
+        CHECK(!p->frameDeferredByOutput);
+        CHECK(!p->updateRequested);
+    }
+
+    SECTION("drain") {
+        // Used before the terminal is paused or closed, blocks until the queue is written.
+        p->internalConnection_integration_write_unbuffered(data.data(), data.size());
+        REQUIRE(!p->pendingOutput.isEmpty());
+
+        QByteArray received;
+        std::thread reader([&] {
+            char buffer[4096];
+            while (received.size() < data.size()) {
+                const ssize_t ret = read(pair.fds[1], buffer, sizeof(buffer));
+                if (ret > 0) {
+                    received.append(buffer, static_cast<int>(ret));
+                } else if (!(ret < 0 && errno == EINTR)) {
+                    break;
+                }
+            }
+        });
+        p->internalConnection_drainPendingOutput();
+        reader.join();
+
+        CHECK(p->pendingOutput.isEmpty());
+        CHECK(p->pendingOutputOffset == 0);
+        CHECK(received == data);
+    }
+
+    p->fd_write = -1;
+    p->outputNotifier.reset();
+    delete root;
+}
+
+TEST_CASE("terminal-output-buffer") {
+    static char prgname[] = "test";
+    static char *argv[] = {prgname, nullptr};
+    int argc = 1;
+    QCoreApplication app(argc, argv);
+
+    Tui::ZTerminal terminal(Tui::ZTerminal::OffScreen{80, 24});
+    auto *const p = Tui::ZTerminalPrivate::get(&terminal);
+
+    // A packet socket keeps the boundaries of the writes, so each write is received separately.
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) == 0);
+    p->fd_write = fds[0];
+
+    auto receivedWrites = [&] {
+        QVector<int> sizes;
+        char buffer[65536];
+        while (true) {
+            const ssize_t ret = recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (ret > 0) {
+                sizes.append(static_cast<int>(ret));
+            } else if (ret < 0 && errno == EINTR) {
+                continue;
+            } else {
+                return sizes;
+            }
+        }
+    };
+
+    terminal.setOutputBufferLimit(1000);
+    const QByteArray data = testData(100);
+
+    SECTION("frame below the limit is written at flush") {
+        for (int i = 0; i < 9; i++) {
+            p->internalConnection_integration_write(data.constData(), data.size());
+        }
+        CHECK(receivedWrites().isEmpty());
+        p->internalConnection_integration_flush();
+        CHECK(receivedWrites() == QVector<int>{900});
+    }
+
+    SECTION("exceeding the limit writes early") {
+        for (int i = 0; i < 15; i++) {
+            p->internalConnection_integration_write(data.constData(), data.size());
+        }
+        CHECK(receivedWrites() == QVector<int>{1100});
+        p->internalConnection_integration_flush();
+        CHECK(receivedWrites() == QVector<int>{400});
+    }
+
+    SECTION("empty flush writes nothing") {
+        p->internalConnection_integration_flush();
+        CHECK(receivedWrites().isEmpty());
+        p->internalConnection_integration_write(data.constData(), data.size());
+        p->internalConnection_integration_flush();
+        p->internalConnection_integration_flush();
+        CHECK(receivedWrites() == QVector<int>{100});
+    }
+
+    CHECK(p->pendingOutput.isEmpty());
+    p->fd_write = -1;
+    close(fds[0]);
+    close(fds[1]);
+}
+
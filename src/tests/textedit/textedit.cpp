@@ -14,6 +14,7 @@
 #include <Tui/ZClipboard.h>
 #include <Tui/ZCommandManager.h>
 #include <Tui/ZPalette.h>
+#include <Tui/ZTest.h>
 
 static void loadText(Tui::ZTextEdit *textedit, const QString &text) {
     QByteArray x = text.toUtf8();
@@ -1525,6 +1526,27 @@ TEST_CASE("textedit-behavior", "") {
         CHECK(te->document()->line(1) == QString("liXe two"));
     }
 
+    SECTION("Paste Event - chunked") {
+        loadText(te, "line one\nline two\nline three");
+        CHECK(te->isChunkedPasteEnabled() == false);
+        te->setChunkedPasteEnabled(true);
+        CHECK(te->isChunkedPasteEnabled() == true);
+        te->setFocus();
+        te->setCursorPosition({2, 1});
+        Tui::ZTest::sendPasteChunks(t.terminal.get(), {"X\r", "\nY", "Z\r", "W"});
+        CHECK(te->anchorPosition() == Tui::ZTextEdit::Position{1, 3});
+        CHECK(te->cursorPosition() == Tui::ZTextEdit::Position{1, 3});
+        REQUIRE(te->document()->lineCount() == 5);
+        CHECK(te->document()->line(1) == QString("liX"));
+        CHECK(te->document()->line(2) == QString("YZ"));
+        CHECK(te->document()->line(3) == QString("Wne two"));
+
+        // The whole paste is one undo step
+        te->undo();
+        CHECK(te->cursorPosition() == Tui::ZTextEdit::Position{2, 1});
+        CHECK(getText(te) == "line one\nline two\nline three");
+    }
+
     SECTION("Key Ctrl+c - no selection") {
         // readOnly does not apply to copy operations.
         te->setReadOnly(GENERATE(false, true));
@@ -2695,6 +2717,171 @@ TEST_CASE("textedit-scroll", "") {
 }
 
 
+namespace {
+    class PasteRecordingTextEdit : public Tui::ZTextEdit {
+    public:
+        using Tui::ZTextEdit::ZTextEdit;
+
+    protected:
+        void pasteEvent(Tui::ZPasteEvent *event) override {
+            pastes.append(event->text());
+        }
+
+    public:
+        QStringList pastes;
+    };
+}
+
+TEST_CASE("textedit-paste-override", "") {
+
+    Testhelper t("textedit", "unused", 20, 10);
+
+    t.root->setGeometry({0, 0, 20, 10});
+    PasteRecordingTextEdit *te = new PasteRecordingTextEdit(t.terminal->textMetrics(), t.root);
+    te->setGeometry({0, 0, 20, 10});
+    te->setFocus();
+
+    SECTION("default") {
+        // Without opting in to chunked pastes the reimplemented pasteEvent gets the complete paste.
+        Tui::ZTest::sendPasteChunks(t.terminal.get(), {"X\r", "\nY", "Z"});
+        CHECK(te->pastes == QStringList{"X\r\nYZ"});
+        CHECK(docToVec(te->document()) == QVector<QString>{""});
+    }
+
+    SECTION("chunked") {
+        te->setChunkedPasteEnabled(true);
+        Tui::ZTest::sendPasteChunks(t.terminal.get(), {"X\r", "\nY", "Z"});
+        CHECK(te->pastes == QStringList{});
+        CHECK(docToVec(te->document()) == QVector<QString>{"X", "YZ"});
+    }
+}
+
+TEST_CASE("textedit-paste-chunked-interrupted", "") {
+
+    Testhelper t("textedit", "unused", 20, 10);
+
+    t.root->setGeometry({0, 0, 20, 10});
+    Tui::ZTextEdit *te = new Tui::ZTextEdit(t.terminal->textMetrics(), t.root);
+    te->setGeometry({0, 0, 20, 5});
+    te->setChunkedPasteEnabled(true);
+    te->setFocus();
+
+    auto sendChunk = [&](const QString &text, bool initial, bool final) {
+        Tui::ZPasteEvent event{Tui::ZPasteEvent::chunk, text, initial, final};
+        QCoreApplication::sendEvent(te, &event);
+    };
+
+    // A paste whose final chunk never arrives must not swallow later edits into its undo step.
+    sendChunk("abc", true, false);
+
+    SECTION("key") {
+        t.sendChar("x");
+        CHECK(docToVec(te->document()) == QVector<QString>{"abcx"});
+        te->undo();
+        CHECK(docToVec(te->document()) == QVector<QString>{"abc"});
+    }
+
+    SECTION("pending-carriage-return") {
+        sendChunk("d\r", false, false);
+        t.sendChar("x");
+        CHECK(docToVec(te->document()) == QVector<QString>{"abcd", "x"});
+        te->undo();
+        CHECK(docToVec(te->document()) == QVector<QString>{"abcd", ""});
+    }
+
+    SECTION("new-initial-chunk") {
+        sendChunk("def", true, true);
+        CHECK(docToVec(te->document()) == QVector<QString>{"abcdef"});
+        te->undo();
+        CHECK(docToVec(te->document()) == QVector<QString>{"abc"});
+    }
+
+    SECTION("focus-loss") {
+        Tui::ZWidget *other = new Tui::ZWidget(t.root);
+        other->setGeometry({0, 5, 20, 5});
+        other->setFocusPolicy(Tui::StrongFocus);
+        other->setFocus();
+        te->setFocus();
+        t.sendChar("x");
+        CHECK(docToVec(te->document()) == QVector<QString>{"abcx"});
+        te->undo();
+        CHECK(docToVec(te->document()) == QVector<QString>{"abc"});
+    }
+
+    SECTION("set-text-cursor") {
+        Tui::ZDocumentCursor cursor = te->makeCursor();
+        cursor.setPosition({1, 0});
+        te->setTextCursor(cursor);
+        t.sendChar("x");
+        CHECK(docToVec(te->document()) == QVector<QString>{"axbc"});
+        te->undo();
+        CHECK(docToVec(te->document()) == QVector<QString>{"abc"});
+    }
+
+    te->undo();
+    CHECK(docToVec(te->document()) == QVector<QString>{""});
+}
+
+namespace {
+    class LayoutExposingTextEdit : public Tui::ZTextEdit {
+    public:
+        using Tui::ZTextEdit::ZTextEdit;
+        using Tui::ZTextEdit::textLayoutForLine;
+        using Tui::ZTextEdit::textLayoutForLineWithoutWrapping;
+        using Tui::ZTextEdit::textOption;
+    };
+}
+
+TEST_CASE("textedit-layout-cache", "") {
+
+    Testhelper t("textedit", "unused", 20, 10);
+
+    t.root->setGeometry({0, 0, 20, 10});
+    LayoutExposingTextEdit *te = new LayoutExposingTextEdit(t.terminal->textMetrics(), t.root);
+    te->setGeometry({0, 0, 20, 10});
+
+    auto checkLayouts = [&] {
+        for (int line = 0; line < te->document()->lineCount(); line++) {
+            CAPTURE(line);
+            CHECK(te->textLayoutForLine(te->textOption(), line).text() == te->document()->line(line));
+            CHECK(te->textLayoutForLineWithoutWrapping(line).text() == te->document()->line(line));
+        }
+    };
+
+    te->setText("abc\ndef");
+    checkLayouts();
+
+    SECTION("split-line") {
+        te->setCursorPosition({0, 0});
+        te->insertText("\n");
+        checkLayouts();
+        te->setCursorPosition({1, 1});
+        te->insertText("\n");
+        checkLayouts();
+    }
+
+    SECTION("undo-redo") {
+        te->setCursorPosition({3, 0});
+        te->insertText("xyz\n");
+        checkLayouts();
+        te->undo();
+        checkLayouts();
+        te->redo();
+        checkLayouts();
+    }
+
+    SECTION("wrap-mode") {
+        te->setText("word word word word word word word");
+        te->setWordWrapMode(Tui::ZTextOption::WrapAnywhere);
+        CHECK(te->textLayoutForLine(te->textOption(), 0).lineCount() == 2);
+        te->setWordWrapMode(Tui::ZTextOption::NoWrap);
+        CHECK(te->textLayoutForLine(te->textOption(), 0).lineCount() == 1);
+        te->setWordWrapMode(Tui::ZTextOption::WrapAnywhere);
+        te->setGeometry({0, 0, 10, 10});
+        CHECK(te->textLayoutForLine(te->textOption(), 0).lineCount() == 4);
+    }
+}
+
 TEST_CASE("textedit-visual", "") {
 
     Testhelper t("textedit", "visual", 20, 10);
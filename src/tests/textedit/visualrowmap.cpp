@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "../catchwrapper.h"
+
+#include <random>
+
+#include "Tui/ZTextEditVisualRowMap_p.h"
+
+TEST_CASE("visualrowmap-basic") {
+    Tui::VisualRowMap map;
+    CHECK(map.lineCount() == 0);
+    CHECK(map.totalRows() == 0);
+    CHECK(map.lineForRow(0) == 0);
+
+    map.replace(0, 0, {1, 3, 2});
+    CHECK(map.lineCount() == 3);
+    CHECK(map.totalRows() == 6);
+    CHECK(map.rowsBefore(0) == 0);
+    CHECK(map.rowsBefore(1) == 1);
+    CHECK(map.rowsBefore(2) == 4);
+    CHECK(map.rowsBefore(3) == 6);
+
+    CHECK(map.lineForRow(0) == 0);
+    CHECK(map.lineForRow(1) == 1);
+    CHECK(map.lineForRow(3) == 1);
+    CHECK(map.lineForRow(4) == 2);
+    CHECK(map.lineForRow(5) == 2);
+    CHECK(map.lineForRow(6) == 2);
+    CHECK(map.lineForRow(100) == 2);
+
+    map.setRows(1, 1);
+    CHECK(map.totalRows() == 4);
+    CHECK(map.lineForRow(2) == 2);
+
+    map.replace(1, 1, {5, 5});
+    CHECK(map.lineCount() == 4);
+    CHECK(map.rows(1) == 5);
+    CHECK(map.rows(3) == 2);
+    CHECK(map.totalRows() == 13);
+
+    CHECK(map.isExact(1) == false);
+    map.setRows(1, 4, true);
+    CHECK(map.isExact(1) == true);
+    CHECK(map.isExact(2) == false);
+    CHECK(map.totalRows() == 12);
+
+    map.clear();
+    CHECK(map.lineCount() == 0);
+}
+
+TEST_CASE("visualrowmap-empty-lines") {
+    Tui::VisualRowMap map;
+    map.replace(0, 0, {1, 0, 0, 2});
+    CHECK(map.lineForRow(0) == 0);
+    CHECK(map.lineForRow(1) == 3);
+    CHECK(map.lineForRow(2) == 3);
+}
+
+TEST_CASE("visualrowmap-random") {
+    // Large replacements give the tree several levels and exercise splitting and merging of nodes.
+    const bool large = GENERATE(false, true);
+    CAPTURE(large);
+    std::mt19937 rng(42);
+    Tui::VisualRowMap map;
+    QVector<int> reference;
+    QVector<bool> referenceExact;
+
+    for (int op = 0; op < (large ? 300 : 2000); op++) {
+        if (rng() % 4 == 0 || reference.isEmpty()) {
+            const int maxRange = large ? 3000 : 5;
+            const int start = rng() % (reference.size() + 1);
+            const int removed = rng() % (std::min(reference.size() - start, maxRange) + 1);
+            QVector<int> rows;
+            const int inserted = rng() % maxRange;
+            for (int i = 0; i < inserted; i++) {
+                rows.append(1 + rng() % 4);
+            }
+            map.replace(start, removed, rows);
+            reference.remove(start, removed);
+            referenceExact.remove(start, removed);
+            for (int i = 0; i < rows.size(); i++) {
+                reference.insert(start + i, rows[i]);
+                referenceExact.insert(start + i, false);
+            }
+        } else {
+            const int line = rng() % reference.size();
+            const int rows = 1 + rng() % 4;
+            const bool exact = rng() % 2;
+            map.setRows(line, rows, exact);
+            reference[line] = rows;
+            referenceExact[line] = exact;
+        }
+
+        map.debugConsistencyCheck();
+        REQUIRE(map.lineCount() == reference.size());
+        int sum = 0;
+        for (int line = 0; line < reference.size(); line++) {
+            CAPTURE(line);
+            REQUIRE(map.rows(line) == reference[line]);
+            REQUIRE(map.isExact(line) == referenceExact[line]);
+            REQUIRE(map.rowsBefore(line) == sum);
+            for (int row = sum; row < sum + reference[line]; row++) {
+                REQUIRE(map.lineForRow(row) == line);
+            }
+            sum += reference[line];
+        }
+        REQUIRE(map.totalRows() == sum);
+    }
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Tui/ZTextLayout.h>
+#include <Tui/ZTextLayout_p.h>
+#include <Tui/ZTextMetrics_p.h>
+#include <Tui/ZTextOption.h>
+
+#include <random>
+
+#include <QStringList>
+
+#include "../catchwrapper.h"
+
+#include "../termpaint_helpers.h"
+
+TEST_CASE("textlayout-relayout-incremental") {
+    TermpaintFixture f;
+    Tui::ZTextMetrics tm = Tui::ZTextMetricsPrivate::createForTesting(f.surface);
+
+    Tui::ZTextOption option;
+    option.setWrapMode(Tui::ZTextOption::WordWrap);
+
+    QString text;
+    for (int i = 0; i < 200; i++) {
+        text += QStringLiteral("word ");
+    }
+
+    Tui::ZTextLayout layout(tm, text);
+    auto *const p = Tui::ZTextLayoutPrivate::get(&layout);
+    Tui::ZTextLayoutPrivate::TestingCounters counters;
+    p->testingCounters = &counters;
+    layout.setTextOption(option);
+    layout.doLayout(20);
+    CHECK(counters.incrementalRelayouts == 0);
+    CHECK(counters.lineBreakAnalyses == 1);
+
+    SECTION("typing") {
+        // Typing in the text like ZTextEdit does it, including setting the unchanged text option.
+        for (int i = 0; i < 3; i++) {
+            text.insert(500 + i, QStringLiteral("x"));
+            layout.setTextOption(option);
+            layout.setText(text);
+            layout.relayout(20, 500 + i, 0, 1);
+            CHECK(counters.incrementalRelayouts == i + 1);
+            CHECK(counters.lineBreakAnalyses == 1);
+        }
+    }
+
+    SECTION("color mapper") {
+        option.setTrailingWhitespaceColor([](const Tui::ZTextStyle &base, const Tui::ZTextStyle&,
+                                             const Tui::ZFormatRange*) {
+            return base;
+        });
+        layout.setTextOption(option);
+        text.insert(500, QStringLiteral("x"));
+        layout.setText(text);
+        layout.relayout(20, 500, 0, 1);
+        CHECK(counters.incrementalRelayouts == 1);
+        CHECK(counters.lineBreakAnalyses == 1);
+    }
+
+    SECTION("changed text option") {
+        option.setWrapMode(Tui::ZTextOption::WrapAnywhere);
+        layout.setTextOption(option);
+        text.insert(500, QStringLiteral("x"));
+        layout.setText(text);
+        layout.relayout(20, 500, 0, 1);
+        CHECK(counters.incrementalRelayouts == 0);
+    }
+}
+
+TEST_CASE("textlayout-relayout-linebreaks") {
+    TermpaintFixture f;
+    Tui::ZTextMetrics tm = Tui::ZTextMetricsPrivate::createForTesting(f.surface);
+
+    Tui::ZTextOption option;
+    option.setWrapMode(Tui::ZTextOption::WordWrap);
+
+    const QStringList pieces = {"a", "word", " ", "    ", "\t", "\n", "-", "(", ")", "\"", "1", "2.5", "$",
+                                "\u306F", "\u3002", "\u0308", "\u00A0", "\u200B", "\U0001F60E",
+                                "\U0001F1E9\U0001F1EA", "\U0001F1E9", QString(20, 'x'), QString(40, ' ')};
+
+    std::mt19937 rng(42);
+    auto randomText = [&] {
+        QString text;
+        const int count = rng() % 8;
+        for (int i = 0; i < count; i++) {
+            text += pieces[rng() % pieces.size()];
+        }
+        return text;
+    };
+
+    QString text;
+    for (int i = 0; i < 60; i++) {
+        text += randomText();
+    }
+
+    Tui::ZTextLayout layout(tm, text);
+    auto *const p = Tui::ZTextLayoutPrivate::get(&layout);
+    Tui::ZTextLayoutPrivate::TestingCounters counters;
+    p->testingCounters = &counters;
+    layout.setTextOption(option);
+    layout.doLayout(10);
+
+    for (int step = 0; step < 500; step++) {
+        const int position = rng() % (text.size() + 1);
+        const int charsRemoved = rng() % (std::min(text.size() - position, 10) + 1);
+        const QString inserted = randomText();
+        text.replace(position, charsRemoved, inserted);
+        CAPTURE(step);
+        CAPTURE(position);
+        CAPTURE(charsRemoved);
+        CAPTURE(inserted.toStdString());
+
+        layout.setText(text);
+        layout.relayout(10, position, charsRemoved, inserted.size());
+        REQUIRE(counters.incrementalRelayouts == step + 1);
+
+        Tui::ZTextLayout reference(tm, text);
+        reference.setTextOption(option);
+        reference.doLayout(10);
+        auto *const referenceP = Tui::ZTextLayoutPrivate::get(&reference);
+
+        if (p->lineBreaksValid && referenceP->lineBreaksValid) {
+            CHECK(p->lineBreaks == referenceP->lineBreaks);
+        }
+    }
+    CHECK(counters.lineBreakAnalyses == 1);
+}
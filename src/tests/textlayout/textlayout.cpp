@@ -4,6 +4,8 @@
 #include <Tui/ZTextOption.h>
 #include <Tui/ZFormatRange.h>
 
+#include <random>
+
 #include <QTextBoundaryFinder>
 
 #include <Tui/ZWidget.h>
@@ -951,6 +953,20 @@ TEST_CASE("textlayout", "") {
         t.compare(zi);
     }
 
+    SECTION("ascii-followed-by-combining") {
+        // The last ascii character before a combining mark must stay in the same cluster as the mark.
+        layout->setText("abcdefghij" "\xcc\x88" "klm");
+        layout->doLayout(10);
+        CHECK(layout->lineCount() == 2);
+        CHECK(layout->lineAt(0).textLength() == 11);
+        CHECK(layout->lineAt(0).width() == 10);
+        CHECK(layout->lineAt(1).textStart() == 11);
+        CHECK(layout->lineAt(1).width() == 3);
+        CHECK(layout->isValidCursorPosition(9) == true);
+        CHECK(layout->isValidCursorPosition(10) == false);
+        CHECK(layout->isValidCursorPosition(11) == true);
+    }
+
     SECTION("special-combining-grapheme-joiner") {
         // Check that a zero width character in the special chars list is also detected after a non-zero width character
         layout->setText("a\u034f");
@@ -1992,3 +2008,72 @@ TEST_CASE("textlayout", "") {
     }
 
 }
+
+TEST_CASE("textlayout-relayout", "") {
+    Testhelper t("textlayout", "textlayout-relayout", 32, 5);
+
+    auto wrapMode = GENERATE(Tui::ZTextOption::NoWrap, Tui::ZTextOption::WrapAnywhere, Tui::ZTextOption::WordWrap);
+    CAPTURE(wrapMode);
+    const int width = GENERATE(1, 7, 20);
+    CAPTURE(width);
+
+    Tui::ZTextOption option;
+    option.setWrapMode(wrapMode);
+
+    const QStringList pieces = {"a", "b", "word", " ", "  ", "\t", "\n", "-", "\u306F", "\u0308", "\U0001F60E",
+                                QString(20, 'x')};
+
+    std::mt19937 rng(42);
+    auto randomText = [&] {
+        QString text;
+        const int count = rng() % 8;
+        for (int i = 0; i < count; i++) {
+            text += pieces[rng() % pieces.size()];
+        }
+        return text;
+    };
+
+    QString text;
+    for (int i = 0; i < 20; i++) {
+        text += randomText();
+    }
+
+    Tui::ZTextLayout layout(t.terminal->textMetrics(), text);
+    layout.setTextOption(option);
+    layout.doLayout(width);
+
+    for (int step = 0; step < 200; step++) {
+        const int position = rng() % (text.size() + 1);
+        const int charsRemoved = rng() % (std::min(text.size() - position, 10) + 1);
+        const QString inserted = randomText();
+        text.replace(position, charsRemoved, inserted);
+        CAPTURE(step);
+        CAPTURE(position);
+        CAPTURE(charsRemoved);
+        CAPTURE(inserted.toStdString());
+
+        layout.setText(text);
+        layout.relayout(width, position, charsRemoved, inserted.size());
+
+        Tui::ZTextLayout reference(t.terminal->textMetrics(), text);
+        reference.setTextOption(option);
+        reference.doLayout(width);
+
+        REQUIRE(layout.lineCount() == reference.lineCount());
+        for (int i = 0; i < reference.lineCount(); i++) {
+            CAPTURE(i);
+            CHECK(layout.lineAt(i).textStart() == reference.lineAt(i).textStart());
+            CHECK(layout.lineAt(i).textLength() == reference.lineAt(i).textLength());
+            CHECK(layout.lineAt(i).width() == reference.lineAt(i).width());
+            CHECK(layout.lineAt(i).position() == reference.lineAt(i).position());
+        }
+        for (int pos = 0; pos <= text.size(); pos++) {
+            CAPTURE(pos);
+            REQUIRE(layout.isValidCursorPosition(pos) == reference.isValidCursorPosition(pos));
+            if (reference.isValidCursorPosition(pos)) {
+                REQUIRE(layout.lineForTextPosition(pos).cursorToX(pos, Tui::ZTextLayout::Leading)
+                        == reference.lineForTextPosition(pos).cursorToX(pos, Tui::ZTextLayout::Leading));
+            }
+        }
+    }
+}
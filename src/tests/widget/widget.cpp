@@ -1863,6 +1863,34 @@ TEST_CASE("widget-palette") {
         CHECK(Tui::ZPalette::getColor(&inner2, "dummy") == cyan);
     }
 
+    SECTION("reparent") {
+        Tui::ZWidget outer2;
+
+        Tui::ZPalette pal;
+        pal.setColors({{"dummy", blue}});
+        outer.setPalette(pal);
+
+        Tui::ZPalette pal2;
+        pal2.setColors({{"dummy", green}});
+        outer2.setPalette(pal2);
+
+        CHECK(inner2.getColor("dummy") == blue);
+        CHECK(Tui::ZPalette::getColor(&inner2, "dummy") == blue);
+
+        inner.setParent(&outer2);
+
+        CHECK(inner.getColor("dummy") == green);
+        CHECK(inner2.getColor("dummy") == green);
+        CHECK(Tui::ZPalette::getColor(&inner2, "dummy") == green);
+
+        outer2.setPalette(pal);
+
+        CHECK(inner.getColor("dummy") == blue);
+        CHECK(inner2.getColor("dummy") == blue);
+
+        inner.setParent(&outer);
+    }
+
 }
 
 TEST_CASE("widget-event-methods") {
@@ -2730,6 +2758,124 @@ TEST_CASE("widget-painting") {
 
 }
 
+TEST_CASE("widget-painting-partial-update") {
+    Testhelper t("unused", "unused", 80, 25);
+    TestWidget root;
+
+    EventRecorder recorder;
+
+    t.terminal->setMainWidget(&root);
+
+    TestWidget w1{&root};
+    w1.setGeometry({2, 3, 4, 2});
+    TestWidget w2{&root};
+    w2.setGeometry({2, 7, 4, 2});
+    TestWidget childOfW2{&w2};
+    childOfW2.setGeometry({0, 0, 1, 1});
+
+    root.paint = [&](Tui::ZPaintEvent *event) {
+        Tui::ZPainter painter = *event->painter();
+        painter.clearWithChar(Tui::Colors::brown, Tui::Colors::green, 'x');
+    };
+    w2.paint = [&](Tui::ZPaintEvent *event) {
+        Tui::ZPainter painter = *event->painter();
+        painter.setForeground(0, 0, Tui::ZColor::fromTerminalColorIndexed(54));
+    };
+
+    t.render();
+    // process update requests from setup
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+
+    RecorderEvent rootPaint = recorder.createEvent("root paint");
+    root.paint = [&](Tui::ZPaintEvent *event) {
+        Tui::ZPainter painter = *event->painter();
+        painter.clearWithChar(Tui::Colors::brown, Tui::Colors::green, 'x');
+        recorder.recordEvent(rootPaint);
+    };
+
+    RecorderEvent w1Paint = recorder.createEvent("w1 paint");
+    w1.paint = [&](Tui::ZPaintEvent *event) {
+        (void)event;
+        recorder.recordEvent(w1Paint);
+    };
+
+    RecorderEvent w2Paint = recorder.createEvent("w2 paint");
+    w2.paint = [&](Tui::ZPaintEvent *event) {
+        (void)event;
+        recorder.recordEvent(w2Paint);
+    };
+
+    RecorderEvent childOfW2Paint = recorder.createEvent("childOfW2 paint");
+    childOfW2.paint = [&](Tui::ZPaintEvent *event) {
+        (void)event;
+        recorder.recordEvent(childOfW2Paint);
+    };
+
+    w1.update();
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    CHECK(recorder.consumeFirst(rootPaint));
+    CHECK(recorder.consumeFirst(w1Paint));
+    CHECK(recorder.noMoreEvents());
+
+    // not damaged area keeps contents from the last paint
+    Tui::ZImage img = t.terminal->grabCurrentImage();
+    CHECK(img.peekForground(2, 7) == Tui::ZColor::fromTerminalColorIndexed(54));
+
+    childOfW2.update();
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    CHECK(recorder.consumeFirst(rootPaint));
+    CHECK(recorder.consumeFirst(w2Paint));
+    CHECK(recorder.consumeFirst(childOfW2Paint));
+    CHECK(recorder.noMoreEvents());
+
+    t.terminal->update();
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    CHECK(recorder.consumeFirst(rootPaint));
+    CHECK(recorder.consumeFirst(w1Paint));
+    CHECK(recorder.consumeFirst(w2Paint));
+    CHECK(recorder.consumeFirst(childOfW2Paint));
+    CHECK(recorder.noMoreEvents());
+}
+
+TEST_CASE("widget-setgeometry-unchanged-no-damage") {
+    Testhelper t("unused", "unused", 80, 25);
+    TestWidget root;
+
+    EventRecorder recorder;
+
+    t.terminal->setMainWidget(&root);
+
+    TestWidget w1{&root};
+    w1.setGeometry({2, 3, 4, 2});
+
+    t.render();
+    // process update requests from setup
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+
+    RecorderEvent rootPaint = recorder.createEvent("root paint");
+    root.paint = [&](Tui::ZPaintEvent *event) {
+        (void)event;
+        recorder.recordEvent(rootPaint);
+    };
+
+    RecorderEvent w1Paint = recorder.createEvent("w1 paint");
+    w1.paint = [&](Tui::ZPaintEvent *event) {
+        (void)event;
+        recorder.recordEvent(w1Paint);
+    };
+
+    // Layouts set the geometry of all their items on each layout pass, unchanged widgets must not cause a repaint.
+    w1.setGeometry({2, 3, 4, 2});
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    CHECK(recorder.noMoreEvents());
+
+    w1.setGeometry({2, 3, 5, 2});
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    CHECK(recorder.consumeFirst(rootPaint));
+    CHECK(recorder.consumeFirst(w1Paint));
+    CHECK(recorder.noMoreEvents());
+}
+
 TEST_CASE("widget-sizes") {
     TestWidgetHints widget;
 